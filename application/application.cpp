@@ -397,12 +397,16 @@ void setupWorld(int argc, const char** args) {
 }
 
 void setupPhysics() {
-	physicsThread = TickerThread(TICKS_PER_SECOND, TICK_SKIP_TIME, [] () {
+	physicsThread = TickerThread(TICKS_PER_SECOND, TICK_SKIP_TIME, [] (double stepScale) {
 		physicsMeasure.mark(PhysicsProcess::OTHER);
 
+		// a tick covering several tick intervals advances the world by as many steps of deltaT
+		double baseDeltaT = world.deltaT;
+		world.deltaT = baseDeltaT * stepScale;
 		Graphics::AppDebug::logTickStart();
 		world.tick();
 		Graphics::AppDebug::logTickEnd();
+		world.deltaT = baseDeltaT;
 
 		physicsMeasure.end();
 
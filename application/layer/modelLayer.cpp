@@ -6,6 +6,7 @@
 #include "shader/shaders.h"
 #include "extendedPart.h"
 #include "worlds.h"
+#include "application.h"
 
 #include "ecs/light.h"
 #include "ecs/material.h"
@@ -46,21 +47,21 @@ enum class RelationToSelectedPart {
 	MAINPHYSICAL_ATTACH
 };
 
-static RelationToSelectedPart getRelationToSelectedPart(const Part* selectedPart, const Part* testPart) {
+static RelationToSelectedPart getRelationToSelectedPart(const Part* selectedPart, const PartSnapshot<ExtendedPart>& testPart) {
 	if (selectedPart == nullptr)
 		return RelationToSelectedPart::NONE;
 
-	if (testPart == selectedPart)
+	if (testPart.partId == selectedPart)
 		return RelationToSelectedPart::SELF;
 
-	if (selectedPart->parent != nullptr && testPart->parent != nullptr) {
-		if (testPart->parent == selectedPart->parent) {
-			if (testPart->isMainPart())
+	if (selectedPart->parent != nullptr && testPart.parentId != nullptr) {
+		if (testPart.parentId == selectedPart->parent) {
+			if (testPart.isMainPart)
 				return RelationToSelectedPart::MAINPART;
 			else
 				return RelationToSelectedPart::DIRECT_ATTACH;
-		} else if (testPart->parent->mainPhysical == selectedPart->parent->mainPhysical) {
-			if (testPart->parent->isMainPhysical())
+		} else if (testPart.mainPhysicalId == selectedPart->parent->mainPhysical) {
+			if (testPart.isMainPhysical)
 				return RelationToSelectedPart::MAINPHYSICAL_ATTACH;
 			else
 				return RelationToSelectedPart::PHYSICAL_ATTACH;
@@ -70,7 +71,7 @@ static RelationToSelectedPart getRelationToSelectedPart(const Part* selectedPart
 	return RelationToSelectedPart::NONE;
 }
 
-static Color getAmbientForPartForSelected(Screen* screen, Part* part) {
+static Color getAmbientForPartForSelected(Screen* screen, const PartSnapshot<ExtendedPart>& part) {
 	switch (getRelationToSelectedPart(screen->selectedPart, part)) {
 		case RelationToSelectedPart::NONE:
 			return Color(0.0f, 0, 0, 0);
@@ -89,9 +90,9 @@ static Color getAmbientForPartForSelected(Screen* screen, Part* part) {
 	return Color(0, 0, 0, 0);
 }
 
-static Color getAlbedoForPart(Screen* screen, Part* part) {
+static Color getAlbedoForPart(Screen* screen, const PartSnapshot<ExtendedPart>& part) {
 	Color computedAmbient = getAmbientForPartForSelected(screen, part);
-	if (part == screen->intersectedPart)
+	if (part.partId == screen->intersectedPart)
 		computedAmbient += Vec4f(-0.1f, -0.1f, -0.1f, 0);
 
 	return computedAmbient;
@@ -152,21 +153,24 @@ void ModelLayer::onRender() {
 	// Filter on mesh ID and transparency
 	size_t maxMeshCount = 0;
 	std::map<int, size_t> meshCounter;
-	std::multimap<int, ExtendedPart*> visibleParts;
-	std::map<double, ExtendedPart*> transparentParts;
+	std::multimap<int, const PartSnapshot<ExtendedPart>*> visibleParts;
+	std::map<double, const PartSnapshot<ExtendedPart>*> transparentParts;
 	graphicsMeasure.mark(GraphicsProcess::PHYSICALS);
-	screen->world->syncReadOnlyOperation([this, &visibleParts, &transparentParts, &meshCounter, &maxMeshCount, screen] () {
+	auto renderSnapshot = [this, &visibleParts, &transparentParts, &meshCounter, &maxMeshCount, screen] (const WorldSnapshot<ExtendedPart>& snapshot) {
 		VisibilityFilter filter = VisibilityFilter::forWindow(screen->camera.cframe.position, screen->camera.getForwardDirection(), screen->camera.getUpDirection(), screen->camera.fov, screen->camera.aspect, screen->camera.zfar);
 		//for (ExtendedPart& part : screen->world->iterPartsFiltered(filter, ALL_PARTS)) {
-		for (ExtendedPart& part : screen->world->iterParts(ALL_PARTS)) {
-			if (part.material.albedo.w < 1) {
-				transparentParts.insert({ lengthSquared(Vec3(screen->camera.cframe.position - part.getPosition())), &part });
+		const PartSnapshot<ExtendedPart>* selectedPartSnapshot = nullptr;
+		for (const PartSnapshot<ExtendedPart>& partSnapshot : snapshot.parts) {
+			const PartSnapshotVisuals<ExtendedPart>& visuals = partSnapshot.visuals;
+			if (partSnapshot.partId == screen->selectedPart) selectedPartSnapshot = &partSnapshot;
+			if (visuals.material.albedo.w < 1) {
+				transparentParts.insert({ lengthSquared(Vec3(screen->camera.cframe.position - partSnapshot.cframe.getPosition())), &partSnapshot });
 			} else {
-				visibleParts.insert({ part.visualData.drawMeshId, &part });
-				maxMeshCount = fmax(maxMeshCount, meshCounter[part.visualData.drawMeshId]++);
+				visibleParts.insert({ visuals.drawMeshId, &partSnapshot });
+				maxMeshCount = fmax(maxMeshCount, meshCounter[visuals.drawMeshId]++);
 				;
-				if (meshCounter[part.visualData.drawMeshId] > maxMeshCount)
-					maxMeshCount = meshCounter[part.visualData.drawMeshId];
+				if (meshCounter[visuals.drawMeshId] > maxMeshCount)
+					maxMeshCount = meshCounter[visuals.drawMeshId];
 			}
 		}
 
@@ -187,18 +191,18 @@ void ModelLayer::onRender() {
 			int offset = 0;
 			auto meshes = visibleParts.equal_range(meshID);
 			for (auto mesh = meshes.first; mesh != meshes.second; ++mesh) {
-				ExtendedPart* part = mesh->second;
-				Material material = part->material;
+				const PartSnapshot<ExtendedPart>& part = *mesh->second;
+				Material material = part.visuals.material;
 				material.albedo += getAlbedoForPart(screen, part);
 
-				Mat4f modelMatrix = part->getCFrame().asMat4WithPreScale(part->hitbox.scale);
+				Mat4f modelMatrix = part.cframe.asMat4WithPreScale(part.scale);
 
 				uniforms[offset] = Uniform {
 					modelMatrix,
-					part->material.albedo,
-					part->material.metalness,
-					part->material.roughness,
-					part->material.ao
+					part.visuals.material.albedo,
+					part.visuals.material.metalness,
+					part.visuals.material.roughness,
+					part.visuals.material.ao
 				};
 
 				offset++;
@@ -212,24 +216,31 @@ void ModelLayer::onRender() {
 		Shaders::basicShader.bind();
 		Renderer::enableBlending();
 		for (auto iterator = transparentParts.rbegin(); iterator != transparentParts.rend(); ++iterator) {
-			ExtendedPart* part = (*iterator).second;
+			const PartSnapshot<ExtendedPart>& part = *(*iterator).second;
 
-			Material material = part->material;
+			Material material = part.visuals.material;
 			material.albedo += getAlbedoForPart(screen, part);
 
-			if (part->visualData.drawMeshId == -1)
+			if (part.visuals.drawMeshId == -1)
 				continue;
 
 			Shaders::basicShader.updateMaterial(material);
-			Shaders::basicShader.updatePart(*part);
-			Engine::MeshRegistry::meshes[part->visualData.drawMeshId]->render(part->renderMode);
+			Shaders::basicShader.updatePart(part.cframe, part.scale);
+			Engine::MeshRegistry::meshes[part.visuals.drawMeshId]->render(part.visuals.renderMode);
 		}
 
-		if (screen->selectedPart) {
-			Shaders::debugShader.updateModel(screen->selectedPart->getCFrame().asMat4WithPreScale(screen->selectedPart->hitbox.scale));
-			Engine::MeshRegistry::meshes[screen->selectedPart->visualData.drawMeshId]->render();
+		if (selectedPartSnapshot != nullptr) {
+			Shaders::debugShader.updateModel(selectedPartSnapshot->cframe.asMat4WithPreScale(selectedPartSnapshot->scale));
+			Engine::MeshRegistry::meshes[selectedPartSnapshot->visuals.drawMeshId]->render();
 		}
-	});
+	};
+	// rendered from the latest snapshot, so the physics thread never has to wait for rendering to finish
+	// while paused, parts are edited without a tick to publish a new snapshot, so the current state is read instead
+	if (isPaused()) {
+		screen->world->readCurrentSnapshot(renderSnapshot);
+	} else {
+		screen->world->readSnapshot(renderSnapshot);
+	}
 
 	endScene();
 }
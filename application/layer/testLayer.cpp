@@ -93,20 +93,26 @@ void renderQuad() {
 }
 
 void TestLayer::renderScene() {
-	std::multimap<int, ExtendedPart*> visibleParts;
-	screen.world->syncReadOnlyOperation([&visibleParts] () {
-		for (ExtendedPart& part : screen.world->iterParts(ALL_PARTS)) 
-			visibleParts.insert({ part.visualData.drawMeshId, &part });
-	});
-
-	for (auto iterator = visibleParts.begin(); iterator != visibleParts.end(); ++iterator) {
-		ExtendedPart* part = (*iterator).second;
-
-		if (part->visualData.drawMeshId == -1)
-			continue;
-
-		Shaders::depthShader.updateModel(part->getCFrame().asMat4WithPreScale(part->hitbox.scale));
-		Engine::MeshRegistry::meshes[part->visualData.drawMeshId]->render(part->renderMode);
+	auto renderSnapshot = [] (const WorldSnapshot<ExtendedPart>& snapshot) {
+		std::multimap<int, const PartSnapshot<ExtendedPart>*> visibleParts;
+		for (const PartSnapshot<ExtendedPart>& partSnapshot : snapshot.parts)
+			visibleParts.insert({ partSnapshot.visuals.drawMeshId, &partSnapshot });
+
+		for (auto iterator = visibleParts.begin(); iterator != visibleParts.end(); ++iterator) {
+			const PartSnapshot<ExtendedPart>& part = *(*iterator).second;
+
+			if (part.visuals.drawMeshId == -1)
+				continue;
+
+			Shaders::depthShader.updateModel(part.cframe.asMat4WithPreScale(part.scale));
+			Engine::MeshRegistry::meshes[part.visuals.drawMeshId]->render(part.visuals.renderMode);
+		}
+	};
+	// see ModelLayer::onRender, while paused the current state is read since edits don't publish a snapshot
+	if (isPaused()) {
+		screen.world->readCurrentSnapshot(renderSnapshot);
+	} else {
+		screen.world->readSnapshot(renderSnapshot);
 	}
 }
 
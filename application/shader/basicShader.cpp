@@ -8,9 +8,13 @@
 namespace Application {
 
 void BasicShader::updatePart(const ExtendedPart& part) {
+	updatePart(part.getCFrame(), part.hitbox.scale);
+}
+
+void BasicShader::updatePart(const GlobalCFrame& cframe, const DiagonalMat3& scale) {
 	bind();
 	BasicShader::updateTexture(false);
-	BasicShader::updateModel(part.getCFrame(), DiagonalMat3f(part.hitbox.scale));
+	BasicShader::updateModel(cframe, DiagonalMat3f(scale));
 }
 
 void BasicShader::updateMaterial(const Material& material) {
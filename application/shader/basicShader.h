@@ -13,6 +13,7 @@ struct BasicShader : public StandardMeshShaderBase, public BasicShaderBase {
 	inline BasicShader(ShaderSource shaderSource) : StandardMeshShaderBase(shaderSource.name, shaderSource.path, shaderSource), BasicShaderBase(shaderSource.name, shaderSource.path, shaderSource), ShaderResource(shaderSource.name, shaderSource.path, shaderSource) {}
 
 	void updatePart(const ExtendedPart& part);
+	void updatePart(const GlobalCFrame& cframe, const DiagonalMat3& scale);
 	void updateTexture(bool textured);
 	void updateMaterial(const Material& material);
 };
@@ -5,10 +5,12 @@
 namespace Application {
 
 using namespace std::chrono;
-TickerThread::TickerThread(double targetTPS, milliseconds tickSkipTimeout, void(*tickAction)()) {
-	this->TPS = targetTPS;
-	this->tickSkipTimeout = tickSkipTimeout;
-	this->tickAction = tickAction;
+TickerThread::TickerThread(double targetTPS, milliseconds tickSkipTimeout, void(*tickAction)(double stepScale)) {
+	TickerSettings settings;
+	settings.ticksPerSecond = targetTPS;
+	settings.policy = CatchUpPolicy::BOUNDED_CATCH_UP;
+	settings.maxLag = tickSkipTimeout;
+	this->ticker = std::make_unique<FixedStepTicker>(settings, tickAction);
 }
 
 TickerThread::~TickerThread() {
@@ -16,40 +18,35 @@ TickerThread::~TickerThread() {
 }
 
 void TickerThread::start() {
-	this->stopped = false;
-
-	this->thread = std::thread([this] () {
-		time_point<system_clock> nextTarget = system_clock::now();
-
-		while (!(this->stopped)) {
+	this->ticker->start();
+}
 
-			microseconds tickTime = microseconds((long long) (1000000 / (this->TPS * this->speed)));
+void TickerThread::runTick() {
+	this->ticker->runTick();
+}
 
-			this->tickAction();
+void TickerThread::stop() {
+	if (this->ticker) this->ticker->stop();
+}
 
-			nextTarget += tickTime;
-			time_point<system_clock>  curTime = system_clock::now();
-			if (curTime < nextTarget) {
-				std::this_thread::sleep_until(nextTarget);
-			} else {
-				// We're behind schedule
-				if (nextTarget < curTime - this->tickSkipTimeout) {
-					Log::warn("Can't keep up! Skipping %d ticks!", (int) ((curTime - nextTarget).count() / (1E3 * this->tickSkipTimeout.count())));
+void TickerThread::setTPS(double newTPS) {
+	TickerSettings settings = this->ticker->getSettings();
+	settings.ticksPerSecond = newTPS;
+	this->ticker->setSettings(settings);
+}
 
-					nextTarget = curTime;
-				}
-			}
-		}
-		});
+double TickerThread::getTPS() const {
+	return this->ticker->getSettings().ticksPerSecond;
 }
 
-void TickerThread::runTick() {
-	this->tickAction();
+void TickerThread::setSpeed(double newSpeed) {
+	TickerSettings settings = this->ticker->getSettings();
+	settings.speed = newSpeed;
+	this->ticker->setSettings(settings);
 }
 
-void TickerThread::stop() {
-	this->stopped = true;
-	if (this->thread.joinable()) this->thread.join();
+double TickerThread::getSpeed() const {
+	return this->ticker->getSettings().speed;
 }
 
-};
\ No newline at end of file
+};
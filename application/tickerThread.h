@@ -1,31 +1,30 @@
 #pragma once
 
 #include <chrono>
-#include <thread>
+#include <memory>
+
+#include "../physics/threading/fixedStepTicker.h"
 
 namespace Application {
 
 using namespace std::chrono;
 
+/*
+	Ticks the application on a FixedStepTicker, catching up a few ticks at a time when it falls behind,
+	and dropping the lag once it exceeds tickSkipTimeout
+	tickAction receives the stepScale of its tick, the number of tick intervals it should advance the simulation
+*/
 class TickerThread {
 private:
-	std::thread thread;
-	bool stopped = false;
-	double TPS;
-	double speed = 1.0;
-	milliseconds tickSkipTimeout;
-	void(*tickAction)();
+	std::unique_ptr<FixedStepTicker> ticker;
 public:
-	TickerThread() : thread(), TPS(0.0), tickSkipTimeout(0), tickAction(nullptr) {};
-	TickerThread(double targetTPS, milliseconds tickSkipTimeout, void(*tickAction)());
+	TickerThread() = default;
+	TickerThread(double targetTPS, milliseconds tickSkipTimeout, void(*tickAction)(double stepScale));
 	~TickerThread();
 
 	TickerThread& operator=(TickerThread&& rhs) noexcept {
-		this->thread = std::thread();
-		this->stopped = rhs.stopped;
-		this->TPS = rhs.TPS;
-		this->tickSkipTimeout = rhs.tickSkipTimeout;
-		this->tickAction = rhs.tickAction;
+		this->stop();
+		this->ticker = std::move(rhs.ticker);
 
 		return *this;
 	}
@@ -35,13 +34,15 @@ public:
 	void start();
 	void stop();
 
-	void setTPS(double newTPS) { this->TPS = newTPS; }
-	double getTPS() const { return this->TPS; }
+	void setTPS(double newTPS);
+	double getTPS() const;
 
-	void setSpeed(double newSpeed) { this->speed = newSpeed; }
-	double getSpeed() { return this->speed; }
+	void setSpeed(double newSpeed);
+	double getSpeed() const;
 
 	void runTick();
+
+	inline const FixedStepTicker& getTicker() const { return *ticker; }
 };
 
-};
\ No newline at end of file
+};
@@ -583,7 +583,13 @@ void BigFrame::renderPropertiesFrame() {
 				if (ImGui::InputFloat3("Position: ", position, 3)) {
 					GlobalCFrame frame = sp->getCFrame();
 					frame.position = Position(position[0], position[1], position[2]);
-					sp->setCFrame(frame);
+					world.asyncModification([sp, frame] () {
+						if (sp->isTerrainPart) {
+							world.setTerrainPartCFrame(sp, frame);
+						} else {
+							sp->setCFrame(frame);
+						}
+						});
 				}
 			} else {
 				// Position
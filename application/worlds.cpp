@@ -23,6 +23,7 @@ namespace Application {
 
 PlayerWorld::PlayerWorld(double deltaT) : SynchronizedWorld<ExtendedPart>(deltaT) {
 	ecstree = new Engine::ECSTree();
+	publishSnapshots = true;
 }
 
 void PlayerWorld::applyExternalForces() {
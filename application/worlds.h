@@ -4,6 +4,22 @@
 #include "../engine/ecs/tree.h"
 #include "../physics/math/position.h"
 #include "../physics/synchonizedWorld.h"
+#include "ecs/material.h"
+
+/*
+	Everything the renderers need of an ExtendedPart, so they can draw from a snapshot without touching the part
+*/
+template<>
+struct PartSnapshotVisuals<Application::ExtendedPart> {
+	Application::Material material;
+	int drawMeshId;
+	int renderMode;
+
+	PartSnapshotVisuals(const Application::ExtendedPart& part) :
+		material(part.material),
+		drawMeshId(part.visualData.drawMeshId),
+		renderMode(part.renderMode) {}
+};
 
 namespace Application {
 
@@ -0,0 +1,63 @@
+#include "benchmark.h"
+
+#include "../physics/datastructures/boundsTree.h"
+#include "../util/log.h"
+
+#include <vector>
+#include <utility>
+#include <stdlib.h>
+
+struct BuildBenchObject {};
+
+static std::vector<std::pair<BuildBenchObject*, Bounds>> createRandomTerrain(std::vector<BuildBenchObject>& objects) {
+	std::vector<std::pair<BuildBenchObject*, Bounds>> result;
+	result.reserve(objects.size());
+	srand(0);
+	for(BuildBenchObject& obj : objects) {
+		Position min(1000.0 * rand() / RAND_MAX, 20.0 * rand() / RAND_MAX, 1000.0 * rand() / RAND_MAX);
+		Vec3Fix size(1.0 + 4.0 * rand() / RAND_MAX, 1.0 + 4.0 * rand() / RAND_MAX, 1.0 + 4.0 * rand() / RAND_MAX);
+		result.emplace_back(&obj, Bounds(min, min + size));
+	}
+	return result;
+}
+
+class BoundsTreeBuildBenchmark : public Benchmark {
+	std::vector<BuildBenchObject> objects;
+	std::vector<std::pair<BuildBenchObject*, Bounds>> objectsAndBounds;
+	int buildCount = 20;
+public:
+	BoundsTreeBuildBenchmark() : Benchmark("boundsTreeBuild"), objects(100000) {}
+
+	void init() override {
+		objectsAndBounds = createRandomTerrain(objects);
+	}
+	void run() override {
+		for(int i = 0; i < buildCount; i++) {
+			BoundsTree<BuildBenchObject> tree;
+			tree.buildFrom(objectsAndBounds);
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("%.3fms per build of %d objects\n", timeTaken / buildCount, (int) objects.size());
+	}
+} boundsTreeBuild;
+
+class BoundsTreeIncrementalBuildBenchmark : public Benchmark {
+	std::vector<BuildBenchObject> objects;
+	std::vector<std::pair<BuildBenchObject*, Bounds>> objectsAndBounds;
+public:
+	BoundsTreeIncrementalBuildBenchmark() : Benchmark("boundsTreeIncrementalBuild"), objects(100000) {}
+
+	void init() override {
+		objectsAndBounds = createRandomTerrain(objects);
+	}
+	void run() override {
+		BoundsTree<BuildBenchObject> tree;
+		for(const std::pair<BuildBenchObject*, Bounds>& objectAndBounds : objectsAndBounds) {
+			tree.add(objectAndBounds.first, objectAndBounds.second);
+		}
+		for(int i = 0; i < 5; i++) {
+			tree.improveStructure();
+		}
+	}
+} boundsTreeIncrementalBuild;
@@ -0,0 +1,130 @@
+#include "benchmark.h"
+
+#include "../physics/constraintGroup.h"
+#include "../physics/part.h"
+#include "../physics/physical.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/math/linalg/vec.h"
+#include "../physics/motion.h"
+#include "../util/log.h"
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// ConstraintGroup::apply is repeated for at least this long per group size and solve method
+#define MIN_MEASURE_TIME_MS 20.0
+
+struct ConstraintSolveTimes {
+	size_t constraintCount;
+	double factorizedMs;
+	double iterativeMs;
+};
+
+/*
+	Runs f until MIN_MEASURE_TIME_MS has passed, returns the average time of one call in ms
+*/
+template<typename F>
+static double measure(F f) {
+	auto start = std::chrono::high_resolution_clock::now();
+	int runs = 0;
+	double elapsedMs;
+	do {
+		f();
+		runs++;
+		elapsedMs = (std::chrono::high_resolution_clock::now() - start).count() / 1000000.0;
+	} while(elapsedMs < MIN_MEASURE_TIME_MS);
+	return elapsedMs / runs;
+}
+
+/*
+	A chain of spheres held together by ball constraints, slightly pulled apart and moving so every solve has work to do
+*/
+struct ConstraintChain {
+	std::vector<std::unique_ptr<Part>> parts;
+	std::vector<BallConstraint> ballConstraints;
+	ConstraintGroup group;
+
+	std::vector<GlobalCFrame> initialCFrames;
+	std::vector<Motion> initialMotions;
+
+	ConstraintChain(size_t constraintCount) {
+		ballConstraints.reserve(constraintCount);
+		for(size_t i = 0; i <= constraintCount; i++) {
+			Part* part = new Part(sphereShape(1.0), GlobalCFrame(2.0 * i + 0.01 * std::sin(i), 0.01 * std::cos(i), 0.0), {1.0 + i % 3, 1.0, 1.0});
+			part->ensureHasParent();
+			part->parent->mainPhysical->motionOfCenterOfMass = Motion(Vec3(0.1 * std::cos(i), 0.2 * std::sin(i), 0.0), Vec3(0.0, 0.0, 0.05 * (i % 5)));
+			parts.emplace_back(part);
+			initialCFrames.push_back(part->getCFrame());
+			initialMotions.push_back(part->parent->mainPhysical->motionOfCenterOfMass);
+		}
+		for(size_t i = 0; i < constraintCount; i++) {
+			ballConstraints.emplace_back(Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0));
+			group.add(parts[i]->parent, parts[i + 1]->parent, &ballConstraints.back());
+		}
+	}
+
+	/*
+		Puts the chain back in its initial state, and drops the previous solutions so the iterative solver starts cold
+	*/
+	void reset() {
+		for(size_t i = 0; i < parts.size(); i++) {
+			MotorizedPhysical* phys = parts[i]->parent->mainPhysical;
+			phys->setCFrame(initialCFrames[i]);
+			phys->motionOfCenterOfMass = initialMotions[i];
+			phys->totalForce = Vec3(0.0, 0.0, 0.0);
+			phys->totalMoment = Vec3(0.0, 0.0, 0.0);
+		}
+		group.lastDrags.clear();
+		group.lastImpulses.clear();
+		group.lastForces.clear();
+	}
+
+	double measureApply(size_t sparseSolveMinConstraints) {
+		group.sparseSolveMinConstraints = sparseSolveMinConstraints;
+		double resetMs = measure([&]() { reset(); });
+		double resetAndApplyMs = measure([&]() {
+			reset();
+			group.apply();
+		});
+		return resetAndApplyMs - resetMs;
+	}
+};
+
+/*
+	Times ConstraintGroup::apply for chains of increasing length, once with the interaction matrix factorized and once solved iteratively from a cold start,
+	SPARSE_CONSTRAINT_SOLVE_MIN_CONSTRAINTS should sit near where the two cross
+*/
+class ConstraintSolveBenchmark : public Benchmark {
+	std::vector<std::unique_ptr<ConstraintChain>> chains;
+	std::vector<ConstraintSolveTimes> results;
+public:
+	ConstraintSolveBenchmark() : Benchmark("constraintSolveSweep") {}
+
+	void init() override {
+		for(size_t constraintCount : {2, 4, 8, 16, 24, 32, 48, 64, 128, 256}) {
+			chains.push_back(std::make_unique<ConstraintChain>(constraintCount));
+		}
+	}
+
+	void run() override {
+		results.clear();
+		for(const std::unique_ptr<ConstraintChain>& chain : chains) {
+			ConstraintSolveTimes times;
+			times.constraintCount = chain->group.constraints.size();
+			times.factorizedMs = chain->measureApply(std::numeric_limits<size_t>::max());
+			times.iterativeMs = chain->measureApply(0);
+			results.push_back(times);
+		}
+	}
+
+	void printResults(double timeTaken) override {
+		Log::print("constraints   apply factorized   apply iterative (cold)\n");
+		for(const ConstraintSolveTimes& times : results) {
+			Log::print("%11d   %14.4fms   %20.4fms   (%.2fx)%s\n", (int) times.constraintCount, times.factorizedMs, times.iterativeMs, times.iterativeMs / times.factorizedMs,
+					   times.constraintCount < SPARSE_CONSTRAINT_SOLVE_MIN_CONSTRAINTS ? "   <- factorized by default" : "");
+		}
+	}
+} constraintSolveSweep;
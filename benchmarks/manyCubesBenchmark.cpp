@@ -5,10 +5,16 @@
 #include "worldBenchmark.h"
 #include "../physics/math/linalg/commonMatrices.h"
 #include "../physics/math/linalg/trigonometry.h"
+#include "../physics/misc/filters/rayIntersectsBoundsFilter.h"
+#include "../physics/misc/filters/visibilityFilter.h"
+#include "../util/log.h"
+
+#include <cmath>
 
 class ManyCubesBenchmark : public WorldBenchmark {
 public:
-	ManyCubesBenchmark() : WorldBenchmark("manyCubes", 10000) {}
+	ManyCubesBenchmark() : ManyCubesBenchmark("manyCubes") {}
+	ManyCubesBenchmark(const char* name) : WorldBenchmark(name, 10000) {}
 
 	void init() {
 		createFloor(50, 50, 10);
@@ -35,3 +41,87 @@ public:
 		}
 	}
 } manyCubesBench;
+
+class ManyCubesFattenedBoundsBenchmark : public ManyCubesBenchmark {
+public:
+	ManyCubesFattenedBoundsBenchmark() : ManyCubesBenchmark("manyCubesFattenedBounds") {
+		world.fattenObjectBounds = true;
+	}
+} manyCubesFattenedBoundsBench;
+
+class ManyCubesCompactedTreeBenchmark : public ManyCubesBenchmark {
+public:
+	ManyCubesCompactedTreeBenchmark() : ManyCubesBenchmark("manyCubesCompactedTree") {
+		world.compactObjectTree = true;
+	}
+} manyCubesCompactedTreeBench;
+
+/*
+	Queries the tree of a settled manyCubes world, rather than ticking it
+	Build with -DMAX_BRANCHES=8 (BOUNDS_TREE_BRANCHES in cmake) to compare against the default of 4
+*/
+class ManyCubesQueryBenchmark : public ManyCubesBenchmark {
+protected:
+	int queryCount;
+	size_t totalHits = 0;
+
+	virtual size_t query(int i) = 0;
+
+	Position queryOrigin(int i) const {
+		return Position(20.0 * std::sin(i * 0.37), 8.0 + 6.0 * std::sin(i * 0.11), 20.0 * std::cos(i * 0.37));
+	}
+	Vec3 queryDirection(int i) const {
+		// roughly towards the pile of cubes, with some spread
+		Vec3 toCenter = Position(0.0, 2.0, 0.0) - queryOrigin(i);
+		return normalize(toCenter + Vec3(std::sin(i * 1.3), std::cos(i * 0.7), std::sin(i * 2.1)) * 4.0);
+	}
+
+public:
+	ManyCubesQueryBenchmark(const char* name, int queryCount) : ManyCubesBenchmark(name), queryCount(queryCount) {}
+
+	void init() override {
+		ManyCubesBenchmark::init();
+		for(int i = 0; i < 500; i++) {
+			world.tick();
+		}
+	}
+	void run() override {
+		for(int i = 0; i < queryCount; i++) {
+			totalHits += query(i);
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("MAX_BRANCHES = %d, longest branch: %d\n", MAX_BRANCHES, (int) world.objectTree.rootNode.getLengthOfLongestBranch());
+		Log::print("%.3fus per query, %.1f parts found per query\n", timeTaken * 1000.0 / queryCount, double(totalHits) / queryCount);
+	}
+};
+
+class ManyCubesRayQueryBenchmark : public ManyCubesQueryBenchmark {
+public:
+	ManyCubesRayQueryBenchmark() : ManyCubesQueryBenchmark("manyCubesRayQueries", 1000000) {}
+
+	size_t query(int i) override {
+		RayIntersectBoundsFilter filter(Ray{queryOrigin(i), queryDirection(i)});
+		size_t hits = 0;
+		for(const Part& p : world.iterPartsFiltered(filter, FREE_PARTS)) {
+			hits++;
+		}
+		return hits;
+	}
+} manyCubesRayQueryBench;
+
+class ManyCubesFrustumQueryBenchmark : public ManyCubesQueryBenchmark {
+public:
+	ManyCubesFrustumQueryBenchmark() : ManyCubesQueryBenchmark("manyCubesFrustumQueries", 100000) {}
+
+	size_t query(int i) override {
+		Vec3 forward = queryDirection(i);
+		Vec3 up = normalize(forward % Vec3(1.0, 0.0, 0.0) % forward);
+		VisibilityFilter filter = VisibilityFilter::forWindow(queryOrigin(i), forward, up, 0.8, 1.5, 30.0);
+		size_t hits = 0;
+		for(const Part& p : world.iterPartsFiltered(filter, FREE_PARTS)) {
+			hits++;
+		}
+		return hits;
+	}
+} manyCubesFrustumQueryBench;
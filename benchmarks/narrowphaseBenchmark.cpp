@@ -0,0 +1,83 @@
+#include "benchmark.h"
+
+#include "../physics/geometry/shape.h"
+#include "../physics/geometry/shapeClass.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/geometry/intersection.h"
+
+#include <vector>
+
+#define NARROWPHASE_BENCH_SIZE 1000000
+
+/*
+	Touching box and sphere pairs, the most common contacts in a world
+*/
+static std::vector<std::pair<Shape, Shape>> createPairs() {
+	Shape box = boxShape(1.0, 1.0, 1.0);
+	Shape sphere = sphereShape(0.5);
+	return std::vector<std::pair<Shape, Shape>>{{box, box}, {box, sphere}, {sphere, box}, {sphere, sphere}};
+}
+
+static std::vector<CFrame> createTransforms() {
+	std::vector<CFrame> transforms;
+	for(int i = 0; i < 64; i++) {
+		transforms.push_back(CFrame(Vec3(0.8 + 0.003 * i, 0.1 * (i % 5), -0.05 * (i % 7)), Rotation::fromEulerAngles(0.1 * i, 0.03 * i, 0.07 * i)));
+	}
+	return transforms;
+}
+
+class ShapePairNarrowphase : public Benchmark {
+	std::vector<std::pair<Shape, Shape>> pairs;
+	std::vector<CFrame> transforms;
+public:
+	ShapePairNarrowphase() : Benchmark("shapePairNarrowphase") {}
+
+	void init() override {
+		this->pairs = createPairs();
+		this->transforms = createTransforms();
+	}
+	void run() override {
+		for(int round = 0; round < NARROWPHASE_BENCH_SIZE; round++) {
+			const std::pair<Shape, Shape>& pair = pairs[round % pairs.size()];
+			intersectsTransformed(pair.first, pair.second, transforms[round % transforms.size()]);
+		}
+	}
+} shapePairNarrowphase;
+
+class GJKNarrowphase : public Benchmark {
+	std::vector<std::pair<Shape, Shape>> pairs;
+	std::vector<CFrame> transforms;
+public:
+	GJKNarrowphase() : Benchmark("gjkNarrowphase") {}
+
+	void init() override {
+		this->pairs = createPairs();
+		this->transforms = createTransforms();
+	}
+	void run() override {
+		for(int round = 0; round < NARROWPHASE_BENCH_SIZE; round++) {
+			const std::pair<Shape, Shape>& pair = pairs[round % pairs.size()];
+			intersectsTransformed(*pair.first.baseShape, *pair.second.baseShape, transforms[round % transforms.size()], pair.first.scale, pair.second.scale);
+		}
+	}
+} gjkNarrowphase;
+
+/*
+	Cube pairs through GJK and EPA, which is all support queries of the builtin CubeClass
+*/
+class GJKCubeNarrowphase : public Benchmark {
+	Shape box;
+	std::vector<CFrame> transforms;
+public:
+	GJKCubeNarrowphase() : Benchmark("gjkCubeNarrowphase") {}
+
+	void init() override {
+		this->box = boxShape(1.0, 1.0, 1.0);
+		this->transforms = createTransforms();
+	}
+	void run() override {
+		for(int round = 0; round < NARROWPHASE_BENCH_SIZE; round++) {
+			intersectsTransformed(*box.baseShape, *box.baseShape, transforms[round % transforms.size()], box.scale, box.scale);
+		}
+	}
+} gjkCubeNarrowphase;
@@ -0,0 +1,127 @@
+#include "benchmark.h"
+
+#include "../physics/geometry/polyhedron.h"
+#include "../physics/geometry/supportGraph.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../util/log.h"
+
+#include <cmath>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#define SUPPORT_BENCH_QUERIES 200000
+
+struct SupportTimes {
+	int vertexCount;
+	double scanNs;
+	double graphNs;
+	double hintedGraphNs;
+};
+
+/*
+	Slowly turning directions, like the searches GJK and EPA make for one pair, and those of the same pair over consecutive ticks
+*/
+static std::vector<Vec3f> createDirections() {
+	std::vector<Vec3f> directions;
+	for(int i = 0; i < SUPPORT_BENCH_QUERIES; i++) {
+		directions.push_back(Vec3f(std::cos(0.01f * i), std::sin(0.013f * i), std::cos(0.007f * i + 1.0f)));
+	}
+	return directions;
+}
+
+template<typename F>
+static double measureNsPerQuery(const std::vector<Vec3f>& directions, F furthest) {
+	auto start = std::chrono::high_resolution_clock::now();
+	float total = 0.0f;
+	for(const Vec3f& direction : directions) {
+		total += furthest(direction).x;
+	}
+	double elapsedNs = static_cast<double>((std::chrono::high_resolution_clock::now() - start).count());
+	// keeps the queries from being optimized away
+	if(total == 12345.0f) Log::print("");
+	return elapsedNs / directions.size();
+}
+
+/*
+	Compares scanning all vertices to hill climbing a SupportGraph from the axis extremes, and from the previous result like GJK and EPA do, for spheres of increasing detail
+	The vertex count where the hinted graph starts winning is what SUPPORT_GRAPH_MIN_VERTICES should be
+*/
+class SupportGraphSwitchPoint : public Benchmark {
+	std::vector<Polyhedron> meshes;
+	std::vector<Vec3f> directions;
+	std::vector<SupportTimes> results;
+public:
+	SupportGraphSwitchPoint() : Benchmark("supportGraphSwitchPoint") {}
+
+	void init() override {
+		for(int steps = 0; steps <= 5; steps++) {
+			meshes.push_back(Library::createSphere(1.0f, steps));
+		}
+		directions = createDirections();
+	}
+	void run() override {
+		results.clear();
+		for(const Polyhedron& mesh : meshes) {
+			SupportGraph graph(mesh, 0);
+			SupportTimes times;
+			times.vertexCount = mesh.vertexCount;
+			times.scanNs = measureNsPerQuery(directions, [&](const Vec3f& direction) { return mesh.furthestInDirection(direction); });
+			times.graphNs = measureNsPerQuery(directions, [&](const Vec3f& direction) { return graph.furthestInDirection(direction); });
+			int hint = -1;
+			times.hintedGraphNs = measureNsPerQuery(directions, [&](const Vec3f& direction) { return graph.getVertex(graph.furthestIndexFromHint(direction, hint)); });
+			results.push_back(times);
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("vertices   scan        graph       hinted graph\n");
+		for(const SupportTimes& times : results) {
+			Log::print("%8d   %7.1fns   %7.1fns   %7.1fns\n", times.vertexCount, times.scanNs, times.graphNs, times.hintedGraphNs);
+		}
+	}
+} supportGraphSwitchPoint;
+
+/*
+	Compares the 6 separate scans getBounds used to make to a single batched scan, on the same spheres
+*/
+class BatchedSupportQueries : public Benchmark {
+	std::vector<Polyhedron> meshes;
+	std::vector<Vec3f> directions;
+	std::vector<SupportTimes> results;
+public:
+	BatchedSupportQueries() : Benchmark("batchedSupportQueries") {}
+
+	void init() override {
+		for(int steps = 0; steps <= 5; steps++) {
+			meshes.push_back(Library::createSphere(1.0f, steps));
+		}
+		directions = createDirections();
+	}
+	void run() override {
+		results.clear();
+		for(const Polyhedron& mesh : meshes) {
+			SupportTimes times;
+			times.vertexCount = mesh.vertexCount;
+			// per group of 6 directions
+			times.scanNs = 6 * measureNsPerQuery(directions, [&](const Vec3f& direction) { return mesh.furthestInDirection(direction); });
+
+			auto start = std::chrono::high_resolution_clock::now();
+			float total = 0.0f;
+			for(size_t i = 0; i + 6 <= directions.size(); i += 6) {
+				Vec3f furthest[6];
+				mesh.furthestInDirections(&directions[i], 6, furthest);
+				total += furthest[0].x + furthest[5].x;
+			}
+			double elapsedNs = static_cast<double>((std::chrono::high_resolution_clock::now() - start).count());
+			if(total == 12345.0f) Log::print("");
+			times.graphNs = elapsedNs / (directions.size() / 6);
+			results.push_back(times);
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("vertices   6 scans     1 batched scan\n");
+		for(const SupportTimes& times : results) {
+			Log::print("%8d   %7.1fns   %7.1fns\n", times.vertexCount, times.scanNs, times.graphNs);
+		}
+	}
+} batchedSupportQueries;
@@ -0,0 +1,87 @@
+#include "colissionIslands.h"
+
+#include "world.h"
+#include "physical.h"
+
+size_t ColissionIslands::getPhysicalIndex(const MotorizedPhysical* phys) {
+	auto found = physicalIndices.find(phys);
+	if(found != physicalIndices.end()) {
+		return found->second;
+	}
+	size_t newIndex = parents.size();
+	physicalIndices.emplace(phys, newIndex);
+	parents.push_back(newIndex);
+	return newIndex;
+}
+
+size_t ColissionIslands::findRoot(size_t physicalIndex) {
+	while(parents[physicalIndex] != physicalIndex) {
+		parents[physicalIndex] = parents[parents[physicalIndex]];
+		physicalIndex = parents[physicalIndex];
+	}
+	return physicalIndex;
+}
+
+void ColissionIslands::join(size_t first, size_t second) {
+	size_t firstRoot = findRoot(first);
+	size_t secondRoot = findRoot(second);
+	if(firstRoot < secondRoot) {
+		parents[secondRoot] = firstRoot;
+	} else if(secondRoot < firstRoot) {
+		parents[firstRoot] = secondRoot;
+	}
+}
+
+/*
+	Counting sort of the colissions by island, islandOf gives the island of every colission
+*/
+static void groupByIsland(const std::vector<Colission>& colissions, const std::vector<size_t>& islandOf, size_t islandCount, std::vector<const Colission*>& grouped, std::vector<size_t>& offsets, std::vector<size_t>& cursors) {
+	offsets.assign(islandCount + 1, 0);
+	for(size_t island : islandOf) {
+		offsets[island + 1]++;
+	}
+	for(size_t i = 0; i < islandCount; i++) {
+		offsets[i + 1] += offsets[i];
+	}
+	grouped.resize(colissions.size());
+	cursors.assign(offsets.begin(), offsets.end() - 1);
+	for(size_t i = 0; i < colissions.size(); i++) {
+		grouped[cursors[islandOf[i]]++] = &colissions[i];
+	}
+}
+
+void ColissionIslands::build(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions) {
+	physicalIndices.clear();
+	parents.clear();
+
+	for(const Colission& c : objectColissions) {
+		join(getPhysicalIndex(c.p1->parent->mainPhysical), getPhysicalIndex(c.p2->parent->mainPhysical));
+	}
+	for(const Colission& c : terrainColissions) {
+		getPhysicalIndex(c.p1->parent->mainPhysical);
+	}
+
+	// number the islands in order of their first physical
+	islandOfPhysical.assign(parents.size(), 0);
+	islandCount = 0;
+	for(size_t i = 0; i < parents.size(); i++) {
+		size_t root = findRoot(i);
+		if(root == i) {
+			islandOfPhysical[i] = islandCount++;
+		} else {
+			islandOfPhysical[i] = islandOfPhysical[root];
+		}
+	}
+
+	islandOfColission.clear();
+	for(const Colission& c : objectColissions) {
+		islandOfColission.push_back(islandOfPhysical[physicalIndices[c.p1->parent->mainPhysical]]);
+	}
+	groupByIsland(objectColissions, islandOfColission, islandCount, this->objectColissions, objectColissionOffsets, cursors);
+
+	islandOfColission.clear();
+	for(const Colission& c : terrainColissions) {
+		islandOfColission.push_back(islandOfPhysical[physicalIndices[c.p1->parent->mainPhysical]]);
+	}
+	groupByIsland(terrainColissions, islandOfColission, islandCount, this->terrainColissions, terrainColissionOffsets, cursors);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+#include "datastructures/iteratorFactory.h"
+
+struct Colission;
+class MotorizedPhysical;
+
+/*
+	Groups the colissions of a tick into islands, sets of MotorizedPhysicals connected through a chain of colissions
+	Islands share no physicals, so the colissions of different islands can be handled at the same time
+	Within an island colissions keep the order they were given in
+*/
+class ColissionIslands {
+	std::unordered_map<const MotorizedPhysical*, size_t> physicalIndices;
+	std::vector<size_t> parents;
+	std::vector<size_t> islandOfPhysical;
+	size_t islandCount = 0;
+
+	// scratch space, kept to be reused between ticks
+	std::vector<size_t> islandOfColission;
+	std::vector<size_t> cursors;
+
+	std::vector<const Colission*> objectColissions;
+	std::vector<size_t> objectColissionOffsets;
+	std::vector<const Colission*> terrainColissions;
+	std::vector<size_t> terrainColissionOffsets;
+
+	size_t getPhysicalIndex(const MotorizedPhysical* phys);
+	size_t findRoot(size_t physicalIndex);
+	void join(size_t first, size_t second);
+
+public:
+	/*
+		Terrain colissions only belong to the island of their first part
+	*/
+	void build(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions);
+
+	inline size_t size() const { return islandCount; }
+
+	inline IteratorFactory<const Colission* const*> getObjectColissions(size_t island) const {
+		return IteratorFactory<const Colission* const*>(objectColissions.data() + objectColissionOffsets[island], objectColissions.data() + objectColissionOffsets[island + 1]);
+	}
+	inline IteratorFactory<const Colission* const*> getTerrainColissions(size_t island) const {
+		return IteratorFactory<const Colission* const*>(terrainColissions.data() + terrainColissionOffsets[island], terrainColissions.data() + terrainColissionOffsets[island + 1]);
+	}
+};
@@ -0,0 +1,32 @@
+#include "colissionPairCache.h"
+
+ColissionPairCache::CachedPair& ColissionPairCache::getPair(const Part* first, const Part* second) {
+	CachedPair& cached = pairs.try_emplace(PartPair{first, second}, CachedPair{Vec3f(0.0f, 0.0f, 0.0f), SupportHints(), ContactManifold(), false}).first->second;
+	cached.usedThisTick = true;
+	return cached;
+}
+
+void ColissionPairCache::removeUnusedPairs() {
+	for(auto iter = pairs.begin(); iter != pairs.end();) {
+		if(iter->second.usedThisTick) {
+			iter->second.usedThisTick = false;
+			++iter;
+		} else {
+			iter = pairs.erase(iter);
+		}
+	}
+}
+
+void ColissionPairCache::removePart(const Part* part) {
+	for(auto iter = pairs.begin(); iter != pairs.end();) {
+		if(iter->first.first == part || iter->first.second == part) {
+			iter = pairs.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+void ColissionPairCache::clear() {
+	pairs.clear();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <functional>
+
+#include "math/linalg/vec.h"
+#include "geometry/genericCollidable.h"
+#include "contactManifold.h"
+
+class Part;
+
+/*
+	Remembers the direction GJK ended with for every pair of parts that reached the narrowphase, so the next tick can start from it
+	For pairs that stay apart this is a separating axis and GJK quits immediately, resting contacts converge in fewer iterations
+	The vertices last found on either part are kept as well, so the support searches of the next tick start next to their answer
+	Also holds the ContactManifold of every pair, used when persistentContactManifolds is on
+
+	Pairs are keyed in the order the broadphase produced them, a pair that comes out swapped simply starts fresh
+*/
+class ColissionPairCache {
+	struct PartPair {
+		const Part* first;
+		const Part* second;
+
+		inline bool operator==(const PartPair& other) const {
+			return first == other.first && second == other.second;
+		}
+	};
+	struct PartPairHash {
+		inline size_t operator()(const PartPair& pair) const {
+			size_t h1 = std::hash<const Part*>()(pair.first);
+			size_t h2 = std::hash<const Part*>()(pair.second);
+			return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+		}
+	};
+
+public:
+	struct CachedPair {
+		Vec3f searchDirection;
+		SupportHints supportHints;
+		ContactManifold manifold;
+		bool usedThisTick;
+	};
+
+private:
+	std::unordered_map<PartPair, CachedPair, PartPairHash> pairs;
+
+public:
+	/*
+		Returns what is stored for this pair, a zero search direction and an empty manifold if the pair wasn't tested last tick
+		The returned reference stays valid until the next call to removeUnusedPairs or clear, 
+		so different pairs may be filled in from different threads
+	*/
+	CachedPair& getPair(const Part* first, const Part* second);
+
+	inline Vec3f& getSearchDirection(const Part* first, const Part* second) {
+		return getPair(first, second).searchDirection;
+	}
+
+	/*
+		Forgets pairs that weren't looked up since the previous call, called once every tick after the narrowphase
+	*/
+	void removeUnusedPairs();
+
+	/*
+		Forgets all pairs of part, so a part allocated at the same address later doesn't start from its entries
+		Goes over all cached pairs, called when a part is removed from the world
+	*/
+	void removePart(const Part* part);
+
+	void clear();
+
+	inline size_t size() const { return pairs.size(); }
+};
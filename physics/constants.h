@@ -3,3 +3,23 @@
 #define GJK_MAX_ITER 200
 #define EPA_MAX_ITER 200
 #define COLLISSION_DEPTH_FORCE_MULTIPLIER 2000
+
+// a physical moving slower than this for SLEEP_TICKS ticks is put to sleep, when the world allows it
+#define SLEEP_VELOCITY_THRESHOLD 0.05
+#define SLEEP_ANGULAR_VELOCITY_THRESHOLD 0.05
+#define SLEEP_TICKS 100
+// weight of the newest tick in the running average of the velocity compared against the sleep thresholds, filters out contact jitter
+#define SLEEP_VELOCITY_SMOOTHING 0.1
+
+// fattened object bounds are expanded by this much, plus the distance the part travels in FAT_BOUNDS_TICKS ticks
+#define FAT_BOUNDS_MARGIN 0.02
+#define FAT_BOUNDS_TICKS 4
+
+// when the world's compactObjectTree is set, the object tree is reordered in memory once every this many ticks
+#define OBJECT_TREE_COMPACTION_TICKS 50
+
+// constraint groups with at least this many constraints are solved iteratively on the sparse interaction matrix, smaller groups are factorized, see the constraintSolveSweep benchmark
+#define SPARSE_CONSTRAINT_SOLVE_MIN_CONSTRAINTS 32
+// the iterative constraint solver stops once the residual is below this fraction of the right hand side, or after the max iterations
+#define CONSTRAINT_SOLVER_TOLERANCE 1e-8
+#define CONSTRAINT_SOLVER_MAX_ITERATIONS 1000
@@ -3,9 +3,13 @@
 #include "math/linalg/largeMatrix.h"
 #include "physical.h"
 #include "math/linalg/mat.h"
+#include "constants.h"
 
 #include "math/mathUtil.h"
 #include <fstream>
+#include <algorithm>
+#include <utility>
+#include <memory>
 
 
 void ConstraintGroup::add(Physical* first, Physical* second, BallConstraint* constraint) {
@@ -13,148 +17,171 @@ void ConstraintGroup::add(Physical* first, Physical* second, BallConstraint* con
 }
 void BallConstraint::doNothing() {}
 
-LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
-	const std::vector<PhysicalConstraint>& constraints = group.constraints;
+/*
+	The effect of an impulse at responseOffset on the velocity at actorOffset of sharedBody, in global space
+*/
+static Mat3 getCouplingBlock(const Physical* sharedBody, const Vec3& actorOffset, const Vec3& responseOffset) {
+	Mat3 response = sharedBody->mainPhysical->getResponseMatrix(sharedBody->localToMain(actorOffset), sharedBody->localToMain(responseOffset));
 
-	size_t dimension = constraints.size() * 3;
-	LargeMatrix<double> systemToSolve(dimension, dimension);
-	for (size_t i = 0; i < dimension; i++) {
-		for (size_t j = 0; j < dimension; j++) {
-			systemToSolve.get(i, j) = 0.0;
-		}
-	}
+	Mat3 rot = sharedBody->mainPhysical->getCFrame().getRotation().asRotationMatrix();
 
-	size_t matrixIndex = 0;
-	for (const PhysicalConstraint& pc : constraints) {
-		const BallConstraint& bc = *pc.constraint;
-		/*Local to A*/ SymmetricMat3 responseA = pc.physA->mainPhysical->getResponseMatrix(pc.physA->localToMain(bc.attachA));
-		/*Local to B*/ SymmetricMat3 responseB = pc.physB->mainPhysical->getResponseMatrix(pc.physB->localToMain(bc.attachB));
-		GlobalCFrame cfA = pc.physA->mainPhysical->getCFrame();
-		GlobalCFrame cfB = pc.physB->mainPhysical->getCFrame();
-		/*Global?*/ SymmetricMat3 selfResponse = cfA.rotation.localToGlobal(responseA) + cfB.rotation.localToGlobal(responseB);
+	return rot * response * rot.transpose();
+}
 
-		systemToSolve.setSubMatrix(matrixIndex, matrixIndex, Mat3(selfResponse));
+/*
+	Only constraints that share a Physical affect each other, so every 3x3 block row only has a block for the constraints attached to its two physicals
+*/
+BlockSparseMatrix<double, 3> computeInteractionMatrix(const ConstraintGroup& group) {
+	const std::vector<PhysicalConstraint>& constraints = group.constraints;
 
-		matrixIndex += 3;
+	// every (physical, constraint index) pair, sorted by physical, to find the constraints sharing a physical
+	std::vector<std::pair<const Physical*, size_t>> attachments;
+	attachments.reserve(constraints.size() * 2);
+	for (size_t i = 0; i < constraints.size(); i++) {
+		attachments.emplace_back(constraints[i].physA, i);
+		attachments.emplace_back(constraints[i].physB, i);
 	}
+	std::sort(attachments.begin(), attachments.end());
 
+	BlockSparseMatrix<double, 3> systemToSolve;
 	for (size_t i = 0; i < constraints.size(); i++) {
 		const PhysicalConstraint& y = constraints[i];
+		const BallConstraint& bc = *y.constraint;
+		/*Local to A*/ SymmetricMat3 responseA = y.physA->mainPhysical->getResponseMatrix(y.physA->localToMain(bc.attachA));
+		/*Local to B*/ SymmetricMat3 responseB = y.physB->mainPhysical->getResponseMatrix(y.physB->localToMain(bc.attachB));
+		GlobalCFrame cfA = y.physA->mainPhysical->getCFrame();
+		GlobalCFrame cfB = y.physB->mainPhysical->getCFrame();
+		/*Global?*/ SymmetricMat3 selfResponse = cfA.rotation.localToGlobal(responseA) + cfB.rotation.localToGlobal(responseB);
 
-		for (size_t j = 0; j < constraints.size(); j++) {
-			if (i == j) continue;
-			const PhysicalConstraint& x = constraints[j];
-
-			// find effect of y constraint on velocities of x;
-
-			bool isPositive;
-			Physical* sharedBody;
-			Vec3 actorOffset;
-			Vec3 responseOffset;
-
-				 if (x.physA == y.physA) { 
-					 isPositive = true;  sharedBody = x.physA; actorOffset = x.constraint->attachA; responseOffset = y.constraint->attachA; }
-			else if (x.physA == y.physB) { 
-					 isPositive = false; sharedBody = x.physA; actorOffset = x.constraint->attachA; responseOffset = y.constraint->attachB; }
-			else if (x.physB == y.physA) { 
-					 isPositive = false; sharedBody = x.physB; actorOffset = x.constraint->attachB; responseOffset = y.constraint->attachA; }
-			else if (x.physA == y.physB) { 
-					 isPositive = true;  sharedBody = x.physB; actorOffset = x.constraint->attachB; responseOffset = y.constraint->attachB; }
-			else {continue;}
-			
-			Mat3 response = sharedBody->mainPhysical->getResponseMatrix(sharedBody->localToMain(actorOffset), sharedBody->localToMain(responseOffset));
-
-			Mat3 rot = sharedBody->mainPhysical->getCFrame().getRotation().asRotationMatrix();
-
-			Mat3 globalResponse = rot * response * rot.transpose();
-
-			systemToSolve.setSubMatrix(i * 3, j * 3, isPositive ? globalResponse : -globalResponse);
+		systemToSolve.addRow(Mat3(selfResponse));
+
+		// find effect of y constraint on velocities of every constraint x sharing a physical with it
+		for (int ySide = 0; ySide < 2; ySide++) {
+			const Physical* sharedBody = (ySide == 0) ? y.physA : y.physB;
+			const Vec3& responseOffset = (ySide == 0) ? y.constraint->attachA : y.constraint->attachB;
+
+			auto range = std::equal_range(attachments.begin(), attachments.end(), std::make_pair(sharedBody, size_t(0)), [](const std::pair<const Physical*, size_t>& a, const std::pair<const Physical*, size_t>& b) {
+				return a.first < b.first;
+			});
+			for (auto iter = range.first; iter != range.second; ++iter) {
+				size_t j = iter->second;
+				if (j == i) continue;
+				const PhysicalConstraint& x = constraints[j];
+
+				// a constraint pulls A and B in opposite directions, so the effect changes sign when the body is on different sides of the two constraints
+				bool xOnA = (x.physA == sharedBody);
+				bool isPositive = (xOnA == (ySide == 0));
+				const Vec3& actorOffset = xOnA ? x.constraint->attachA : x.constraint->attachB;
+
+				Mat3 globalResponse = getCouplingBlock(sharedBody, actorOffset, responseOffset);
+				systemToSolve.addToRow(j, isPositive ? globalResponse : -globalResponse);
+			}
 		}
 	}
 
 	return systemToSolve;
 }
 
+/*
+	Solves the interaction matrix of a group for the drag, the impulse and the force in turn
+	Small groups are factorized once and the factorization is reused for all three, large groups are solved iteratively
+*/
+class ConstraintSystemSolver {
+	const BlockSparseMatrix<double, 3>& interactionMatrix;
+	std::unique_ptr<LargeCholeskyDecomposition<double>> cholesky;
+	std::unique_ptr<LargeLUDecomposition<double>> lu;
+public:
+	ConstraintSystemSolver(const BlockSparseMatrix<double, 3>& interactionMatrix, size_t sparseSolveMinConstraints) : interactionMatrix(interactionMatrix) {
+		if (interactionMatrix.getBlockCount() < sparseSolveMinConstraints) {
+			LargeMatrix<double> systemToSolve = interactionMatrix.toLargeMatrix();
+			cholesky.reset(new LargeCholeskyDecomposition<double>(systemToSolve));
+			if (!cholesky->isPositiveDefinite()) {
+				// only happens through rounding for nearly redundant constraints
+				cholesky.reset();
+				lu.reset(new LargeLUDecomposition<double>(systemToSolve));
+			}
+		}
+	}
 
-void ConstraintGroup::apply() const {
-	size_t dimension = constraints.size() * 3;
-	LargeMatrix<double> systemToSolve = computeInteractionMatrix(*this);
-	LargeVector<double> dragVector(dimension);
-	LargeVector<double> velocityVector(dimension);
-	LargeVector<double> accelerationVector(dimension);
-
-	
-
-
-
-	LargeMatrix<double> systemCopy(systemToSolve);
-	LargeMatrix<double> systemCopyCopy(systemToSolve);
+	/*
+		Solves interactionMatrix * x = values, values receives the solution
+		The iterative solver starts from lastSolution, which then receives the new solution
+	*/
+	void solve(std::vector<Vec3>& values, std::vector<Vec3>& lastSolution) const {
+		size_t constraintCount = values.size();
+		if (cholesky || lu) {
+			LargeVector<double> vector(constraintCount * 3);
+			for (size_t i = 0; i < constraintCount; i++) {
+				vector.setSubVector(i * 3, values[i]);
+			}
+			if (cholesky) cholesky->solveInPlace(vector); else lu->solveInPlace(vector);
+			for (size_t i = 0; i < constraintCount; i++) {
+				values[i] = vector.getSubVector<Vector, 3>(i * 3);
+			}
+		} else {
+			if (lastSolution.size() != constraintCount) {
+				lastSolution.assign(constraintCount, Vec3(0.0, 0.0, 0.0));
+			}
+			conjugateGradientSolve(interactionMatrix, values.data(), lastSolution.data(), CONSTRAINT_SOLVER_MAX_ITERATIONS, CONSTRAINT_SOLVER_TOLERANCE);
+			values = lastSolution;
+		}
+	}
+};
 
-	size_t matrixIndex;
+void ConstraintGroup::apply() {
+	BlockSparseMatrix<double, 3> interactionMatrix = computeInteractionMatrix(*this);
+	ConstraintSystemSolver solver(interactionMatrix, sparseSolveMinConstraints);
+	std::vector<Vec3> dragVector(constraints.size());
+	std::vector<Vec3> velocityVector(constraints.size());
+	std::vector<Vec3> accelerationVector(constraints.size());
 
 	// solve for position
-	matrixIndex = 0;
-	for (const PhysicalConstraint& bc : constraints) {
+	for (size_t i = 0; i < constraints.size(); i++) {
+		const PhysicalConstraint& bc = constraints[i];
 		Position posA = bc.physA->getCFrame().localToGlobal(bc.constraint->attachA);
 		Position posB = bc.physB->getCFrame().localToGlobal(bc.constraint->attachB);
-		dragVector.setSubVector(matrixIndex, Vec3(posB - posA));
-
-		matrixIndex += 3;
+		dragVector[i] = Vec3(posB - posA);
 	}
-	destructiveSolve(systemCopyCopy, dragVector);
+	solver.solve(dragVector, lastDrags);
 
-	matrixIndex = 0;
-	for (const PhysicalConstraint& bc : constraints) {
-		Vec3 drag;
-		for (int i = 0; i < 3; i++) { drag[i] = dragVector[matrixIndex + i]; }
+	for (size_t i = 0; i < constraints.size(); i++) {
+		const PhysicalConstraint& bc = constraints[i];
+		Vec3 drag = dragVector[i];
 		bc.physA->applyDragToPhysical(bc.physA->getCFrame().localToRelative(bc.constraint->attachA), drag);
 		bc.physB->applyDragToPhysical(bc.physB->getCFrame().localToRelative(bc.constraint->attachB), -drag);
-
-		matrixIndex += 3;
 	}
 
 	// solve for velocity
-	matrixIndex = 0;
-	for (const PhysicalConstraint& bc : constraints) {
+	for (size_t i = 0; i < constraints.size(); i++) {
+		const PhysicalConstraint& bc = constraints[i];
 		Vec3 vb = bc.physB->getMotionOfCenterOfMass().getVelocityOfPoint(bc.physB->getCFrame().localToRelative(bc.constraint->attachB));
 		Vec3 va = bc.physA->getMotionOfCenterOfMass().getVelocityOfPoint(bc.physA->getCFrame().localToRelative(bc.constraint->attachA));
 
-		velocityVector.setSubVector(matrixIndex, vb - va);
-
-		matrixIndex += 3;
+		velocityVector[i] = vb - va;
 	}
-	destructiveSolve(systemToSolve, velocityVector);
-	
-	matrixIndex = 0;
-	for (const PhysicalConstraint& bc : constraints) {
-		Vec3 impulse;
-		for (int i = 0; i < 3; i++) { impulse[i] = velocityVector[matrixIndex + i]; }
+	solver.solve(velocityVector, lastImpulses);
+
+	for (size_t i = 0; i < constraints.size(); i++) {
+		const PhysicalConstraint& bc = constraints[i];
+		Vec3 impulse = velocityVector[i];
 		bc.physA->applyImpulseToPhysical(bc.physA->getCFrame().localToRelative(bc.constraint->attachA), impulse);
 		bc.physB->applyImpulseToPhysical(bc.physB->getCFrame().localToRelative(bc.constraint->attachB), -impulse);
-
-		matrixIndex += 3;
 	}
 
 	// solve for acceleration
-	matrixIndex = 0;
-	for (const PhysicalConstraint& bc : constraints) {
+	for (size_t i = 0; i < constraints.size(); i++) {
+		const PhysicalConstraint& bc = constraints[i];
 		Vec3 ab = bc.physB->getMotionOfCenterOfMass().getAccelerationOfPoint(bc.physB->getCFrame().localToRelative(bc.constraint->attachB));
 		Vec3 aa = bc.physA->getMotionOfCenterOfMass().getAccelerationOfPoint(bc.physA->getCFrame().localToRelative(bc.constraint->attachA));
 
-		accelerationVector.setSubVector(matrixIndex, ab - aa);
-
-		matrixIndex += 3;
+		accelerationVector[i] = ab - aa;
 	}
+	solver.solve(accelerationVector, lastForces);
 
-	destructiveSolve(systemCopy, accelerationVector);
-	
-	matrixIndex = 0;
-	for (const PhysicalConstraint& bc : constraints) {
-		Vec3 force;
-		for (int i = 0; i < 3; i++) {force[i] = accelerationVector[matrixIndex + i];}
+	for (size_t i = 0; i < constraints.size(); i++) {
+		const PhysicalConstraint& bc = constraints[i];
+		Vec3 force = accelerationVector[i];
 		bc.physA->applyForceToPhysical(bc.physA->getCFrame().localToRelative(bc.constraint->attachA), force);
 		bc.physB->applyForceToPhysical(bc.physB->getCFrame().localToRelative(bc.constraint->attachB), -force);
-
-		matrixIndex += 3;
 	}
 }
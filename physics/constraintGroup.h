@@ -2,6 +2,8 @@
 
 #include <vector>
 #include "math/linalg/vec.h"
+#include "math/linalg/blockSparseMatrix.h"
+#include "constants.h"
 
 class Physical;
 
@@ -28,7 +30,25 @@ struct PhysicalConstraint {
 struct ConstraintGroup {
 	std::vector<PhysicalConstraint> constraints;
 
+	/*
+		The solutions of the previous tick, one per constraint, used as the starting point for the iterative solver
+		They are reset to zero whenever the number of constraints changes
+	*/
+	std::vector<Vec3> lastDrags;
+	std::vector<Vec3> lastImpulses;
+	std::vector<Vec3> lastForces;
+
+	/*
+		Groups with fewer constraints than this are solved by factorizing their interaction matrix, larger ones iteratively
+	*/
+	size_t sparseSolveMinConstraints = SPARSE_CONSTRAINT_SOLVE_MIN_CONSTRAINTS;
+
 	void add(Physical* first, Physical* second, BallConstraint* constraint);
 
-	void apply() const;
+	void apply();
 };
+
+/*
+	The 3x3 block matrix mapping the impulses of the constraints of group to the resulting changes in the relative velocity of their attachments
+*/
+BlockSparseMatrix<double, 3> computeInteractionMatrix(const ConstraintGroup& group);
@@ -0,0 +1,81 @@
+#include "contactManifold.h"
+
+#include <algorithm>
+
+static Vec3 normalOf(const Vec3& exitVector) {
+	double depth = length(exitVector);
+	return (depth > 0.0) ? exitVector / depth : Vec3(0.0, 0.0, 0.0);
+}
+
+/*
+	Grows with the area of the quadrilateral spanned by a, b, c and d, whatever order they are in
+	The diagonals are the pair of opposite sides of which the cross product is largest
+*/
+static double quadAreaMeasure(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& d) {
+	double ab_cd = lengthSquared((a - b) % (c - d));
+	double ac_bd = lengthSquared((a - c) % (b - d));
+	double ad_bc = lengthSquared((a - d) % (b - c));
+	return std::max(ab_cd, std::max(ac_bd, ad_bc));
+}
+
+void ContactManifold::replacePointForLargestArea(const ContactPoint& newPoint) {
+	int bestToReplace = 0;
+	double bestArea = -1.0;
+	for(int replaced = 0; replaced < CONTACT_MANIFOLD_MAX_POINTS; replaced++) {
+		Vec3 corners[CONTACT_MANIFOLD_MAX_POINTS];
+		for(int i = 0; i < CONTACT_MANIFOLD_MAX_POINTS; i++) {
+			corners[i] = (i == replaced) ? newPoint.onFirst : points[i].onFirst;
+		}
+		double area = quadAreaMeasure(corners[0], corners[1], corners[2], corners[3]);
+		if(area > bestArea) {
+			bestArea = area;
+			bestToReplace = replaced;
+		}
+	}
+	points[bestToReplace] = newPoint;
+}
+
+void ContactManifold::update(const GlobalCFrame& first, const GlobalCFrame& second, const Position& intersection, const Vec3& exitVector, double sizeOrder) {
+	Vec3 normal = normalOf(exitVector);
+	double maxDrift = CONTACT_MANIFOLD_DRIFT_DISTANCE * sizeOrder;
+
+	int keptCount = 0;
+	for(int i = 0; i < pointCount; i++) {
+		// points from the surface of second to that of first, so along normal while the point still penetrates
+		Vec3 apart = Vec3(first.localToGlobal(points[i].onFirst) - second.localToGlobal(points[i].onSecond));
+		double depth = apart * normal;
+		Vec3 drift = apart - normal * depth;
+		if(depth >= 0.0 && lengthSquared(drift) <= maxDrift * maxDrift) {
+			points[keptCount++] = points[i];
+		}
+	}
+	pointCount = keptCount;
+
+	// the surfaces of the two parts are half the depth on either side of intersection
+	Vec3Fix halfExit(exitVector * 0.5);
+	ContactPoint newPoint{first.globalToLocal(intersection + halfExit), second.globalToLocal(intersection - halfExit)};
+
+	double mergeDistance = CONTACT_MANIFOLD_MERGE_DISTANCE * sizeOrder;
+	for(int i = 0; i < pointCount; i++) {
+		if(lengthSquared(points[i].onFirst - newPoint.onFirst) < mergeDistance * mergeDistance) {
+			points[i] = newPoint;
+			return;
+		}
+	}
+
+	if(pointCount < CONTACT_MANIFOLD_MAX_POINTS) {
+		points[pointCount++] = newPoint;
+	} else {
+		replacePointForLargestArea(newPoint);
+	}
+}
+
+int ContactManifold::getContacts(const GlobalCFrame& first, const GlobalCFrame& second, const Vec3& exitVector, Contact* contacts) const {
+	Vec3 normal = normalOf(exitVector);
+	for(int i = 0; i < pointCount; i++) {
+		Position onSecond = second.localToGlobal(points[i].onSecond);
+		Vec3 apart = Vec3(first.localToGlobal(points[i].onFirst) - onSecond);
+		contacts[i] = Contact{onSecond + Vec3Fix(apart * 0.5), normal * (apart * normal)};
+	}
+	return pointCount;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "math/linalg/vec.h"
+#include "math/position.h"
+#include "math/globalCFrame.h"
+
+// the most contact points a ContactManifold keeps, enough for a box resting on a face
+#define CONTACT_MANIFOLD_MAX_POINTS 4
+// a new contact this close to a kept one replaces it, as a fraction of the size of the smaller part
+#define CONTACT_MANIFOLD_MERGE_DISTANCE 0.05
+// kept contacts whose two ends slid further apart than this along the contact plane are dropped, as a fraction of the size of the smaller part
+#define CONTACT_MANIFOLD_DRIFT_DISTANCE 0.02
+
+/*
+	A point where two parts touch, exitVector is the part of the pair's exitVector that belongs to this point
+*/
+struct Contact {
+	Position position;
+	Vec3 exitVector;
+};
+
+/*
+	The contacts of a pair of parts, gathered over consecutive ticks
+	The narrowphase only finds the single deepest contact of a pair, as a resting box rocks slightly this moves from corner to corner
+	Keeping the earlier contacts that are still touching gives a box on a floor up to 4 contacts to stand on, instead of tipping between one corner and the next
+
+	Every contact is stored on both parts, so it moves along with them and its depth can be measured again in later ticks
+*/
+class ContactManifold {
+	struct ContactPoint {
+		// on the surface of the first part, local to it
+		Vec3 onFirst;
+		// on the surface of the second part, local to it
+		Vec3 onSecond;
+	};
+
+	ContactPoint points[CONTACT_MANIFOLD_MAX_POINTS];
+	int pointCount = 0;
+
+	/*
+		Removes one of the CONTACT_MANIFOLD_MAX_POINTS kept points to make room for newPoint,
+		keeping the ones that together with it span the largest area
+	*/
+	void replacePointForLargestArea(const ContactPoint& newPoint);
+
+public:
+	inline int size() const { return pointCount; }
+	inline void clear() { pointCount = 0; }
+
+	/*
+		Adds the contact the narrowphase found this tick, drops the kept contacts that no longer touch or slid apart
+		intersection and exitVector are those of PartIntersection, sizeOrder is the size of the smaller part
+	*/
+	void update(const GlobalCFrame& first, const GlobalCFrame& second, const Position& intersection, const Vec3& exitVector, double sizeOrder);
+
+	/*
+		Writes the contacts to contacts and returns how many there are
+		Every contact gets the direction of the current exitVector, with the depth measured at that contact
+	*/
+	int getContacts(const GlobalCFrame& first, const GlobalCFrame& second, const Vec3& exitVector, Contact* contacts) const;
+};
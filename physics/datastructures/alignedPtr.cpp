@@ -3,6 +3,12 @@
 #include <stdlib.h>
 #include <exception>
 
+static thread_local size_t alignedAllocationCount = 0;
+
+size_t getAlignedAllocationCount() {
+	return alignedAllocationCount;
+}
+
 void deleteAligned(void* buf) {
 #ifdef _MSC_VER
 	_aligned_free(buf);
@@ -25,5 +31,6 @@ void* createAligned(size_t size, size_t align) {
 		deleteAligned(buf);
 		throw "Error, did not align buffer storage!";
 	}
+	alignedAllocationCount++;
 	return buf;
 }
@@ -5,6 +5,8 @@
 
 void deleteAligned(void* buf);
 void* createAligned(std::size_t size, std::size_t align);
+// the number of buffers createAligned has returned on the calling thread, for tests that check code doesn't allocate
+std::size_t getAlignedAllocationCount();
 
 template<typename T>
 class UniqueAlignedPointer {
@@ -1,11 +1,70 @@
 #include "boundsTree.h"
 
 #include "buffers.h"
+#include "../threading/threadPool.h"
 
 #include <utility>
 #include <new>
 #include <limits>
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+
+/*
+	Every subTrees array has room for MAX_BRANCHES nodes, so they are all the same size and can be handed out from slabs
+	Freed arrays are kept in a free list and reused, slabs are never given back to the heap
+*/
+#define SUB_TREES_PER_SLAB 64
+
+union FreeSubTrees {
+	FreeSubTrees* next;
+	TreeNode nodes[MAX_BRANCHES];
+
+	FreeSubTrees() : next(nullptr) {}
+	~FreeSubTrees() {}
+};
+
+static std::mutex subTreesPoolMutex;
+static FreeSubTrees* firstFreeSubTrees = nullptr;
+static size_t subTreesSlabCount = 0;
+
+TreeNode* allocateSubTrees() {
+	FreeSubTrees* block;
+	{
+		std::lock_guard<std::mutex> lock(subTreesPoolMutex);
+		if(firstFreeSubTrees == nullptr) {
+			FreeSubTrees* slab = static_cast<FreeSubTrees*>(::operator new(sizeof(FreeSubTrees) * SUB_TREES_PER_SLAB));
+			for(size_t i = 0; i < SUB_TREES_PER_SLAB; i++) {
+				slab[i].next = (i + 1 < SUB_TREES_PER_SLAB) ? slab + i + 1 : nullptr;
+			}
+			firstFreeSubTrees = slab;
+			subTreesSlabCount++;
+		}
+		block = firstFreeSubTrees;
+		firstFreeSubTrees = block->next;
+	}
+	for(int i = 0; i < MAX_BRANCHES; i++) {
+		new(block->nodes + i) TreeNode();
+	}
+	return block->nodes;
+}
+
+void freeSubTrees(TreeNode* subTrees) {
+	if(subTrees == nullptr) return;
+	for(int i = 0; i < MAX_BRANCHES; i++) {
+		subTrees[i].~TreeNode();
+	}
+	FreeSubTrees* block = reinterpret_cast<FreeSubTrees*>(subTrees);
+	std::lock_guard<std::mutex> lock(subTreesPoolMutex);
+	block->next = firstFreeSubTrees;
+	firstFreeSubTrees = block;
+}
+
+size_t getSubTreesSlabCount() {
+	std::lock_guard<std::mutex> lock(subTreesPoolMutex);
+	return subTreesSlabCount;
+}
 
 long long computeCost(const Bounds& bounds) {
 	Vec3Fix d = bounds.getDiagonal();
@@ -53,7 +112,7 @@ TreeNode::TreeNode(const TreeNode& original) :
 	if(original.isLeafNode()) {
 		this->object = original.object;
 	} else {
-		this->subTrees = new TreeNode[MAX_BRANCHES];
+		this->subTrees = allocateSubTrees();
 		for(size_t i = 0; i < original.nodeCount; i++) {
 			new(this->subTrees + i) TreeNode(original.subTrees[i]);
 		}
@@ -69,7 +128,7 @@ TreeNode& TreeNode::operator=(const TreeNode& original) {
 	if(original.isLeafNode()) {
 		this->object = original.object;
 	} else {
-		this->subTrees = new TreeNode[MAX_BRANCHES];
+		this->subTrees = allocateSubTrees();
 		for(size_t i = 0; i < original.nodeCount; i++) {
 			new(this->subTrees + i) TreeNode(original.subTrees[i]);
 		}
@@ -79,7 +138,7 @@ TreeNode& TreeNode::operator=(const TreeNode& original) {
 
 TreeNode::~TreeNode() {
 	if (!isLeafNode()) {
-		delete[] subTrees;
+		freeSubTrees(subTrees);
 	}
 }
 
@@ -106,7 +165,7 @@ void TreeNode::addOutside(TreeNode&& newNode) {
 		this->addInside(std::move(newNode));
 	} else {
 		// push the whole group down, make a new node containing it and the new node
-		TreeNode* newNodes = new TreeNode[MAX_BRANCHES];
+		TreeNode* newNodes = allocateSubTrees();
 		new(newNodes) TreeNode(std::move(*this));
 		new(newNodes + 1) TreeNode(std::move(newNode));
 		new(this) TreeNode(newNodes, 2);
@@ -117,7 +176,7 @@ void TreeNode::addOutside(TreeNode&& newNode) {
 // if top node is undivisible, then the new node will be inside of the group
 void TreeNode::addInside(TreeNode&& newNode) {
 	if (isLeafNode()) {
-		TreeNode* newNodes = new TreeNode[MAX_BRANCHES];
+		TreeNode* newNodes = allocateSubTrees();
 
 		new(newNodes) TreeNode(std::move(*this));
 		new(newNodes + 1) TreeNode(std::move(newNode));
@@ -151,7 +210,7 @@ TreeNode TreeNode::remove(int index) {
 		bool resultIsGroupHead = this->isGroupHead || buf[0].isGroupHead;
 		new(this) TreeNode(std::move(buf[0]));
 		this->isGroupHead = resultIsGroupHead;
-		delete[] buf;
+		freeSubTrees(buf);
 	} else {
 		this->recalculateBoundsFromSubBounds();
 	}
@@ -192,6 +251,17 @@ size_t TreeNode::getNumberOfObjectsInNode() const {
 	return runningTotal;
 }
 
+size_t TreeNode::getNumberOfObjectsInNodeUpTo(size_t limit) const {
+	if(this->isLeafNode()) return 1;
+
+	size_t runningTotal = 0;
+	for(const TreeNode& subNode : *this) {
+		if(runningTotal >= limit) break;
+		runningTotal += subNode.getNumberOfObjectsInNodeUpTo(limit - runningTotal);
+	}
+	return runningTotal;
+}
+
 size_t TreeNode::getLengthOfLongestBranch() const {
 	if(this->isLeafNode()) return 0;
 
@@ -248,6 +318,57 @@ inline static void exchangeObjects(TreeNode& first, TreeNode& second) {
 	}
 }
 
+static void gatherSubTreesDepthFirst(const TreeNode& node, std::vector<std::pair<TreeNode*, size_t>>& arrays) {
+	if(node.isLeafNode()) return;
+	arrays.emplace_back(node.subTrees, arrays.size());
+	for(int i = 0; i < node.nodeCount; i++) {
+		gatherSubTreesDepthFirst(node.subTrees[i], arrays);
+	}
+}
+
+static void pointSubTreesDepthFirst(TreeNode& node, const std::vector<std::pair<TreeNode*, size_t>>& arrays, size_t& nextArray) {
+	if(node.isLeafNode()) return;
+	// the array this pointed to has already been filled with other contents, only the new pointer is valid
+	node.subTrees = arrays[nextArray++].first;
+	for(int i = 0; i < node.nodeCount; i++) {
+		pointSubTreesDepthFirst(node.subTrees[i], arrays, nextArray);
+	}
+}
+
+/*
+	Reorders the subTrees arrays the tree already owns, so that a depth first traversal visits them at increasing addresses
+	No arrays are allocated or freed, only a list of the arrays is. Their contents are swapped in place into depth first order, and the pointers to them are fixed afterwards
+*/
+void compactDepthFirst(TreeNode& rootNode) {
+	if(rootNode.isLeafNode() || rootNode.nodeCount == 0) return;
+
+	// every array with the depth first position of its contents, sorted by address, the i'th array must end up with the contents of depth first position i
+	std::vector<std::pair<TreeNode*, size_t>> arrays;
+	gatherSubTreesDepthFirst(rootNode, arrays);
+	std::sort(arrays.begin(), arrays.end());
+
+	std::vector<size_t> arrayHolding(arrays.size());
+	for(size_t i = 0; i < arrays.size(); i++) {
+		arrayHolding[arrays[i].second] = i;
+	}
+	// every swap puts the contents of one array at their final address
+	for(size_t target = 0; target < arrays.size(); target++) {
+		size_t source = arrayHolding[target];
+		if(source == target) continue;
+		for(int i = 0; i < MAX_BRANCHES; i++) {
+			std::swap(arrays[target].first[i], arrays[source].first[i]);
+		}
+		size_t displaced = arrays[target].second;
+		arrays[source].second = displaced;
+		arrayHolding[displaced] = source;
+		arrays[target].second = target;
+		arrayHolding[target] = target;
+	}
+
+	size_t nextArray = 0;
+	pointSubTreesDepthFirst(rootNode, arrays, nextArray);
+}
+
 NodeStack::NodeStack(TreeNode& rootNode) : stack{TreeStackElement{&rootNode, 0}}, top(stack) {
 	if(rootNode.nodeCount == 0) {
 		top--;
@@ -487,7 +608,7 @@ inline static void recursiveFindBestCombination(long long& bestCost, NodePermuta
 /*
 	This function tries all permutations of the given nodes, and finds which arrangement results in the smallest bounds when split into two groups
 */
-NodePermutation findBestPermutation(const FixedLocalBuffer<TreeNode*, 2 * MAX_BRANCHES>& allNodes, long long initialBestCost) {
+NodePermutation findBestPermutationExhaustive(const FixedLocalBuffer<TreeNode*, 2 * MAX_BRANCHES>& allNodes, long long initialBestCost) {
 	NodePermutation bestPermutation;
 	NodePermutation currentPermutation;
 	
@@ -515,6 +636,78 @@ NodePermutation findBestPermutation(const FixedLocalBuffer<TreeNode*, 2 * MAX_BR
 	return bestPermutation;
 }
 
+// twice the center of the bounds along the given axis, no need to divide for sorting
+inline static Fix<32> doubleCenterAlongAxis(const Bounds& bounds, int axis) {
+	switch(axis) {
+	case 0: return bounds.min.x + bounds.max.x;
+	case 1: return bounds.min.y + bounds.max.y;
+	default: return bounds.min.z + bounds.max.z;
+	}
+}
+
+/*
+	Sorts the nodes by their center along each axis in turn, and only tries splitting these sorted lists in two
+	This takes O(n log n) per axis instead of the O(2^n) of trying every permutation
+*/
+NodePermutation findBestPermutationSorted(const FixedLocalBuffer<TreeNode*, 2 * MAX_BRANCHES>& allNodes, long long initialBestCost) {
+	NodePermutation bestPermutation;
+	long long bestCost = initialBestCost;
+
+	int count = static_cast<int>(allNodes.size);
+	TreeNode* sorted[2 * MAX_BRANCHES];
+	Bounds boundsAfter[2 * MAX_BRANCHES];
+
+	for(int axis = 0; axis < 3; axis++) {
+		// an insertion sort over the filled part, std::sort of so few nodes would do the same but reaches past sorted as far as the compiler can tell
+		for(int i = 0; i < count; i++) {
+			TreeNode* node = allNodes[i];
+			Fix<32> center = doubleCenterAlongAxis(node->bounds, axis);
+			int j = i;
+			for(; j > 0 && center < doubleCenterAlongAxis(sorted[j - 1]->bounds, axis); j--) {
+				sorted[j] = sorted[j - 1];
+			}
+			sorted[j] = node;
+		}
+
+		boundsAfter[count - 1] = sorted[count - 1]->bounds;
+		for(int i = count - 2; i >= 0; i--) {
+			boundsAfter[i] = unionOfBounds(boundsAfter[i + 1], sorted[i]->bounds);
+		}
+
+		// the first countA nodes go to A, the rest to B, neither may exceed MAX_BRANCHES
+		Bounds boundsBefore = sorted[0]->bounds;
+		for(int countA = 1; countA < count; countA++) {
+			if(countA > 1) boundsBefore = unionOfBounds(boundsBefore, sorted[countA - 1]->bounds);
+			if(countA > MAX_BRANCHES) break;
+			if(count - countA > MAX_BRANCHES) continue;
+
+			long long cost = computeCost(boundsBefore) + computeCost(boundsAfter[countA]);
+			if(cost < bestCost) {
+				bestCost = cost;
+				bestPermutation = NodePermutation();
+				bestPermutation.pushAN(sorted, countA);
+				bestPermutation.pushBN(sorted + countA, count - countA);
+			}
+		}
+	}
+
+	return bestPermutation;
+}
+
+/*
+	Trying every permutation grows exponentially with the number of nodes, which is fine for MAX_BRANCHES == 4, but not for wider nodes
+	Above this many nodes only sorted splits are tried
+*/
+#define EXHAUSTIVE_PERMUTATION_LIMIT 10
+
+NodePermutation findBestPermutation(const FixedLocalBuffer<TreeNode*, 2 * MAX_BRANCHES>& allNodes, long long initialBestCost) {
+	if(allNodes.size <= EXHAUSTIVE_PERMUTATION_LIMIT) {
+		return findBestPermutationExhaustive(allNodes, initialBestCost);
+	} else {
+		return findBestPermutationSorted(allNodes, initialBestCost);
+	}
+}
+
 inline static void fillNodePairWithPermutation(TreeNode& first, TreeNode& second, NodePermutation& bestPermutation) {
 	if (bestPermutation.countA == 1) bestPermutation.swap(); // make sure that the leafnode is always permutationB
 
@@ -531,9 +724,9 @@ inline static void fillNodePairWithPermutation(TreeNode& first, TreeNode& second
 	int groupsNeeded = 1 + (bestPermutation.countB != 1);
 
 	if (existingGroups < groupsNeeded) {// tops one extra group to be made
-		availableGroups[1] = new TreeNode[MAX_BRANCHES];
+		availableGroups[1] = allocateSubTrees();
 	} else if (existingGroups > groupsNeeded) {
-		delete[] availableGroups[--existingGroups];
+		freeSubTrees(availableGroups[--existingGroups]);
 	}
 
 	first.subTrees = availableGroups[0];
@@ -628,3 +821,334 @@ void TreeNode::improveStructure() {
 		}
 	}
 }
+
+/*
+	Bulk building
+
+	The nodes are split top down, every node of the tree gets up to MAX_BRANCHES ranges, made by repeatedly splitting the largest range in two
+	Each split is chosen by binning the node centers along every axis and picking the cheapest plane, like computeCost but weighed by the number of nodes on each side
+
+	The splitting works on BuildItems, small float copies of the bounds relative to some origin, the nodes themselves are only moved once when the leaves are placed
+*/
+#define SAH_BIN_COUNT 16
+#define PARALLEL_BUILD_MIN_NODES 1024
+
+struct BuildItem {
+	float min[3];
+	float max[3];
+	// index of the node this item stands for
+	uint32_t index;
+
+	// twice the center, no need to divide
+	inline float doubleCenter(int axis) const { return min[axis] + max[axis]; }
+};
+
+struct BuildBounds {
+	float min[3];
+	float max[3];
+
+	inline void setEmpty() {
+		for(int axis = 0; axis < 3; axis++) {
+			min[axis] = std::numeric_limits<float>::infinity();
+			max[axis] = -std::numeric_limits<float>::infinity();
+		}
+	}
+	inline void set(const BuildItem& item) {
+		for(int axis = 0; axis < 3; axis++) {
+			min[axis] = item.min[axis];
+			max[axis] = item.max[axis];
+		}
+	}
+	inline void add(const BuildItem& item) {
+		for(int axis = 0; axis < 3; axis++) {
+			min[axis] = std::min(min[axis], item.min[axis]);
+			max[axis] = std::max(max[axis], item.max[axis]);
+		}
+	}
+	inline void add(const BuildBounds& other) {
+		for(int axis = 0; axis < 3; axis++) {
+			min[axis] = std::min(min[axis], other.min[axis]);
+			max[axis] = std::max(max[axis], other.max[axis]);
+		}
+	}
+	// same metric as computeCost
+	inline float getCost() const {
+		return (max[0] - min[0]) + (max[1] - min[1]) + (max[2] - min[2]);
+	}
+};
+
+struct BuildRange {
+	size_t begin;
+	size_t count;
+};
+
+inline static int getBin(float doubleCenter, float centerMin, float scale) {
+	int bin = static_cast<int>((doubleCenter - centerMin) * scale);
+	return (bin < SAH_BIN_COUNT) ? bin : SAH_BIN_COUNT - 1;
+}
+
+inline static int widestAxisOf(const float* centerMin, const float* centerMax) {
+	int widestAxis = 0;
+	for(int axis = 1; axis < 3; axis++) {
+		if(centerMax[axis] - centerMin[axis] > centerMax[widestAxis] - centerMin[widestAxis]) widestAxis = axis;
+	}
+	return widestAxis;
+}
+
+// for few items, sorting them along one axis and trying every split is cheaper than binning
+static size_t splitSorted(BuildItem* items, size_t count, int axis) {
+	std::sort(items, items + count, [axis](const BuildItem& a, const BuildItem& b) {
+		return a.doubleCenter(axis) < b.doubleCenter(axis);
+	});
+
+	float costOfRight[SAH_BIN_COUNT];
+	BuildBounds rightBounds;
+	rightBounds.set(items[count - 1]);
+	for(size_t i = count - 1; i > 0; i--) {
+		rightBounds.add(items[i]);
+		costOfRight[i] = rightBounds.getCost() * (count - i);
+	}
+
+	float bestCost = std::numeric_limits<float>::infinity();
+	size_t bestSplit = count / 2;
+	BuildBounds leftBounds;
+	leftBounds.set(items[0]);
+	for(size_t split = 1; split < count; split++) {
+		leftBounds.add(items[split - 1]);
+		float cost = leftBounds.getCost() * split + costOfRight[split];
+		if(cost < bestCost) {
+			bestCost = cost;
+			bestSplit = split;
+		}
+	}
+	return bestSplit;
+}
+
+/*
+	Reorders items so that [0, result) and [result, count) are the two halves of the best split found
+	Very uneven splits are replaced by a median split, this keeps the tree well below MAX_HEIGHT
+*/
+static size_t splitBinned(BuildItem* items, size_t count) {
+	assert(count >= 2);
+	if(count == 2) return 1;
+
+	float centerMin[3];
+	float centerMax[3];
+	for(int axis = 0; axis < 3; axis++) {
+		centerMin[axis] = centerMax[axis] = items[0].doubleCenter(axis);
+	}
+	for(size_t i = 1; i < count; i++) {
+		for(int axis = 0; axis < 3; axis++) {
+			float center = items[i].doubleCenter(axis);
+			centerMin[axis] = std::min(centerMin[axis], center);
+			centerMax[axis] = std::max(centerMax[axis], center);
+		}
+	}
+
+	if(count <= SAH_BIN_COUNT) {
+		return splitSorted(items, count, widestAxisOf(centerMin, centerMax));
+	}
+
+	float scale[3];
+	for(int axis = 0; axis < 3; axis++) {
+		float extent = centerMax[axis] - centerMin[axis];
+		scale[axis] = (extent > 0.0f) ? SAH_BIN_COUNT / extent : 0.0f;
+	}
+
+	// all three axes are binned in the same pass over the items
+	size_t binCounts[3][SAH_BIN_COUNT] = {};
+	BuildBounds binBounds[3][SAH_BIN_COUNT];
+	for(int axis = 0; axis < 3; axis++) {
+		for(int bin = 0; bin < SAH_BIN_COUNT; bin++) {
+			binBounds[axis][bin].setEmpty();
+		}
+	}
+	for(size_t i = 0; i < count; i++) {
+		for(int axis = 0; axis < 3; axis++) {
+			int bin = getBin(items[i].doubleCenter(axis), centerMin[axis], scale[axis]);
+			binCounts[axis][bin]++;
+			binBounds[axis][bin].add(items[i]);
+		}
+	}
+
+	float bestCost = std::numeric_limits<float>::infinity();
+	int bestAxis = -1;
+	int bestBin = 0;
+	size_t bestLeftCount = 0;
+	for(int axis = 0; axis < 3; axis++) {
+		if(scale[axis] == 0.0f) continue;
+
+		// costOfRight[b] is the cost of bins [b, SAH_BIN_COUNT) together
+		float costOfRight[SAH_BIN_COUNT];
+		BuildBounds rightBounds;
+		rightBounds.setEmpty();
+		size_t rightCount = 0;
+		for(int bin = SAH_BIN_COUNT - 1; bin > 0; bin--) {
+			if(binCounts[axis][bin] != 0) {
+				if(rightCount == 0) rightBounds = binBounds[axis][bin]; else rightBounds.add(binBounds[axis][bin]);
+				rightCount += binCounts[axis][bin];
+			}
+			costOfRight[bin] = (rightCount == 0) ? 0.0f : rightBounds.getCost() * rightCount;
+		}
+
+		BuildBounds leftBounds;
+		leftBounds.setEmpty();
+		size_t leftCount = 0;
+		for(int bin = 0; bin < SAH_BIN_COUNT - 1; bin++) {
+			if(binCounts[axis][bin] != 0) {
+				if(leftCount == 0) leftBounds = binBounds[axis][bin]; else leftBounds.add(binBounds[axis][bin]);
+				leftCount += binCounts[axis][bin];
+			}
+			if(leftCount == 0 || leftCount == count) continue;
+
+			float cost = leftBounds.getCost() * leftCount + costOfRight[bin + 1];
+			if(cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin + 1;
+				bestLeftCount = leftCount;
+			}
+		}
+	}
+
+	if(bestAxis == -1) {
+		// all centers coincide, any split is as good as any other
+		return count / 2;
+	}
+	size_t smallerSide = std::min(bestLeftCount, count - bestLeftCount);
+	if(smallerSide < count / 4) {
+		int widestAxis = widestAxisOf(centerMin, centerMax);
+		std::nth_element(items, items + count / 2, items + count, [widestAxis](const BuildItem& a, const BuildItem& b) {
+			return a.doubleCenter(widestAxis) < b.doubleCenter(widestAxis);
+		});
+		return count / 2;
+	}
+
+	float axisMin = centerMin[bestAxis];
+	float axisScale = scale[bestAxis];
+	BuildItem* middle = std::partition(items, items + count, [bestAxis, bestBin, axisMin, axisScale](const BuildItem& item) {
+		return getBin(item.doubleCenter(bestAxis), axisMin, axisScale) < bestBin;
+	});
+	return middle - items;
+}
+
+// splits items into up to MAX_BRANCHES consecutive ranges, returns the number of ranges
+static int splitIntoRanges(BuildItem* items, size_t count, BuildRange* ranges) {
+	if(count <= MAX_BRANCHES) {
+		for(size_t i = 0; i < count; i++) {
+			ranges[i] = BuildRange{i, 1};
+		}
+		return static_cast<int>(count);
+	}
+	ranges[0] = BuildRange{0, count};
+	int rangeCount = 1;
+	while(rangeCount < MAX_BRANCHES) {
+		int largest = 0;
+		for(int i = 1; i < rangeCount; i++) {
+			if(ranges[i].count > ranges[largest].count) largest = i;
+		}
+		if(ranges[largest].count < 2) break;
+
+		size_t split = splitBinned(items + ranges[largest].begin, ranges[largest].count);
+
+		// the right half goes right after the range it was split from, so the ranges stay in order
+		for(int i = rangeCount; i > largest + 1; i--) {
+			ranges[i] = ranges[i - 1];
+		}
+		ranges[largest + 1] = BuildRange{ranges[largest].begin + split, ranges[largest].count - split};
+		ranges[largest].count = split;
+		rangeCount++;
+	}
+	return rangeCount;
+}
+
+static TreeNode buildRecursive(BuildItem* items, size_t count, TreeNode* nodes) {
+	if(count == 1) return std::move(nodes[items[0].index]);
+
+	BuildRange ranges[MAX_BRANCHES];
+	int rangeCount = splitIntoRanges(items, count, ranges);
+
+	// allocated before the children, so the arrays end up roughly depth first in memory
+	TreeNode* subTrees = allocateSubTrees();
+	for(int i = 0; i < rangeCount; i++) {
+		subTrees[i] = buildRecursive(items + ranges[i].begin, ranges[i].count, nodes);
+	}
+	return TreeNode(subTrees, rangeCount);
+}
+
+// splits the top two levels on the calling thread, and builds the resulting subtrees on the pool
+static TreeNode buildParallel(BuildItem* items, size_t count, TreeNode* nodes, ThreadPool& pool) {
+	BuildRange topRanges[MAX_BRANCHES];
+	int topCount = splitIntoRanges(items, count, topRanges);
+
+	BuildRange tasks[MAX_BRANCHES * MAX_BRANCHES];
+	int firstTaskOf[MAX_BRANCHES];
+	int taskCountOf[MAX_BRANCHES];
+	int taskCount = 0;
+	for(int i = 0; i < topCount; i++) {
+		BuildRange subRanges[MAX_BRANCHES];
+		firstTaskOf[i] = taskCount;
+		taskCountOf[i] = splitIntoRanges(items + topRanges[i].begin, topRanges[i].count, subRanges);
+		for(int j = 0; j < taskCountOf[i]; j++) {
+			tasks[taskCount++] = BuildRange{topRanges[i].begin + subRanges[j].begin, subRanges[j].count};
+		}
+	}
+
+	std::vector<TreeNode> builtSubTrees(taskCount);
+	pool.parallelFor(taskCount, [&](size_t taskIndex, size_t workerIndex) {
+		builtSubTrees[taskIndex] = buildRecursive(items + tasks[taskIndex].begin, tasks[taskIndex].count, nodes);
+	});
+
+	TreeNode* subTrees = allocateSubTrees();
+	for(int i = 0; i < topCount; i++) {
+		if(taskCountOf[i] == 1) {
+			subTrees[i] = std::move(builtSubTrees[firstTaskOf[i]]);
+		} else {
+			TreeNode* subSubTrees = allocateSubTrees();
+			for(int j = 0; j < taskCountOf[i]; j++) {
+				subSubTrees[j] = std::move(builtSubTrees[firstTaskOf[i] + j]);
+			}
+			subTrees[i] = TreeNode(subSubTrees, taskCountOf[i]);
+		}
+	}
+	return TreeNode(subTrees, topCount);
+}
+
+// moves out every group and loose object of the tree, the nodes that held them are left empty
+static void collectGroups(TreeNode& node, std::vector<TreeNode>& groups) {
+	if(node.isLeafNode() || node.isGroupHead) {
+		groups.push_back(std::move(node));
+	} else {
+		for(TreeNode& subNode : node) {
+			collectGroups(subNode, groups);
+		}
+	}
+}
+
+void buildTreeBinned(TreeNode& rootNode, std::vector<TreeNode>&& nodes, ThreadPool* pool) {
+	if(rootNode.nodeCount != 0) {
+		collectGroups(rootNode, nodes);
+	}
+	rootNode = TreeNode();
+
+	if(nodes.empty()) return;
+
+	// floats are precise enough to choose splits, as long as they are relative to a nearby origin
+	Position origin = nodes[0].bounds.min;
+	std::vector<BuildItem> items(nodes.size());
+	for(size_t i = 0; i < nodes.size(); i++) {
+		Vec3Fix relativeMin = nodes[i].bounds.min - origin;
+		Vec3Fix relativeMax = nodes[i].bounds.max - origin;
+		items[i] = BuildItem{
+			{float(double(relativeMin.x)), float(double(relativeMin.y)), float(double(relativeMin.z))},
+			{float(double(relativeMax.x)), float(double(relativeMax.y)), float(double(relativeMax.z))},
+			static_cast<uint32_t>(i)
+		};
+	}
+
+	if(pool != nullptr && nodes.size() >= PARALLEL_BUILD_MIN_NODES) {
+		rootNode = buildParallel(items.data(), items.size(), nodes.data(), *pool);
+	} else {
+		rootNode = buildRecursive(items.data(), items.size(), nodes.data());
+	}
+}
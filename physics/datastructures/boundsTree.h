@@ -6,15 +6,29 @@
 #include "../math/position.h"
 #include "../math/fix.h"
 #include "../math/bounds.h"
+#include "../templateUtils.h"
 
 #include <utility>
 #include <new>
+#include <vector>
 #include <assert.h>
 #include <stdexcept>
 
+/*
+	The maximum number of children of a node, can be overridden at compile time, for example with -DMAX_BRANCHES=8
+	Wider nodes make for shallower trees, and their children can be tested together with ChildBounds
+*/
+#ifndef MAX_BRANCHES
 #define MAX_BRANCHES 4
+#endif
+// sets of children are stored as bitmasks in an unsigned int
+static_assert(MAX_BRANCHES >= 2 && MAX_BRANCHES <= 16, "MAX_BRANCHES must be between 2 and 16");
 #define MAX_HEIGHT 64
 #define LEAF_NODE_SIGNIFIER 0x7FFFFFFF
+// BoundsTree::buildFrom only rebuilds a tree for batches of at least this fraction of the objects already in it, smaller batches are added one by one
+#define BOUNDS_TREE_REBUILD_MIN_FRACTION 0.5
+// fattened bounds are refit once they stick out more than this many margins past the object, so they shrink again after the object slows down
+#define FAT_BOUNDS_MAX_MARGINS 2.0
 
 struct TreeNode {
 	Bounds bounds;
@@ -72,11 +86,32 @@ struct TreeNode {
 	void improveStructure();
 
 	size_t getNumberOfObjectsInNode() const;
+	// stops counting once limit objects are found, so it only looks at part of large trees
+	size_t getNumberOfObjectsInNodeUpTo(size_t limit) const;
 	size_t getLengthOfLongestBranch() const;
 };
 
 long long computeCost(const Bounds& bounds);
 
+/*
+	subTrees arrays hold MAX_BRANCHES nodes, and come from a shared pool instead of new[] / delete[]
+	allocateSubTrees returns an array of default constructed nodes, freeSubTrees destroys all of them
+*/
+TreeNode* allocateSubTrees();
+void freeSubTrees(TreeNode* subTrees);
+// the number of slabs the pool has taken from the heap
+size_t getSubTreesSlabCount();
+
+void compactDepthFirst(TreeNode& rootNode);
+
+class ThreadPool;
+/*
+	Rebuilds the tree under rootNode top down with a binned SAH build, adding the given nodes
+	Groups already in the tree are taken along whole, as are groups among the new nodes
+	If a pool is given the subtrees below the top two levels are built in parallel
+*/
+void buildTreeBinned(TreeNode& rootNode, std::vector<TreeNode>&& nodes, ThreadPool* pool = nullptr);
+
 //Bounds computeBoundsOfList(const TreeNode* const* list, size_t count);
 
 //Bounds computeBoundsOfList(const TreeNode* list, size_t count);
@@ -167,10 +202,30 @@ struct TreeIterator : public ConstTreeIterator {
 	}
 };
 
+/*
+	Returns a mask with bit i set if the i'th child of node passes the filter
+	Filters may define filterChildren(const TreeNode&) to test all children of a node at once, otherwise every child is passed to the filter separately
+*/
+template<typename Filter>
+inline auto filterChildrenOf(const Filter& filter, const TreeNode& node, choice<1>) -> decltype(filter.filterChildren(node)) {
+	return filter.filterChildren(node);
+}
+template<typename Filter>
+inline unsigned int filterChildrenOf(const Filter& filter, const TreeNode& node, choice<0>) {
+	unsigned int result = 0;
+	for(int i = 0; i < node.nodeCount; i++) {
+		if(filter(node[i])) {
+			result |= 1U << i;
+		}
+	}
+	return result;
+}
+
 /*
 	Iterates through the tree, applying Filter at every level to cull branches that should not be searched
 
 	Filter must define an operator(Bounds) returning true if the filter passes for this bound, and false if it does not.
+	Optionally it may define filterChildren(const TreeNode&), see filterChildrenOf
 
 	For correct operation, it must abide by the following:
 	- If the filter returns true for some bound, then it must also return true for any bound fully encompassing the first bound. 
@@ -189,35 +244,42 @@ struct TreeIterator : public ConstTreeIterator {
 template<typename Filter>
 struct FilteredTreeIterator : public NodeStack {
 	Filter filter;
+	// for every non leaf node on the stack, which of it's children passed the filter
+	unsigned int passedChildren[MAX_HEIGHT];
+
 	FilteredTreeIterator(TreeNode& rootNode, const Filter& filter) : NodeStack(rootNode), filter(filter) {
 		// the very first element is a dummy, in order to detect when the tree is done
 		if (rootNode.nodeCount == 0) return;
 
-		if(!rootNode.isLeafNode())
+		if(!rootNode.isLeafNode()) {
+			passedChildren[0] = filterChildrenOf(this->filter, rootNode, choice<1>());
 			delveDownFiltered();
+		}
 	}
 
 	void delveDownFiltered() {
 		while (true) {
+			unsigned int passed = passedChildren[top - stack];
+			while (top->index < top->node->nodeCount && !(passed & (1U << top->index))) {
+				top->index++;
+			}
+			if (top->index == top->node->nodeCount) {
+				top--;
+				if (top < stack) return;
+				top->index++;
+				continue;
+			}
+
 			// go down
 			TreeNode* nextNode = &top->node->subTrees[top->index];
 			top++;
 			top->node = nextNode;
 
-			if (filter(*nextNode)) {
-				if (nextNode->isLeafNode()) {
-					return;
-				} else {
-					top->index = 0;
-				}
+			if (nextNode->isLeafNode()) {
+				return;
 			} else {
-				top--;
-				top->index++;
-				while (top->index == top->node->nodeCount) {
-					top--;
-					if (top < stack) return;
-					top->index++;
-				}
+				top->index = 0;
+				passedChildren[top - stack] = filterChildrenOf(filter, *nextNode, choice<1>());
 			}
 		}
 	}
@@ -234,7 +296,11 @@ struct FilteredTreeIterator : public NodeStack {
 	}
 	inline TreeNode remove() {
 		TreeNode result = NodeStack::remove();
-		if(top >= stack) {
+		if(top >= stack && !top->node->isLeafNode()) {
+			// removing may shuffle children and shrink bounds all along the stack
+			for(TreeStackElement* level = stack; level <= top; level++) {
+				passedChildren[level - stack] = filterChildrenOf(filter, *level->node, choice<1>());
+			}
 			delveDownFiltered();
 		}
 		return result;
@@ -391,6 +457,40 @@ struct BoundsTree {
 		return iter.remove();
 	}
 
+	/*
+		Returns true if the bounds of node changed
+		A leaf with a margin keeps its bounds for as long as the object still fits in them and they aren't more than FAT_BOUNDS_MAX_MARGINS margins too large,
+		otherwise it gets the object's bounds expanded by the margin
+	*/
+	template<typename SkipGroup, typename GetMargin, typename OnObjectMoved>
+	static bool recalculateBoundsSkippingGroups(TreeNode& node, const SkipGroup& skipGroup, const GetMargin& getMargin, const OnObjectMoved& onObjectMoved) {
+		if(node.isGroupHead) {
+			TreeNode* firstLeaf = &node;
+			while(!firstLeaf->isLeafNode()) firstLeaf = &firstLeaf->subTrees[0];
+			if(skipGroup(*static_cast<Boundable*>(firstLeaf->object))) return false;
+		}
+		if(node.isLeafNode()) {
+			Boundable* obj = static_cast<Boundable*>(node.object);
+			Bounds newBounds = obj->getBounds();
+			double margin = getMargin(*obj);
+			if(margin > 0.0) {
+				if(node.bounds.contains(newBounds) && newBounds.expanded(margin * FAT_BOUNDS_MAX_MARGINS).contains(node.bounds)) return false;
+				newBounds = newBounds.expanded(margin);
+			}
+			if(newBounds == node.bounds) return false;
+			node.bounds = newBounds;
+			onObjectMoved(*obj);
+			return true;
+		} else {
+			bool anyChanged = false;
+			for(TreeNode& subNode : node) {
+				if(recalculateBoundsSkippingGroups(subNode, skipGroup, getMargin, onObjectMoved)) anyChanged = true;
+			}
+			if(anyChanged) node.recalculateBoundsFromSubBounds();
+			return anyChanged;
+		}
+	}
+
 	inline void recalculateBounds() {
 		if(isEmpty()) return;
 		for (TreeNode* currentNode : *this) {
@@ -401,6 +501,36 @@ struct BoundsTree {
 		rootNode.recalculateBoundsRecursive();
 	}
 	
+	/*
+		Like recalculateBounds, but leaves the bounds of a group untouched if skipGroup returns true for its first object
+	*/
+	template<typename SkipGroup>
+	inline void recalculateBounds(const SkipGroup& skipGroup) {
+		if(isEmpty()) return;
+		recalculateBoundsSkippingGroups(rootNode, skipGroup, [](const Boundable&) {return 0.0; }, [](Boundable&) {});
+	}
+	
+	/*
+		Like recalculateBounds(skipGroup), also calls onObjectMoved for every object of which the bounds changed
+	*/
+	template<typename SkipGroup, typename OnObjectMoved>
+	inline void recalculateBounds(const SkipGroup& skipGroup, const OnObjectMoved& onObjectMoved) {
+		if(isEmpty()) return;
+		recalculateBoundsSkippingGroups(rootNode, skipGroup, [](const Boundable&) {return 0.0; }, onObjectMoved);
+	}
+
+	/*
+		Like recalculateBounds(skipGroup, onObjectMoved), but the bounds of objects are stored expanded by getMargin(object) on all sides, 
+		like the fat bounds of a dynamic AABB tree
+		The bounds of a leaf and its ancestors are only updated when the object has moved out of its stored bounds, or the stored bounds have grown too large for its margin
+		Returns true if any bounds changed, if not the structure of the tree doesn't need to be improved either
+	*/
+	template<typename SkipGroup, typename GetMargin, typename OnObjectMoved>
+	inline bool recalculateFattenedBounds(const SkipGroup& skipGroup, const GetMargin& getMargin, const OnObjectMoved& onObjectMoved) {
+		if(isEmpty()) return false;
+		return recalculateBoundsSkippingGroups(rootNode, skipGroup, getMargin, onObjectMoved);
+	}
+
 	inline void updateObjectBounds(const Boundable* obj, const Bounds& oldBounds) {
 		assert(!isEmpty());
 		NodeStack stack(rootNode, obj, oldBounds);
@@ -423,6 +553,37 @@ struct BoundsTree {
 	}
 
 	inline void improveStructure() { if(!isEmpty()) rootNode.improveStructure(); }
+	/*
+		Adds all given objects at once, rebuilding the tree around them with buildTreeBinned
+		This is much faster than adding them one by one, and gives a better tree
+		Rebuilding takes time for every object in the tree though, so batches smaller than BOUNDS_TREE_REBUILD_MIN_FRACTION of the tree are added one by one instead
+		objectsAndBounds is a range of std::pair<Boundable*, Bounds>, or anything else with first and second
+	*/
+	template<typename Range>
+	void buildFrom(const Range& objectsAndBounds, ThreadPool* pool = nullptr) {
+		std::vector<TreeNode> nodes;
+		for(const auto& objectAndBounds : objectsAndBounds) {
+			nodes.emplace_back(static_cast<Boundable*>(objectAndBounds.first), objectAndBounds.second, true);
+		}
+		buildFromNodes(std::move(nodes), pool);
+	}
+	// same as buildFrom, for ready made nodes or groups
+	void buildFromNodes(std::vector<TreeNode>&& nodes, ThreadPool* pool = nullptr) {
+		size_t rebuildMaxObjects = static_cast<size_t>(nodes.size() / BOUNDS_TREE_REBUILD_MIN_FRACTION);
+		if(isEmpty() || rootNode.getNumberOfObjectsInNodeUpTo(rebuildMaxObjects + 1) <= rebuildMaxObjects) {
+			buildTreeBinned(rootNode, std::move(nodes), pool);
+		} else {
+			for(TreeNode& node : nodes) {
+				add(std::move(node));
+			}
+		}
+	}
+	// rebuilds the whole tree with buildTreeBinned, invalidates all pointers into the tree
+	void rebuild(ThreadPool* pool = nullptr) {
+		buildTreeBinned(rootNode, std::vector<TreeNode>(), pool);
+	}
+	// lays out the nodes of the tree in depth first order in memory, invalidates all pointers into the tree
+	inline void compact() { compactDepthFirst(rootNode); }
 	
 	inline size_t getNumberOfObjects() const {
 		if(isEmpty()) {
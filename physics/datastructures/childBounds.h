@@ -0,0 +1,114 @@
+#pragma once
+
+#include "boundsTree.h"
+
+#include <cstdint>
+#include <limits>
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+// children are tested in blocks of 4, one AVX register of 64 bit values per block
+#define CHILD_BOUNDS_BLOCK 4
+#define CHILD_BOUNDS_WIDTH ((MAX_BRANCHES + CHILD_BOUNDS_BLOCK - 1) / CHILD_BOUNDS_BLOCK * CHILD_BOUNDS_BLOCK)
+
+/*
+	The bounds of the children of a node, laid out as structure of arrays, so one bounds can be tested against all children at once
+	The raw fixed point values are kept, slots past nodeCount hold inverted bounds which never intersect anything
+*/
+struct alignas(32) ChildBounds {
+	int64_t minX[CHILD_BOUNDS_WIDTH];
+	int64_t minY[CHILD_BOUNDS_WIDTH];
+	int64_t minZ[CHILD_BOUNDS_WIDTH];
+	int64_t maxX[CHILD_BOUNDS_WIDTH];
+	int64_t maxY[CHILD_BOUNDS_WIDTH];
+	int64_t maxZ[CHILD_BOUNDS_WIDTH];
+	int nodeCount;
+
+	inline explicit ChildBounds(const TreeNode& node) : nodeCount(node.nodeCount) {
+		assert(!node.isLeafNode());
+		for(int i = 0; i < node.nodeCount; i++) {
+			const Bounds& b = node[i].bounds;
+			minX[i] = b.min.x.value; minY[i] = b.min.y.value; minZ[i] = b.min.z.value;
+			maxX[i] = b.max.x.value; maxY[i] = b.max.y.value; maxZ[i] = b.max.z.value;
+		}
+		for(int i = node.nodeCount; i < CHILD_BOUNDS_WIDTH; i++) {
+			minX[i] = minY[i] = minZ[i] = std::numeric_limits<int64_t>::max();
+			maxX[i] = maxY[i] = maxZ[i] = std::numeric_limits<int64_t>::min();
+		}
+	}
+
+	inline unsigned int getChildMask() const { return (1U << nodeCount) - 1; }
+};
+
+/*
+	ChildBounds converted to doubles relative to some origin, for tests that need floating point math such as rays and view frustums
+	Slots past nodeCount are undefined, results for them must be masked out with getChildMask
+*/
+struct alignas(32) RelativeChildBounds {
+	double minX[CHILD_BOUNDS_WIDTH];
+	double minY[CHILD_BOUNDS_WIDTH];
+	double minZ[CHILD_BOUNDS_WIDTH];
+	double maxX[CHILD_BOUNDS_WIDTH];
+	double maxY[CHILD_BOUNDS_WIDTH];
+	double maxZ[CHILD_BOUNDS_WIDTH];
+	int nodeCount;
+
+	inline RelativeChildBounds(const TreeNode& node, const Position& origin) : nodeCount(node.nodeCount) {
+		assert(!node.isLeafNode());
+		for(int i = 0; i < node.nodeCount; i++) {
+			Vec3Fix relMin = node[i].bounds.min - origin;
+			Vec3Fix relMax = node[i].bounds.max - origin;
+			minX[i] = relMin.x; minY[i] = relMin.y; minZ[i] = relMin.z;
+			maxX[i] = relMax.x; maxY[i] = relMax.y; maxZ[i] = relMax.z;
+		}
+		for(int i = node.nodeCount; i < CHILD_BOUNDS_WIDTH; i++) {
+			minX[i] = minY[i] = minZ[i] = 0.0;
+			maxX[i] = maxY[i] = maxZ[i] = 0.0;
+		}
+	}
+
+	inline unsigned int getChildMask() const { return (1U << nodeCount) - 1; }
+};
+
+/*
+	Returns a mask with bit i set if child i intersects bounds
+*/
+inline unsigned int intersectingChildren(const ChildBounds& children, const Bounds& bounds) {
+#ifdef __AVX2__
+	__m256i boundsMinX = _mm256_set1_epi64x(bounds.min.x.value);
+	__m256i boundsMinY = _mm256_set1_epi64x(bounds.min.y.value);
+	__m256i boundsMinZ = _mm256_set1_epi64x(bounds.min.z.value);
+	__m256i boundsMaxX = _mm256_set1_epi64x(bounds.max.x.value);
+	__m256i boundsMaxY = _mm256_set1_epi64x(bounds.max.y.value);
+	__m256i boundsMaxZ = _mm256_set1_epi64x(bounds.max.z.value);
+
+	unsigned int separatedMask = 0;
+	for(int block = 0; block < children.nodeCount; block += CHILD_BOUNDS_BLOCK) {
+		// a child is separated if on any axis it lies entirely on one side of bounds
+		__m256i separated = _mm256_cmpgt_epi64(boundsMinX, _mm256_load_si256(reinterpret_cast<const __m256i*>(children.maxX + block)));
+		separated = _mm256_or_si256(separated, _mm256_cmpgt_epi64(boundsMinY, _mm256_load_si256(reinterpret_cast<const __m256i*>(children.maxY + block))));
+		separated = _mm256_or_si256(separated, _mm256_cmpgt_epi64(boundsMinZ, _mm256_load_si256(reinterpret_cast<const __m256i*>(children.maxZ + block))));
+		separated = _mm256_or_si256(separated, _mm256_cmpgt_epi64(_mm256_load_si256(reinterpret_cast<const __m256i*>(children.minX + block)), boundsMaxX));
+		separated = _mm256_or_si256(separated, _mm256_cmpgt_epi64(_mm256_load_si256(reinterpret_cast<const __m256i*>(children.minY + block)), boundsMaxY));
+		separated = _mm256_or_si256(separated, _mm256_cmpgt_epi64(_mm256_load_si256(reinterpret_cast<const __m256i*>(children.minZ + block)), boundsMaxZ));
+
+		separatedMask |= static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(separated))) << block;
+	}
+	return ~separatedMask & children.getChildMask();
+#else
+	unsigned int result = 0;
+	for(int i = 0; i < children.nodeCount; i++) {
+		if(children.maxX[i] >= bounds.min.x.value && children.maxY[i] >= bounds.min.y.value && children.maxZ[i] >= bounds.min.z.value &&
+		   children.minX[i] <= bounds.max.x.value && children.minY[i] <= bounds.max.y.value && children.minZ[i] <= bounds.max.z.value) {
+			result |= 1U << i;
+		}
+	}
+	return result;
+#endif
+}
+
+inline unsigned int intersectingChildren(const TreeNode& node, const Bounds& bounds) {
+	return intersectingChildren(ChildBounds(node), bounds);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+/*
+	Hands snapshots from a single writer to any number of readers, without locks
+
+	The writer fills a snapshot returned by beginWrite and makes it visible with publish, readers hold on to the latest published snapshot with a Reader
+	A snapshot is only rewritten when it is neither the published one nor held by a reader,
+	so usually two snapshots take turns, a new one is only allocated when a reader still holds the previous one by the time the next one is written
+	Neither side ever waits for the other, a reader only retries when a new snapshot was published between loading it and registering itself
+*/
+template<typename Snapshot>
+class SnapshotExchange {
+	struct Slot {
+		Snapshot snapshot;
+		std::atomic<size_t> readerCount{0};
+	};
+
+	// only used by the writer, slots are never freed before the exchange is, so readers can always safely unregister
+	std::vector<std::unique_ptr<Slot>> slots;
+	Slot* writing = nullptr;
+	std::atomic<Slot*> published{nullptr};
+
+public:
+	SnapshotExchange() {
+		slots.emplace_back(new Slot());
+		slots.emplace_back(new Slot());
+	}
+
+	SnapshotExchange(const SnapshotExchange&) = delete;
+	SnapshotExchange(SnapshotExchange&&) = delete;
+	SnapshotExchange& operator=(const SnapshotExchange&) = delete;
+	SnapshotExchange& operator=(SnapshotExchange&&) = delete;
+
+	/*
+		Returns a snapshot no reader can see, to be filled and then published
+		It still holds whatever it was last filled with, so its buffers can be reused
+	*/
+	Snapshot& beginWrite() {
+		Slot* current = published.load();
+		for(std::unique_ptr<Slot>& slot : slots) {
+			if(slot.get() != current && slot->readerCount.load() == 0) {
+				writing = slot.get();
+				return writing->snapshot;
+			}
+		}
+		slots.emplace_back(new Slot());
+		writing = slots.back().get();
+		return writing->snapshot;
+	}
+
+	/*
+		Makes the snapshot returned by the last beginWrite the one new Readers get
+	*/
+	void publish() {
+		published.store(writing);
+		writing = nullptr;
+	}
+
+	inline size_t getSnapshotCount() const { return slots.size(); }
+
+	/*
+		Holds on to the snapshot that was published when it was created, the writer won't touch it until the Reader is destroyed
+	*/
+	class Reader {
+		Slot* slot;
+	public:
+		Reader(const SnapshotExchange& exchange) : slot(exchange.published.load()) {
+			while(slot != nullptr) {
+				slot->readerCount.fetch_add(1);
+				// if the slot is still published, the writer can't have picked it after seeing our registration
+				Slot* current = exchange.published.load();
+				if(current == slot) break;
+				slot->readerCount.fetch_sub(1);
+				slot = current;
+			}
+		}
+		~Reader() {
+			if(slot != nullptr) slot->readerCount.fetch_sub(1);
+		}
+
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		// false before the first publish
+		inline bool hasSnapshot() const { return slot != nullptr; }
+		inline const Snapshot& operator*() const { return slot->snapshot; }
+		inline const Snapshot* operator->() const { return &slot->snapshot; }
+	};
+};
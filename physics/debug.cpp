@@ -7,20 +7,45 @@
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <mutex>
 
 #include "../util/log.h"
 #include "misc/toString.h"
 
 namespace Debug {
-	void(*logVecAction)(Position, Vec3, VectorType) = [](Position, Vec3, VectorType) {};
-	void(*logPointAction)(Position, PointType) = [](Position, PointType) {};
-	void(*logCFrameAction)(CFrame, CFrameType) = [](CFrame, CFrameType) {};
-	void(*logShapeAction)(const Polyhedron&, const GlobalCFrame&) = [](const Polyhedron&, const GlobalCFrame&) {};
+	static void noVecLog(Position, Vec3, VectorType) {}
+	static void noPointLog(Position, PointType) {}
+	static void noCFrameLog(CFrame, CFrameType) {}
+	static void noShapeLog(const Polyhedron&, const GlobalCFrame&) {}
+
+	void(*logVecAction)(Position, Vec3, VectorType) = noVecLog;
+	void(*logPointAction)(Position, PointType) = noPointLog;
+	void(*logCFrameAction)(CFrame, CFrameType) = noCFrameLog;
+	void(*logShapeAction)(const Polyhedron&, const GlobalCFrame&) = noShapeLog;
+
+	// colissions may be handled on several threads at once, the log actions themselves don't have to be thread safe
+	static std::mutex logMutex;
 	
-	void logVector(Position origin, Vec3 vec, VectorType type) { logVecAction(origin, vec, type); };
-	void logPoint(Position point, PointType type) { logPointAction(point, type); }
-	void logCFrame(CFrame frame, CFrameType type) { logCFrameAction(frame, type); };
-	void logShape(const Polyhedron& shape, const GlobalCFrame& location) { logShapeAction(shape, location); };
+	void logVector(Position origin, Vec3 vec, VectorType type) {
+		if(logVecAction == noVecLog) return;
+		std::lock_guard<std::mutex> lock(logMutex);
+		logVecAction(origin, vec, type);
+	};
+	void logPoint(Position point, PointType type) {
+		if(logPointAction == noPointLog) return;
+		std::lock_guard<std::mutex> lock(logMutex);
+		logPointAction(point, type);
+	}
+	void logCFrame(CFrame frame, CFrameType type) {
+		if(logCFrameAction == noCFrameLog) return;
+		std::lock_guard<std::mutex> lock(logMutex);
+		logCFrameAction(frame, type);
+	};
+	void logShape(const Polyhedron& shape, const GlobalCFrame& location) {
+		if(logShapeAction == noShapeLog) return;
+		std::lock_guard<std::mutex> lock(logMutex);
+		logShapeAction(shape, location);
+	};
 
 	void setVectorLogAction(void(*logger)(Position origin, Vec3 vec, VectorType type)) { logVecAction = logger; };
 	void setPointLogAction(void(*logger)(Position point, PointType type)) { logPointAction = logger; }
@@ -0,0 +1,240 @@
+#include "dynamicsStore.h"
+
+#include "physical.h"
+#include "rigidBody.h"
+#include "math/linalg/mat.h"
+#include "math/rotation.h"
+#include "math/globalCFrame.h"
+
+#include <cmath>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+void DynamicsStore::resizeArrays(size_t paddedSize) {
+	for(int i = 0; i < 3; i++) {
+		velocity[i].resize(paddedSize, 0.0);
+		angularVelocity[i].resize(paddedSize, 0.0);
+		force[i].resize(paddedSize, 0.0);
+		moment[i].resize(paddedSize, 0.0);
+		localCenterOfMass[i].resize(paddedSize, 0.0);
+		translation[i].resize(paddedSize, 0.0);
+		rotationOffset[i].resize(paddedSize, 0.0);
+	}
+	for(int i = 0; i < 6; i++) {
+		forceResponse[i].resize(paddedSize, 0.0);
+		momentResponse[i].resize(paddedSize, 0.0);
+	}
+	for(int i = 0; i < 9; i++) {
+		// padding slots get the identity rotation, so integrating them stays finite
+		rotation[i].resize(paddedSize, (i % 4 == 0) ? 1.0 : 0.0);
+	}
+}
+
+void DynamicsStore::clear() {
+	physicals.clear();
+}
+
+void DynamicsStore::add(MotorizedPhysical* physical) {
+	physicals.push_back(physical);
+}
+
+void DynamicsStore::prepare() {
+	size_t paddedSize = (physicals.size() + DYNAMICS_STORE_LANES - 1) / DYNAMICS_STORE_LANES * DYNAMICS_STORE_LANES;
+	resizeArrays(paddedSize);
+	// padding slots may hold a physical from an earlier tick, make them still
+	for(size_t slot = physicals.size(); slot < paddedSize; slot++) {
+		for(int i = 0; i < 3; i++) {
+			velocity[i][slot] = angularVelocity[i][slot] = force[i][slot] = moment[i][slot] = 0.0;
+		}
+		for(int i = 0; i < 9; i++) {
+			rotation[i][slot] = (i % 4 == 0) ? 1.0 : 0.0;
+		}
+	}
+}
+
+void DynamicsStore::load(size_t begin, size_t end) {
+	for(size_t slot = begin; slot < end; slot++) {
+		const MotorizedPhysical& phys = *physicals[slot];
+		Vec3 vel = phys.motionOfCenterOfMass.getVelocity();
+		Vec3 angularVel = phys.motionOfCenterOfMass.getAngularVelocity();
+		Mat3 rot = phys.getCFrame().getRotation().asRotationMatrix();
+		for(int i = 0; i < 3; i++) {
+			velocity[i][slot] = vel[i];
+			angularVelocity[i][slot] = angularVel[i];
+			force[i][slot] = phys.totalForce[i];
+			moment[i][slot] = phys.totalMoment[i];
+			localCenterOfMass[i][slot] = phys.totalCenterOfMass[i];
+			for(int j = 0; j < 3; j++) {
+				rotation[i * 3 + j][slot] = rot(i, j);
+			}
+		}
+		const SymmetricMat3& fr = phys.forceResponse;
+		const SymmetricMat3& mr = phys.momentResponse;
+		forceResponse[0][slot] = fr(0, 0); forceResponse[1][slot] = fr(0, 1); forceResponse[2][slot] = fr(0, 2);
+		forceResponse[3][slot] = fr(1, 1); forceResponse[4][slot] = fr(1, 2); forceResponse[5][slot] = fr(2, 2);
+		momentResponse[0][slot] = mr(0, 0); momentResponse[1][slot] = mr(0, 1); momentResponse[2][slot] = mr(0, 2);
+		momentResponse[3][slot] = mr(1, 1); momentResponse[4][slot] = mr(1, 2); momentResponse[5][slot] = mr(2, 2);
+	}
+}
+
+#pragma region integration
+
+/*
+	One slot at a time, used where AVX2 is not available
+*/
+struct ScalarLanes {
+	static constexpr size_t WIDTH = 1;
+	double v;
+
+	ScalarLanes() = default;
+	explicit ScalarLanes(double v) : v(v) {}
+	static ScalarLanes load(const double* ptr) { return ScalarLanes(*ptr); }
+	void store(double* ptr) const { *ptr = v; }
+	double operator[](size_t lane) const { return v; }
+};
+inline ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return ScalarLanes(a.v + b.v); }
+inline ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return ScalarLanes(a.v - b.v); }
+inline ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return ScalarLanes(a.v * b.v); }
+
+#ifdef __AVX2__
+struct AVXLanes {
+	static constexpr size_t WIDTH = 4;
+	__m256d v;
+
+	AVXLanes() = default;
+	AVXLanes(__m256d v) : v(v) {}
+	explicit AVXLanes(double v) : v(_mm256_set1_pd(v)) {}
+	static AVXLanes load(const double* ptr) { return _mm256_loadu_pd(ptr); }
+	void store(double* ptr) const { _mm256_storeu_pd(ptr, v); }
+};
+inline AVXLanes operator+(AVXLanes a, AVXLanes b) { return _mm256_add_pd(a.v, b.v); }
+inline AVXLanes operator-(AVXLanes a, AVXLanes b) { return _mm256_sub_pd(a.v, b.v); }
+inline AVXLanes operator*(AVXLanes a, AVXLanes b) { return _mm256_mul_pd(a.v, b.v); }
+#endif
+
+/*
+	The same steps as MotorizedPhysical::update for a physical without childPhysicals, on Lanes::WIDTH slots at once
+	Without childPhysicals there are no constraints to correct the angular momentum for, and the center of mass does not move within the physical
+*/
+template<typename Lanes>
+static void integrateLanes(DynamicsStore& store, size_t slot, double deltaT) {
+	Lanes dt(deltaT);
+	Lanes half(0.5);
+
+	Lanes r[9];
+	for(int i = 0; i < 9; i++) r[i] = Lanes::load(&store.rotation[i][slot]);
+	Lanes fr[6];
+	Lanes mr[6];
+	for(int i = 0; i < 6; i++) {
+		fr[i] = Lanes::load(&store.forceResponse[i][slot]);
+		mr[i] = Lanes::load(&store.momentResponse[i][slot]);
+	}
+	Lanes fx = Lanes::load(&store.force[0][slot]), fy = Lanes::load(&store.force[1][slot]), fz = Lanes::load(&store.force[2][slot]);
+	Lanes mx = Lanes::load(&store.moment[0][slot]), my = Lanes::load(&store.moment[1][slot]), mz = Lanes::load(&store.moment[2][slot]);
+
+	// accel = forceResponse * totalForce * deltaT
+	Lanes ax = (fr[0] * fx + fr[1] * fy + fr[2] * fz) * dt;
+	Lanes ay = (fr[1] * fx + fr[3] * fy + fr[4] * fz) * dt;
+	Lanes az = (fr[2] * fx + fr[4] * fy + fr[5] * fz) * dt;
+
+	// the moment is brought into local space, where momentResponse is defined, and the result back out
+	Lanes lmx = r[0] * mx + r[3] * my + r[6] * mz;
+	Lanes lmy = r[1] * mx + r[4] * my + r[7] * mz;
+	Lanes lmz = r[2] * mx + r[5] * my + r[8] * mz;
+	Lanes lax = (mr[0] * lmx + mr[1] * lmy + mr[2] * lmz) * dt;
+	Lanes lay = (mr[1] * lmx + mr[3] * lmy + mr[4] * lmz) * dt;
+	Lanes laz = (mr[2] * lmx + mr[4] * lmy + mr[5] * lmz) * dt;
+	Lanes rotAccX = r[0] * lax + r[1] * lay + r[2] * laz;
+	Lanes rotAccY = r[3] * lax + r[4] * lay + r[5] * laz;
+	Lanes rotAccZ = r[6] * lax + r[7] * lay + r[8] * laz;
+
+	Lanes vx = Lanes::load(&store.velocity[0][slot]) + ax;
+	Lanes vy = Lanes::load(&store.velocity[1][slot]) + ay;
+	Lanes vz = Lanes::load(&store.velocity[2][slot]) + az;
+	Lanes wx = Lanes::load(&store.angularVelocity[0][slot]) + rotAccX;
+	Lanes wy = Lanes::load(&store.angularVelocity[1][slot]) + rotAccY;
+	Lanes wz = Lanes::load(&store.angularVelocity[2][slot]) + rotAccZ;
+	vx.store(&store.velocity[0][slot]); vy.store(&store.velocity[1][slot]); vz.store(&store.velocity[2][slot]);
+	wx.store(&store.angularVelocity[0][slot]); wy.store(&store.angularVelocity[1][slot]); wz.store(&store.angularVelocity[2][slot]);
+
+	(vx * dt + ax * dt * dt * half).store(&store.translation[0][slot]);
+	(vy * dt + ay * dt * dt * half).store(&store.translation[1][slot]);
+	(vz * dt + az * dt * dt * half).store(&store.translation[2][slot]);
+
+	// rotationMatrixFromRotationVec, the trigonometry is done per slot
+	Lanes rvx = wx * dt, rvy = wy * dt, rvz = wz * dt;
+	double angleSq[Lanes::WIDTH];
+	(rvx * rvx + rvy * rvy + rvz * rvz).store(angleSq);
+	double sincValues[Lanes::WIDTH];
+	double cosValues[Lanes::WIDTH];
+	double coscValues[Lanes::WIDTH];
+	for(size_t lane = 0; lane < Lanes::WIDTH; lane++) {
+		double angle = std::sqrt(angleSq[lane]);
+		sincValues[lane] = (angleSq[lane] > 1E-20) ? std::sin(angle) / angle : 1 - angleSq[lane] / 6;
+		cosValues[lane] = std::cos(angle);
+		coscValues[lane] = (angleSq[lane] > 1E-20) ? (1 - cosValues[lane]) / angleSq[lane] : 0.5 - angleSq[lane] / 24;
+	}
+	Lanes sinc = Lanes::load(sincValues);
+	Lanes cosAngle = Lanes::load(cosValues);
+	Lanes cosc = Lanes::load(coscValues);
+	Lanes sx = rvx * sinc, sy = rvy * sinc, sz = rvz * sinc;
+	Lanes rot[9]{
+		rvx * rvx * cosc + cosAngle, rvx * rvy * cosc - sz,       rvx * rvz * cosc + sy,
+		rvy * rvx * cosc + sz,       rvy * rvy * cosc + cosAngle, rvy * rvz * cosc - sx,
+		rvz * rvx * cosc - sy,       rvz * rvy * cosc + sx,       rvz * rvz * cosc + cosAngle
+	};
+
+	// rotating around the center of mass moves the main part by rot * relPoint - relPoint
+	Lanes cx = Lanes::load(&store.localCenterOfMass[0][slot]);
+	Lanes cy = Lanes::load(&store.localCenterOfMass[1][slot]);
+	Lanes cz = Lanes::load(&store.localCenterOfMass[2][slot]);
+	Lanes px = r[0] * cx + r[1] * cy + r[2] * cz;
+	Lanes py = r[3] * cx + r[4] * cy + r[5] * cz;
+	Lanes pz = r[6] * cx + r[7] * cy + r[8] * cz;
+	(rot[0] * px + rot[1] * py + rot[2] * pz - px).store(&store.rotationOffset[0][slot]);
+	(rot[3] * px + rot[4] * py + rot[5] * pz - py).store(&store.rotationOffset[1][slot]);
+	(rot[6] * px + rot[7] * py + rot[8] * pz - pz).store(&store.rotationOffset[2][slot]);
+
+	for(int row = 0; row < 3; row++) {
+		for(int col = 0; col < 3; col++) {
+			(rot[row * 3] * r[col] + rot[row * 3 + 1] * r[3 + col] + rot[row * 3 + 2] * r[6 + col]).store(&store.rotation[row * 3 + col][slot]);
+		}
+	}
+}
+
+void DynamicsStore::integrate(size_t begin, size_t end, double deltaT) {
+	assert(begin % DYNAMICS_STORE_LANES == 0);
+#ifdef __AVX2__
+	for(size_t slot = begin; slot < end; slot += AVXLanes::WIDTH) {
+		integrateLanes<AVXLanes>(*this, slot, deltaT);
+	}
+#else
+	for(size_t slot = begin; slot < end; slot++) {
+		integrateLanes<ScalarLanes>(*this, slot, deltaT);
+	}
+#endif
+}
+
+#pragma endregion
+
+void DynamicsStore::store(size_t begin, size_t end) {
+	for(size_t slot = begin; slot < end; slot++) {
+		MotorizedPhysical& phys = *physicals[slot];
+		phys.motionOfCenterOfMass.translation.translation[0] = Vec3(velocity[0][slot], velocity[1][slot], velocity[2][slot]);
+		phys.motionOfCenterOfMass.rotation.rotation[0] = Vec3(angularVelocity[0][slot], angularVelocity[1][slot], angularVelocity[2][slot]);
+		phys.totalForce = Vec3();
+		phys.totalMoment = Vec3();
+
+		Mat3 newRotation{
+			rotation[0][slot], rotation[1][slot], rotation[2][slot],
+			rotation[3][slot], rotation[4][slot], rotation[5][slot],
+			rotation[6][slot], rotation[7][slot], rotation[8][slot]
+		};
+		Position newPosition = phys.getCFrame().getPosition();
+		newPosition -= Vec3Fix(Vec3(rotationOffset[0][slot], rotationOffset[1][slot], rotationOffset[2][slot]));
+		newPosition += Vec3Fix(Vec3(translation[0][slot], translation[1][slot], translation[2][slot]));
+		phys.rigidBody.setCFrame(GlobalCFrame(newPosition, Rotation::fromRotationMatrix(newRotation)));
+	}
+}
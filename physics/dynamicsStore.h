@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+class MotorizedPhysical;
+
+// free physicals are integrated this many at a time, one AVX register of doubles
+#define DYNAMICS_STORE_LANES 4
+
+/*
+	The state MotorizedPhysical::update integrates, for physicals without childPhysicals, laid out as structure of arrays
+	This way the integration runs on DYNAMICS_STORE_LANES physicals at once instead of chasing one physical at a time
+
+	The physicals stay the owners of their state, load copies a range of slots in from their physicals,
+	integrate steps them and store writes the results back and moves the parts
+	Slot i holds physicals[i], the arrays are padded to a whole number of lanes so the last lane never needs special treatment
+*/
+class DynamicsStore {
+	void resizeArrays(size_t paddedSize);
+public:
+	std::vector<MotorizedPhysical*> physicals;
+
+	// vectors are split per component, symmetric matrices store xx, xy, xz, yy, yz, zz, rotations are row major
+	std::vector<double> velocity[3];
+	std::vector<double> angularVelocity[3];
+	std::vector<double> force[3];
+	std::vector<double> moment[3];
+	std::vector<double> forceResponse[6];
+	std::vector<double> momentResponse[6];
+	std::vector<double> rotation[9];
+	std::vector<double> localCenterOfMass[3];
+
+	// results of integrate besides the new velocities and rotation, how far to move the main part
+	std::vector<double> translation[3];
+	std::vector<double> rotationOffset[3];
+
+	void clear();
+	void add(MotorizedPhysical* physical);
+	size_t size() const { return physicals.size(); }
+
+	/*
+		Must be called after adding physicals and before load
+	*/
+	void prepare();
+
+	/*
+		begin and end must be multiples of DYNAMICS_STORE_LANES, except end may be size()
+	*/
+	void load(size_t begin, size_t end);
+	void integrate(size_t begin, size_t end, double deltaT);
+	void store(size_t begin, size_t end);
+};
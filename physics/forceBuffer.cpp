@@ -0,0 +1,85 @@
+#include "forceBuffer.h"
+
+#include "physical.h"
+
+void ForceBuffer::applyForceAtCenterOfMass(MotorizedPhysical& physical, Vec3 force) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::FORCE_AT_CENTER_OF_MASS, Vec3(0.0, 0.0, 0.0), force});
+}
+void ForceBuffer::applyForce(MotorizedPhysical& physical, Vec3 origin, Vec3 force) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::FORCE, origin, force});
+}
+void ForceBuffer::applyMoment(MotorizedPhysical& physical, Vec3 moment) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::MOMENT, Vec3(0.0, 0.0, 0.0), moment});
+}
+void ForceBuffer::applyImpulseAtCenterOfMass(MotorizedPhysical& physical, Vec3 impulse) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::IMPULSE_AT_CENTER_OF_MASS, Vec3(0.0, 0.0, 0.0), impulse});
+}
+void ForceBuffer::applyImpulse(MotorizedPhysical& physical, Vec3 origin, Vec3 impulse) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::IMPULSE, origin, impulse});
+}
+void ForceBuffer::applyAngularImpulse(MotorizedPhysical& physical, Vec3 angularImpulse) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::ANGULAR_IMPULSE, Vec3(0.0, 0.0, 0.0), angularImpulse});
+}
+void ForceBuffer::wakeUp(MotorizedPhysical& physical) {
+	commands.push_back(ForceCommand{&physical, ForceCommandType::WAKE_UP, Vec3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0)});
+}
+
+void ForceBuffer::applyCommands(size_t begin, size_t end) const {
+	for(size_t i = begin; i < end; i++) {
+		const ForceCommand& command = commands[i];
+		MotorizedPhysical& physical = *command.physical;
+		switch(command.type) {
+		case ForceCommandType::FORCE:
+			physical.applyForce(command.origin, command.value);
+			break;
+		case ForceCommandType::FORCE_AT_CENTER_OF_MASS:
+			physical.applyForceAtCenterOfMass(command.value);
+			break;
+		case ForceCommandType::MOMENT:
+			physical.applyMoment(command.value);
+			break;
+		case ForceCommandType::IMPULSE:
+			physical.applyImpulse(command.origin, command.value);
+			break;
+		case ForceCommandType::IMPULSE_AT_CENTER_OF_MASS:
+			physical.applyImpulseAtCenterOfMass(command.value);
+			break;
+		case ForceCommandType::ANGULAR_IMPULSE:
+			physical.applyAngularImpulse(command.value);
+			break;
+		case ForceCommandType::WAKE_UP:
+			physical.wakeUp();
+			break;
+		}
+	}
+}
+
+size_t DeferredForces::addTasks(size_t taskCount, size_t workerCount) {
+	if(workerBuffers.size() < workerCount) {
+		workerBuffers.resize(workerCount);
+	}
+	size_t firstTask = tasks.size();
+	tasks.resize(firstTask + taskCount);
+	return firstTask;
+}
+
+ForceBuffer& DeferredForces::beginTask(size_t taskIndex, size_t workerIndex) {
+	ForceBuffer& buffer = workerBuffers[workerIndex];
+	tasks[taskIndex].worker = workerIndex;
+	tasks[taskIndex].begin = buffer.size();
+	return buffer;
+}
+
+void DeferredForces::endTask(size_t taskIndex, size_t workerIndex) {
+	tasks[taskIndex].end = workerBuffers[workerIndex].size();
+}
+
+void DeferredForces::apply() {
+	for(const TaskCommands& task : tasks) {
+		workerBuffers[task.worker].applyCommands(task.begin, task.end);
+	}
+	tasks.clear();
+	for(ForceBuffer& buffer : workerBuffers) {
+		buffer.clear();
+	}
+}
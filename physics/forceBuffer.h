@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "math/linalg/vec.h"
+
+class MotorizedPhysical;
+
+enum class ForceCommandType : uint8_t {
+	FORCE,
+	FORCE_AT_CENTER_OF_MASS,
+	MOMENT,
+	IMPULSE,
+	IMPULSE_AT_CENTER_OF_MASS,
+	ANGULAR_IMPULSE,
+	WAKE_UP
+};
+
+struct ForceCommand {
+	MotorizedPhysical* physical;
+	ForceCommandType type;
+	Vec3 origin; // only used by FORCE and IMPULSE
+	Vec3 value;
+};
+
+/*
+	Records forces and impulses for MotorizedPhysicals instead of applying them right away
+	Has the same apply methods as MotorizedPhysical, taking the physical to apply to as the first argument, origins are relative to its center of mass
+	Any number of threads can fill their own ForceBuffer at the same time, the commands are applied later in the order they were recorded
+*/
+class ForceBuffer {
+public:
+	std::vector<ForceCommand> commands;
+
+	void applyForceAtCenterOfMass(MotorizedPhysical& physical, Vec3 force);
+	void applyForce(MotorizedPhysical& physical, Vec3 origin, Vec3 force);
+	void applyMoment(MotorizedPhysical& physical, Vec3 moment);
+	void applyImpulseAtCenterOfMass(MotorizedPhysical& physical, Vec3 impulse);
+	void applyImpulse(MotorizedPhysical& physical, Vec3 origin, Vec3 impulse);
+	void applyAngularImpulse(MotorizedPhysical& physical, Vec3 angularImpulse);
+	void wakeUp(MotorizedPhysical& physical);
+
+	inline size_t size() const { return commands.size(); }
+	inline void clear() { commands.clear(); }
+
+	/*
+		Applies commands begin..end to their physicals, in order
+	*/
+	void applyCommands(size_t begin, size_t end) const;
+};
+
+/*
+	Collects the commands of a batch of tasks run on a ThreadPool, in one ForceBuffer per worker
+	Every task remembers which commands it recorded, apply then goes through them task by task
+	So the forces are applied in the same order no matter which worker ran which task, or how many workers there are,
+	and the results are the same as running the tasks one after another on a single thread
+*/
+class DeferredForces {
+	struct TaskCommands {
+		size_t worker;
+		size_t begin;
+		size_t end;
+	};
+
+	std::vector<ForceBuffer> workerBuffers;
+	std::vector<TaskCommands> tasks;
+
+public:
+	/*
+		Makes room for taskCount more tasks, run by at most workerCount workers, returns the index of the first of them
+	*/
+	size_t addTasks(size_t taskCount, size_t workerCount);
+
+	/*
+		Returns the buffer task taskIndex must record its commands in, endTask must be called once the task is done
+	*/
+	ForceBuffer& beginTask(size_t taskIndex, size_t workerIndex);
+	void endTask(size_t taskIndex, size_t workerIndex);
+
+	inline bool isEmpty() const { return tasks.empty(); }
+
+	/*
+		Applies the commands of all tasks in task order, and clears everything for the next batch
+	*/
+	void apply();
+};
@@ -60,13 +60,12 @@ double CubeClass::getScaledMaxRadiusSq(DiagonalMat3 scale) const {
 }
 
 Vec3f CubeClass::furthestInDirection(const Vec3f& direction) const {
-	Vec3f polyresult = asPolyhedron().furthestInDirection(direction);
-	Vec3f result(direction.x < 0 ? -1.0f : 1.0f, direction.y < 0 ? -1.0f : 1.0f, direction.z < 0 ? -1.0f : 1.0f);
-	return polyresult;
+	return Vec3f(direction.x < 0 ? -1.0f : 1.0f, direction.y < 0 ? -1.0f : 1.0f, direction.z < 0 ? -1.0f : 1.0f);
 }
 
 Polyhedron CubeClass::asPolyhedron() const {
-	return Library::createCube(2.0);
+	static const Polyhedron cube = Library::createCube(2.0);
+	return cube;
 }
 
 
@@ -112,7 +111,8 @@ Vec3f SphereClass::furthestInDirection(const Vec3f& direction) const {
 }
 
 Polyhedron SphereClass::asPolyhedron() const {
-	return Library::createSphere(1.0, 3);
+	static const Polyhedron sphere = Library::createSphere(1.0, 3);
+	return sphere;
 }
 
 void SphereClass::setScaleX(double newX, DiagonalMat3& scale) const {
@@ -220,7 +220,8 @@ Vec3f CylinderClass::furthestInDirection(const Vec3f& direction) const {
 }
 
 Polyhedron CylinderClass::asPolyhedron() const {
-	return Library::createPrism(64, 1.0, 2.0);
+	static const Polyhedron prism = Library::createPrism(64, 1.0, 2.0);
+	return prism;
 }
 
 void CylinderClass::setScaleX(double newX, DiagonalMat3& scale) const {
@@ -233,7 +234,7 @@ void CylinderClass::setScaleY(double newY, DiagonalMat3& scale) const {
 	scale[1] = newY;
 }
 
-PolyhedronShapeClass::PolyhedronShapeClass(Polyhedron&& poly) : poly(poly), ShapeClass(poly.getVolume(), poly.getCenterOfMass(), poly.getScalableInertiaAroundCenterOfMass(), CONVEX_POLYHEDRON_CLASS_ID) {}
+PolyhedronShapeClass::PolyhedronShapeClass(Polyhedron&& poly) : ShapeClass(poly.getVolume(), poly.getCenterOfMass(), poly.getScalableInertiaAroundCenterOfMass(), CONVEX_POLYHEDRON_CLASS_ID), poly(poly), supportGraph(poly) {}
 
 bool PolyhedronShapeClass::containsPoint(Vec3 point) const {
 	return poly.containsPoint(point);
@@ -242,7 +243,14 @@ double PolyhedronShapeClass::getIntersectionDistance(Vec3 origin, Vec3 direction
 	return poly.getIntersectionDistance(origin, direction);
 }
 BoundingBox PolyhedronShapeClass::getBounds(const Rotation& rotation, const DiagonalMat3& scale) const {
-	return poly.getBounds(Mat3f(rotation.asRotationMatrix() * scale));
+	Mat3f referenceFrame(rotation.asRotationMatrix() * scale);
+	if(supportGraph.getVertexCount() < SUPPORT_GRAPH_MIN_BOUNDS_VERTICES) return poly.getBounds(referenceFrame);
+
+	Vec3f directions[6];
+	Vec3f furthest[6];
+	getBoundsDirections(referenceFrame, directions);
+	this->furthestInDirections(directions, 6, furthest);
+	return boundsFromFurthest(referenceFrame, furthest);
 }
 double PolyhedronShapeClass::getScaledMaxRadius(DiagonalMat3 scale) const {
 	return poly.getScaledMaxRadius(scale);
@@ -251,8 +259,22 @@ double PolyhedronShapeClass::getScaledMaxRadiusSq(DiagonalMat3 scale) const {
 	return poly.getScaledMaxRadiusSq(scale);
 }
 Vec3f PolyhedronShapeClass::furthestInDirection(const Vec3f& direction) const {
+	if(!supportGraph.isEmpty()) return supportGraph.furthestInDirection(direction);
 	return poly.furthestInDirection(direction);
 }
+Vec3f PolyhedronShapeClass::furthestInDirectionWithHint(const Vec3f& direction, int& hint) const {
+	if(!supportGraph.isEmpty()) return supportGraph.getVertex(supportGraph.furthestIndexFromHint(direction, hint));
+	return poly.furthestInDirection(direction);
+}
+void PolyhedronShapeClass::furthestInDirections(const Vec3f* directions, int count, Vec3f* results) const {
+	if(!supportGraph.isEmpty()) {
+		for(int i = 0; i < count; i++) {
+			results[i] = supportGraph.furthestInDirection(directions[i]);
+		}
+	} else {
+		poly.furthestInDirections(directions, count, results);
+	}
+}
 Polyhedron PolyhedronShapeClass::asPolyhedron() const {
 	return poly;
 }
@@ -2,6 +2,7 @@
 
 #include "polyhedron.h"
 #include "shapeClass.h"
+#include "supportGraph.h"
 
 #define CUBE_CLASS_ID 0
 #define SPHERE_CLASS_ID 1
@@ -60,6 +61,8 @@ public:
 
 class PolyhedronShapeClass : public ShapeClass {
 	Polyhedron poly;
+	// empty for small or concave polyhedra, which are scanned entirely instead
+	SupportGraph supportGraph;
 public:
 	PolyhedronShapeClass(Polyhedron&& poly);
 
@@ -69,5 +72,7 @@ public:
 	virtual double getScaledMaxRadius(DiagonalMat3 scale) const override;
 	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
 	virtual Vec3f furthestInDirection(const Vec3f& direction) const override;
+	virtual Vec3f furthestInDirectionWithHint(const Vec3f& direction, int& hint) const override;
+	virtual void furthestInDirections(const Vec3f* directions, int count, Vec3f* results) const override;
 	virtual Polyhedron asPolyhedron() const override;
 };
@@ -11,12 +11,12 @@ ComputationBuffers::ComputationBuffers(int initialVertCount, int initialTriangle
 
 void ComputationBuffers::ensureCapacity(int vertCapacity, int triangleCapacity) {
 	if(this->vertexCapacity < vertCapacity) {
-		Log::debug("Increasing vertex buffer capacity from %d to %d", this->vertexCapacity, vertCapacity);
+		if(this->vertexCapacity != 0) Log::debug("Increasing vertex buffer capacity from %d to %d", this->vertexCapacity, vertCapacity);
 		deleteVertexBuffers();
 		createVertexBuffersUnsafe(vertCapacity);
 	}
 	if(this->triangleCapacity < triangleCapacity) {
-		Log::debug("Increasing vertex buffer capacity from %d to %d", this->triangleCapacity, triangleCapacity);
+		if(this->triangleCapacity != 0) Log::debug("Increasing triangle buffer capacity from %d to %d", this->triangleCapacity, triangleCapacity);
 		deleteTriangleBuffers();
 		createTriangleBuffersUnsafe(triangleCapacity);
 	}
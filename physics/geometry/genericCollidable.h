@@ -2,6 +2,31 @@
 
 #include "../math/linalg/vec.h"
 
+/*
+	Where the searches for the furthest vertices of the two collidables of a pair start, -1 for no hint
+	Kept per pair, so the searches for one pair never move the starting point of another
+*/
+struct SupportHints {
+	int first = -1;
+	int second = -1;
+};
+
 struct GenericCollidable {
 	virtual Vec3f furthestInDirection(const Vec3f& direction) const = 0;
+	/*
+		Same as furthestInDirection, but starts looking at hint, which then receives where the result was found
+		Only collidables that climb from vertex to vertex use the hint, the others ignore it
+	*/
+	virtual Vec3f furthestInDirectionWithHint(const Vec3f& direction, int& hint) const {
+		return this->furthestInDirection(direction);
+	}
+	/*
+		Writes furthestInDirection(directions[i]) to results[i] for each of the count directions
+		Collidables that go through all their vertices for each query can answer all of them in one pass
+	*/
+	virtual void furthestInDirections(const Vec3f* directions, int count, Vec3f* results) const {
+		for(int i = 0; i < count; i++) {
+			results[i] = this->furthestInDirection(directions[i]);
+		}
+	}
 };
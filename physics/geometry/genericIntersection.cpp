@@ -18,7 +18,8 @@
 #include <stdexcept>
 
 
-inline static void incDebugTally(HistoricTally<long long, IterationTime>& tally, int iterTime) {
+template<typename Tally>
+inline static void addIterationToTally(Tally& tally, int iterTime) {
 	if(iterTime >= GJK_MAX_ITER) {
 		tally.addToTally(IterationTime::LIMIT_REACHED, 1);
 	} else if(iterTime >= 15) {
@@ -28,6 +29,17 @@ inline static void incDebugTally(HistoricTally<long long, IterationTime>& tally,
 	}
 }
 
+/*
+	Counts in statistics on the profiling thread, in the threadTally of narrowphaseIterationTallyOnThisThread on others
+*/
+inline static void incDebugTally(HistoricTally<long long, IterationTime>& statistics, IterationTally NarrowphaseIterationTally::* threadTally, int iterTime) {
+	if(profilePhysicsOnThisThread) {
+		addIterationToTally(statistics, iterTime);
+	} else if(narrowphaseIterationTallyOnThisThread != nullptr) {
+		addIterationToTally(narrowphaseIterationTallyOnThisThread->*threadTally, iterTime);
+	}
+}
+
 static Vec3f getNormalVec(Triangle t, Vec3f* vertices) {
 	Vec3f v0 = vertices[t[0]];
 	Vec3f v1 = vertices[t[1]];
@@ -78,9 +90,9 @@ static int furthestIndexInDirection(Vec3* vertices, int vertexCount, Vec3 direct
 }
 
 static MinkPoint getSupport(const ColissionPair& info, const Vec3f& searchDirection) {
-	Vec3f furthest1 = info.scaleFirst * info.first.furthestInDirection(info.scaleFirst * searchDirection);  // in local space of first
+	Vec3f furthest1 = info.scaleFirst * info.first.furthestInDirectionWithHint(info.scaleFirst * searchDirection, info.supportHints.first);  // in local space of first
 	Vec3f transformedSearchDirection = -info.transform.relativeToLocal(searchDirection);
-	Vec3f furthest2 = info.scaleSecond * info.second.furthestInDirection(info.scaleSecond * transformedSearchDirection);  // in local space of second
+	Vec3f furthest2 = info.scaleSecond * info.second.furthestInDirectionWithHint(info.scaleSecond * transformedSearchDirection, info.supportHints.second);  // in local space of second
 	Vec3f secondVertex = info.transform.localToGlobal(furthest2);  // converted to local space of first
 
 	/*catchable_assert(isVecValid(furthest1));
@@ -91,10 +103,16 @@ static MinkPoint getSupport(const ColissionPair& info, const Vec3f& searchDirect
 	return MinkPoint{ furthest1 - secondVertex, furthest1, secondVertex };  // local to first
 }
 
-std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f searchDirection) {
+std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f& searchDirection) {
 	MinkPoint A(getSupport(info, searchDirection));
 	MinkPoint B, C, D;
 
+	// the furthest point in searchDirection lies behind the origin, searchDirection is a separating axis
+	if (A.p * searchDirection < 0) {
+		incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, 0);
+		return std::optional<Tetrahedron>();
+	}
+
 	// set new searchdirection to be straight at the origin
 	searchDirection = -A.p;
 
@@ -106,7 +124,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 	// Just one test, to see if the line segment or A is closer
 	B = getSupport(info, searchDirection);
 	if (B.p * searchDirection < 0) {
-		incDebugTally(GJKNoCollidesIterationStatistics, 0);
+		incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, 0);
 		return std::optional<Tetrahedron>();
 	}
 
@@ -116,7 +134,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 
 	C = getSupport(info, searchDirection);
 	if (C.p * searchDirection < 0) {
-		incDebugTally(GJKNoCollidesIterationStatistics, 1);
+		incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, 1);
 		return std::optional<Tetrahedron>();
 	}
 	// s.A is C.p  newest
@@ -138,7 +156,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 			searchDirection = -(AO % AB) % AB;
 			C = getSupport(info, searchDirection);
 			if(C.p * searchDirection < 0) {
-				incDebugTally(GJKNoCollidesIterationStatistics, iter+2);
+				incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, iter+2);
 				return std::optional<Tetrahedron>();
 			}
 		} else {
@@ -148,7 +166,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 				searchDirection = -(AO % AC) % AC;
 				C = getSupport(info, searchDirection);
 				if(C.p * searchDirection < 0) {
-					incDebugTally(GJKNoCollidesIterationStatistics, iter + 2);
+					incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, iter + 2);
 					return std::optional<Tetrahedron>();
 				}
 			} else {
@@ -171,7 +189,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 				// s.D is A.p
 				D = getSupport(info, searchDirection);
 				if(D.p * searchDirection < 0) {
-					incDebugTally(GJKNoCollidesIterationStatistics, iter + 2);
+					incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, iter + 2);
 					return std::optional<Tetrahedron>();
 				}
 				Vec3f AO = -D.p;
@@ -203,7 +221,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 						} else {
 							// GOTCHA! TETRAHEDRON COVERS THE ORIGIN!
 
-							incDebugTally(GJKCollidesIterationStatistics, iter + 2);
+							incDebugTally(GJKCollidesIterationStatistics, &NarrowphaseIterationTally::gjkCollides, iter + 2);
 							return std::optional<Tetrahedron>(Tetrahedron{D, C, B, A});
 						}
 					}
@@ -213,7 +231,7 @@ std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f se
 	}
 
 	Log::warn("GJK iteration limit reached!");
-	incDebugTally(GJKNoCollidesIterationStatistics, GJK_MAX_ITER + 2);
+	incDebugTally(GJKNoCollidesIterationStatistics, &NarrowphaseIterationTally::gjkNoCollides, GJK_MAX_ITER + 2);
 	return std::optional<Tetrahedron>();
 }
 
@@ -235,6 +253,8 @@ void initializeBuffer(const Tetrahedron& s, ComputationBuffers& b) {
 }
 
 bool runEPATransformed(const ColissionPair& info, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs) {
+	// every iteration adds at most one vertex, a closed triangle mesh has about 2*vertexCount triangles, leave room for degenerate horizons
+	bufs.ensureCapacity(EPA_MAX_ITER + 4, 4 * (EPA_MAX_ITER + 4));
 	initializeBuffer(s, bufs);
 
 	ConvexShapeBuilder builder(bufs.vertBuf, bufs.triangleBuf, 4, 4, bufs.neighborBuf, bufs.removalBuf, bufs.edgeBuf);
@@ -299,12 +319,12 @@ bool runEPATransformed(const ColissionPair& info, const Tetrahedron& s, Vec3f& i
 
 			// intersection = (avgFirst + relativeCFrame.localToGlobal(avgSecond)) / 2;
 			intersection = (avgFirst + avgSecond) * 0.5f;
-			incDebugTally(EPAIterationStatistics, iter);
+			incDebugTally(EPAIterationStatistics, &NarrowphaseIterationTally::epa, iter);
 			return true;
 		}
 	}
 
 	Log::warn("EPA iteration limit exceeded! ");
-	incDebugTally(EPAIterationStatistics, EPA_MAX_ITER);
+	incDebugTally(EPAIterationStatistics, &NarrowphaseIterationTally::epa, EPA_MAX_ITER);
 	return false;
 }
@@ -53,7 +53,12 @@ struct ColissionPair {
 	CFramef transform;
 	DiagonalMat3f scaleFirst;
 	DiagonalMat3f scaleSecond;
+	SupportHints& supportHints;
 };
 
-std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& colissionPair, Vec3f initialSearchDirection);
+/*
+	searchDirection is the direction GJK starts searching in, it is left at the direction GJK ended with
+	For a pair that doesn't collide that is a separating axis, which lets GJK quit right away the next time the pair is tested
+*/
+std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& colissionPair, Vec3f& searchDirection);
 bool runEPATransformed(const ColissionPair& colissionPair, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs);
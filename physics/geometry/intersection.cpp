@@ -10,26 +10,64 @@
 
 #include "../misc/validityHelper.h"
 #include "shapeClass.h"
+#include "shapePairIntersection.h"
 
 #include "../catchable_assert.h"
 
 #include <algorithm>
 
-std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform) {
-	return intersectsTransformed(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale);
+std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	Vec3f searchDirection(0.0f, 0.0f, 0.0f);
+	SupportHints supportHints;
+	return intersectsTransformed(first, second, relativeTransform, scaleFirst, scaleSecond, searchDirection, supportHints);
 }
 
 
-ComputationBuffers buffers(1000, 2000);
+/*
+	Every thread that runs intersection tests gets its own buffers, 
+	they start out empty and are grown by the first EPA run on that thread, then reused for the lifetime of the thread
+*/
+static ComputationBuffers& getThreadLocalBuffers() {
+	thread_local ComputationBuffers buffers(0, 0);
+	return buffers;
+}
 
-std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
-	ColissionPair info{first, second, relativeTransform, scaleFirst, scaleSecond};
-	physicsMeasure.mark(PhysicsProcess::GJK_COL);
-	std::optional collides = runGJKTransformed(info, -relativeTransform.position);
+inline static void markPhysics(PhysicsProcess process) {
+	if(profilePhysicsOnThisThread) physicsMeasure.mark(process);
+}
+inline static void markPhysics(PhysicsProcess process, PhysicsProcess overrideOldProcess) {
+	if(profilePhysicsOnThisThread) physicsMeasure.mark(process, overrideOldProcess);
+}
+
+std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform) {
+	Vec3f searchDirection(0.0f, 0.0f, 0.0f);
+	SupportHints supportHints;
+	return intersectsTransformed(first, second, relativeTransform, searchDirection, supportHints);
+}
+
+std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform, Vec3f& searchDirection, SupportHints& supportHints) {
+	ShapePairIntersector intersector = getShapePairIntersector(first.baseShape->intersectionClassID, second.baseShape->intersectionClassID);
+	if(intersector != nullptr) {
+		markPhysics(PhysicsProcess::SHAPE_PAIR);
+		return intersector(relativeTransform, first.scale, second.scale);
+	}
+	return intersectsTransformed(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale, searchDirection, supportHints);
+}
+
+std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, Vec3f& searchDirection, SupportHints& supportHints) {
+	ColissionPair info{first, second, relativeTransform, scaleFirst, scaleSecond, supportHints};
+	markPhysics(PhysicsProcess::GJK_COL);
+	if(searchDirection == Vec3f(0.0f, 0.0f, 0.0f)) {
+		searchDirection = -relativeTransform.position;
+	}
+	std::optional collides = runGJKTransformed(info, searchDirection);
+	if(lengthSquared(searchDirection) > 0.0f) {
+		searchDirection = normalize(searchDirection);
+	}
 
 	if(collides) {
 		Tetrahedron& result = collides.value();
-		physicsMeasure.mark(PhysicsProcess::EPA);
+		markPhysics(PhysicsProcess::EPA);
 		Vec3f intersection;
 		Vec3f exitVector;
 
@@ -55,7 +93,7 @@ std::optional<Intersection> intersectsTransformed(const GenericCollidable& first
 		catchable_assert(isVecValid(result.D.originFirst));
 		catchable_assert(isVecValid(result.D.originSecond));
 
-		bool epaResult = runEPATransformed(info, result, intersection, exitVector, buffers);
+		bool epaResult = runEPATransformed(info, result, intersection, exitVector, getThreadLocalBuffers());
 
 		catchable_assert(isVecValid(exitVector));
 		if(!epaResult) {
@@ -64,7 +102,7 @@ std::optional<Intersection> intersectsTransformed(const GenericCollidable& first
 			return std::optional<Intersection>(Intersection(intersection, exitVector));
 		}
 	} else {
-		physicsMeasure.mark(PhysicsProcess::OTHER, PhysicsProcess::GJK_NO_COL);
+		markPhysics(PhysicsProcess::OTHER, PhysicsProcess::GJK_NO_COL);
 		return std::optional<Intersection>();
 	}
 }
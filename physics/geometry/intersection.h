@@ -20,7 +20,22 @@ struct Intersection {
 		exitVector(exitVector) {}
 };
 
+/*
+	Shapes whose ShapeClasses have a specialized test for their pair of intersectionClassIDs use it, see shapePairIntersection.h
+	All other pairs, and all GenericCollidables, are tested with GJK and EPA
+*/
 std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform);
 std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
 
+/*
+	Warm started versions of the above, for pairs that are tested again and again
+	GJK starts from searchDirection, which is then set to the normalized direction GJK ended with, local to first
+	Passing it back in the next time the same pair is tested usually saves most GJK iterations
+	A zero searchDirection starts from the offset between the two shapes, like the versions above
+	supportHints likewise receives the vertices GJK and EPA last found on either shape, the next test of the pair starts its searches there
+	Specialized shape pair tests leave searchDirection and supportHints as they are
+*/
+std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform, Vec3f& searchDirection, SupportHints& supportHints);
+std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, Vec3f& searchDirection, SupportHints& supportHints);
+
 
@@ -34,9 +34,11 @@ public:
 	/*
 		This must return a valid Vec3f on the surface of the shape, even for 0,0,0
 		Does not need to take account of NaN or infinities in the input argument
+		It is called on every GJK and EPA iteration, so it must not allocate, builtin shapes compute it directly
 	*/
 	virtual Vec3f furthestInDirection(const Vec3f& direction) const = 0;
 
+	// builtin shapes build their polyhedron only once, and return copies of it
 	virtual Polyhedron asPolyhedron() const = 0;
 
 	// these functions determine the relations between the axes, for example, for Sphere, all axes must be equal
@@ -0,0 +1,408 @@
+#include "shapePairIntersection.h"
+
+#include "builtinShapeClasses.h"
+
+#include <cmath>
+#include <algorithm>
+
+// an edge axis of intersectsCubeCube must have an overlap this much smaller than the best face axis to be chosen, which keeps resting contacts on faces
+#define CUBE_EDGE_AXIS_BIAS 0.95
+// cross products of edges shorter than this come from nearly parallel edges, their axis is already covered by the face axes
+#define CUBE_PARALLEL_EDGE_EPSILON 1e-6
+// vertices of the incident cube this close to the deepest one, relative to the cube's size, all count towards a face contact
+#define CUBE_FACE_CONTACT_TOLERANCE 0.01
+// exitVectors of intersectsCubeCube this close to parallel to a face normal come from a face contact
+#define CUBE_FACE_NORMAL_EPSILON 1e-6
+
+/*
+	The point on the surface of a shape closest to some point, distance is negative if the point is inside the shape
+	normal points outwards, towards the point if it is outside
+*/
+struct SurfacePoint {
+	Vec3 point;
+	Vec3 normal;
+	double distance;
+};
+
+static SurfacePoint closestOnCube(Vec3 point, Vec3 halfExtents) {
+	Vec3 clamped = point;
+	bool outside = false;
+	for(int i = 0; i < 3; i++) {
+		if(clamped[i] > halfExtents[i]) {
+			clamped[i] = halfExtents[i];
+			outside = true;
+		} else if(clamped[i] < -halfExtents[i]) {
+			clamped[i] = -halfExtents[i];
+			outside = true;
+		}
+	}
+	if(outside) {
+		Vec3 offset = point - clamped;
+		double distance = length(offset);
+		return SurfacePoint{clamped, offset / distance, distance};
+	}
+
+	// inside, the closest face is the one with the least room
+	int axis = 0;
+	double room = halfExtents[0] - std::abs(point[0]);
+	for(int i = 1; i < 3; i++) {
+		double roomOnAxis = halfExtents[i] - std::abs(point[i]);
+		if(roomOnAxis < room) {
+			axis = i;
+			room = roomOnAxis;
+		}
+	}
+	Vec3 normal(0.0, 0.0, 0.0);
+	normal[axis] = (point[axis] >= 0.0) ? 1.0 : -1.0;
+	Vec3 surfacePoint = point;
+	surfacePoint[axis] = normal[axis] * halfExtents[axis];
+	return SurfacePoint{surfacePoint, normal, -room};
+}
+
+static SurfacePoint closestOnCylinder(Vec3 point, double radius, double halfHeight) {
+	double radialLength = std::sqrt(point.x * point.x + point.y * point.y);
+	bool outsideSide = radialLength > radius;
+	bool outsideCap = std::abs(point.z) > halfHeight;
+	if(outsideSide || outsideCap) {
+		Vec3 clamped = point;
+		if(outsideSide) {
+			clamped.x *= radius / radialLength;
+			clamped.y *= radius / radialLength;
+		}
+		if(outsideCap) {
+			clamped.z = (point.z >= 0.0) ? halfHeight : -halfHeight;
+		}
+		Vec3 offset = point - clamped;
+		double distance = length(offset);
+		return SurfacePoint{clamped, offset / distance, distance};
+	}
+
+	double sideRoom = radius - radialLength;
+	double capRoom = halfHeight - std::abs(point.z);
+	if(sideRoom < capRoom && radialLength > 0.0) {
+		Vec3 normal(point.x / radialLength, point.y / radialLength, 0.0);
+		return SurfacePoint{Vec3(normal.x * radius, normal.y * radius, point.z), normal, -sideRoom};
+	} else {
+		Vec3 normal(0.0, 0.0, (point.z >= 0.0) ? 1.0 : -1.0);
+		return SurfacePoint{Vec3(point.x, point.y, normal.z * halfHeight), normal, -capRoom};
+	}
+}
+
+/*
+	Intersection of a sphere with the shape surface belongs to, local to that shape
+*/
+static std::optional<Intersection> sphereAgainstSurface(Vec3 sphereCenter, double sphereRadius, const SurfacePoint& surface) {
+	if(surface.distance >= sphereRadius) return std::optional<Intersection>();
+
+	Vec3 deepestOfSphere = sphereCenter - surface.normal * sphereRadius;
+	return Intersection((surface.point + deepestOfSphere) * 0.5, surface.normal * (sphereRadius - surface.distance));
+}
+
+std::optional<Intersection> intersectsSphereSphere(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	double radiusFirst = scaleFirst[0];
+	double radiusSecond = scaleSecond[0];
+	double radiusSum = radiusFirst + radiusSecond;
+	Vec3 offset = relativeTransform.getPosition();
+	double distanceSq = lengthSquared(offset);
+	if(distanceSq >= radiusSum * radiusSum) return std::optional<Intersection>();
+
+	double distance = std::sqrt(distanceSq);
+	Vec3 normal = (distance > 0.0) ? offset / distance : Vec3(1.0, 0.0, 0.0);
+	return Intersection((normal * radiusFirst + offset - normal * radiusSecond) * 0.5, normal * (radiusSum - distance));
+}
+
+std::optional<Intersection> intersectsCubeSphere(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	Vec3 center = relativeTransform.getPosition();
+	SurfacePoint surface = closestOnCube(center, Vec3(scaleFirst[0], scaleFirst[1], scaleFirst[2]));
+	return sphereAgainstSurface(center, scaleSecond[0], surface);
+}
+
+std::optional<Intersection> intersectsCylinderSphere(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	Vec3 center = relativeTransform.getPosition();
+	SurfacePoint surface = closestOnCylinder(center, scaleFirst[0], scaleFirst[2]);
+	return sphereAgainstSurface(center, scaleSecond[0], surface);
+}
+
+/*
+	Contact of the incident cube against face axis of the reference cube, local to the reference cube
+	normal points from the reference cube to the incident cube
+*/
+static Vec3 cubeFaceContact(Vec3 referenceHalfExtents, Vec3 incidentHalfExtents, const CFrame& incidentTransform, int axis, Vec3 normal, double depth) {
+	Vec3 vertices[8];
+	double deepest = -INFINITY;
+	for(int i = 0; i < 8; i++) {
+		Vec3 corner((i & 1) ? incidentHalfExtents.x : -incidentHalfExtents.x, (i & 2) ? incidentHalfExtents.y : -incidentHalfExtents.y, (i & 4) ? incidentHalfExtents.z : -incidentHalfExtents.z);
+		vertices[i] = incidentTransform.localToGlobal(corner);
+		deepest = std::max(deepest, -(vertices[i] * normal));
+	}
+
+	double tolerance = CUBE_FACE_CONTACT_TOLERANCE * (incidentHalfExtents.x + incidentHalfExtents.y + incidentHalfExtents.z);
+	Vec3 total(0.0, 0.0, 0.0);
+	int count = 0;
+	for(const Vec3& vertex : vertices) {
+		if(-(vertex * normal) < deepest - tolerance) continue;
+		for(int i = 0; i < 3; i++) {
+			if(i == axis) continue;
+			total[i] += std::max(-referenceHalfExtents[i], std::min(vertex[i], referenceHalfExtents[i]));
+		}
+		count++;
+	}
+	Vec3 contact = total / count;
+	contact[axis] = normal[axis] * (referenceHalfExtents[axis] - depth * 0.5);
+	return contact;
+}
+
+std::optional<Intersection> intersectsCubeCube(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	Vec3 halfExtentsFirst(scaleFirst[0], scaleFirst[1], scaleFirst[2]);
+	Vec3 halfExtentsSecond(scaleSecond[0], scaleSecond[1], scaleSecond[2]);
+	Vec3 offset = relativeTransform.getPosition();
+	Rotation rotation = relativeTransform.getRotation();
+	Vec3 axesFirst[3]{Vec3(1.0, 0.0, 0.0), Vec3(0.0, 1.0, 0.0), Vec3(0.0, 0.0, 1.0)};
+	Vec3 axesSecond[3]{rotation.getX(), rotation.getY(), rotation.getZ()};
+
+	// how far the projections of both cubes on a normalized axis overlap, negative if they are apart
+	auto overlapOnAxis = [&](const Vec3& axis) -> double {
+		double radiusFirst = 0.0;
+		double radiusSecond = 0.0;
+		for(int i = 0; i < 3; i++) {
+			radiusFirst += halfExtentsFirst[i] * std::abs(axis[i]);
+			radiusSecond += halfExtentsSecond[i] * std::abs(axis * axesSecond[i]);
+		}
+		return radiusFirst + radiusSecond - std::abs(offset * axis);
+	};
+
+	enum class AxisKind { FACE_OF_FIRST, FACE_OF_SECOND, EDGES };
+	AxisKind bestKind = AxisKind::FACE_OF_FIRST;
+	Vec3 bestAxis;
+	double bestOverlap = INFINITY;
+	int bestFirstIndex = 0;
+	int bestSecondIndex = 0;
+
+	for(int i = 0; i < 3; i++) {
+		double overlap = overlapOnAxis(axesFirst[i]);
+		if(overlap < 0.0) return std::optional<Intersection>();
+		if(overlap < bestOverlap) {
+			bestKind = AxisKind::FACE_OF_FIRST;
+			bestAxis = axesFirst[i];
+			bestOverlap = overlap;
+			bestFirstIndex = i;
+		}
+	}
+	for(int j = 0; j < 3; j++) {
+		double overlap = overlapOnAxis(axesSecond[j]);
+		if(overlap < 0.0) return std::optional<Intersection>();
+		if(overlap < bestOverlap) {
+			bestKind = AxisKind::FACE_OF_SECOND;
+			bestAxis = axesSecond[j];
+			bestOverlap = overlap;
+			bestSecondIndex = j;
+		}
+	}
+	double bestFaceOverlap = bestOverlap;
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			Vec3 axis = axesFirst[i] % axesSecond[j];
+			double axisLength = length(axis);
+			if(axisLength < CUBE_PARALLEL_EDGE_EPSILON) continue;
+			axis = axis / axisLength;
+			double overlap = overlapOnAxis(axis);
+			if(overlap < 0.0) return std::optional<Intersection>();
+			if(overlap < bestOverlap && overlap < bestFaceOverlap * CUBE_EDGE_AXIS_BIAS) {
+				bestKind = AxisKind::EDGES;
+				bestAxis = axis;
+				bestOverlap = overlap;
+				bestFirstIndex = i;
+				bestSecondIndex = j;
+			}
+		}
+	}
+
+	// the exit vector points from first to second
+	Vec3 normal = (offset * bestAxis < 0.0) ? -bestAxis : bestAxis;
+	Vec3 contact;
+
+	switch(bestKind) {
+	case AxisKind::FACE_OF_FIRST:
+		contact = cubeFaceContact(halfExtentsFirst, halfExtentsSecond, relativeTransform, bestFirstIndex, normal, bestOverlap);
+		break;
+	case AxisKind::FACE_OF_SECOND: {
+		// from second to first, local to second
+		Vec3 normalOfSecond(0.0, 0.0, 0.0);
+		normalOfSecond[bestSecondIndex] = (axesSecond[bestSecondIndex] * normal <= 0.0) ? 1.0 : -1.0;
+		contact = relativeTransform.localToGlobal(cubeFaceContact(halfExtentsSecond, halfExtentsFirst, ~relativeTransform, bestSecondIndex, normalOfSecond, bestOverlap));
+		break;
+	}
+	case AxisKind::EDGES: {
+		// the edge of first furthest along normal, and that of second furthest against it
+		Vec3 edgeCenterFirst(0.0, 0.0, 0.0);
+		Vec3 edgeCenterSecond = offset;
+		for(int k = 0; k < 3; k++) {
+			if(k != bestFirstIndex) edgeCenterFirst[k] = (normal[k] >= 0.0) ? halfExtentsFirst[k] : -halfExtentsFirst[k];
+			if(k != bestSecondIndex) edgeCenterSecond += axesSecond[k] * ((axesSecond[k] * normal <= 0.0) ? halfExtentsSecond[k] : -halfExtentsSecond[k]);
+		}
+		Vec3 directionFirst = axesFirst[bestFirstIndex];
+		Vec3 directionSecond = axesSecond[bestSecondIndex];
+
+		// closest points of the two edges
+		Vec3 r = edgeCenterFirst - edgeCenterSecond;
+		double d = directionFirst * directionSecond;
+		double c = directionFirst * r;
+		double f = directionSecond * r;
+		double s = (d * f - c) / (1.0 - d * d);
+		s = std::max(-halfExtentsFirst[bestFirstIndex], std::min(s, halfExtentsFirst[bestFirstIndex]));
+		double u = f + s * d;
+		u = std::max(-halfExtentsSecond[bestSecondIndex], std::min(u, halfExtentsSecond[bestSecondIndex]));
+
+		contact = (edgeCenterFirst + directionFirst * s + edgeCenterSecond + directionSecond * u) * 0.5;
+		break;
+	}
+	}
+
+	return Intersection(contact, normal * bestOverlap);
+}
+
+/*
+	Cuts off the part of polygon beyond side of the reference face along axis, side is +1 or -1, returns the new vertex count
+	result must have room for one more vertex than polygon
+*/
+static int clipPolygonToSide(const Vec3* polygon, int count, int axis, double side, double halfExtent, Vec3* result) {
+	int resultCount = 0;
+	for(int i = 0; i < count; i++) {
+		const Vec3& a = polygon[i];
+		const Vec3& b = polygon[(i + 1) % count];
+		double outsideA = a[axis] * side - halfExtent;
+		double outsideB = b[axis] * side - halfExtent;
+		if(outsideA <= 0.0) result[resultCount++] = a;
+		if((outsideA <= 0.0) != (outsideB <= 0.0)) {
+			result[resultCount++] = a + (b - a) * (outsideA / (outsideA - outsideB));
+		}
+	}
+	return resultCount;
+}
+
+/*
+	The contact area of the face of the incident cube facing the reference cube against face axis of the reference cube, local to the reference cube
+	The incident face is clipped to the sides of the reference face, the points of the clipped face that sink into it are moved to halfway their depth, like the contact of cubeFaceContact
+	Points within CUBE_FACE_CONTACT_TOLERANCE above the face are included with a depth of 0, so a slight tilt doesn't suddenly take them out of the contact area
+	When more than 4 points remain, the ones furthest towards the corners of the reference face are kept
+*/
+static int cubeFaceContactPoints(Vec3 referenceHalfExtents, Vec3 incidentHalfExtents, const CFrame& incidentTransform, int axis, Vec3 normal, Vec3* points, double* depths) {
+	Rotation rotation = incidentTransform.getRotation();
+	Vec3 incidentAxes[3]{rotation.getX(), rotation.getY(), rotation.getZ()};
+
+	int faceAxis = 0;
+	for(int i = 1; i < 3; i++) {
+		if(std::abs(incidentAxes[i] * normal) > std::abs(incidentAxes[faceAxis] * normal)) faceAxis = i;
+	}
+	double faceSide = (incidentAxes[faceAxis] * normal > 0.0) ? -incidentHalfExtents[faceAxis] : incidentHalfExtents[faceAxis];
+	int u = (faceAxis + 1) % 3;
+	int v = (faceAxis + 2) % 3;
+
+	// every clip against a side can add one vertex to the 4 corners of the face
+	Vec3 polygon[8];
+	Vec3 clipped[8];
+	int count = 4;
+	for(int i = 0; i < 4; i++) {
+		Vec3 corner;
+		corner[faceAxis] = faceSide;
+		corner[u] = (i == 1 || i == 2) ? incidentHalfExtents[u] : -incidentHalfExtents[u];
+		corner[v] = (i >= 2) ? incidentHalfExtents[v] : -incidentHalfExtents[v];
+		polygon[i] = incidentTransform.localToGlobal(corner);
+	}
+	for(int k = 0; k < 3; k++) {
+		if(k == axis) continue;
+		count = clipPolygonToSide(polygon, count, k, 1.0, referenceHalfExtents[k], clipped);
+		count = clipPolygonToSide(clipped, count, k, -1.0, referenceHalfExtents[k], polygon);
+	}
+
+	double tolerance = CUBE_FACE_CONTACT_TOLERANCE * std::min(incidentHalfExtents.x + incidentHalfExtents.y + incidentHalfExtents.z, referenceHalfExtents.x + referenceHalfExtents.y + referenceHalfExtents.z);
+	int touchingCount = 0;
+	for(int i = 0; i < count; i++) {
+		double depth = referenceHalfExtents[axis] - normal[axis] * polygon[i][axis];
+		if(depth < -tolerance) continue;
+		depth = std::max(depth, 0.0);
+		polygon[touchingCount] = polygon[i];
+		polygon[touchingCount][axis] = normal[axis] * (referenceHalfExtents[axis] - depth * 0.5);
+		depths[touchingCount] = depth;
+		touchingCount++;
+	}
+
+	if(touchingCount <= 4) {
+		for(int i = 0; i < touchingCount; i++) points[i] = polygon[i];
+		return touchingCount;
+	}
+
+	int a = (axis + 1) % 3;
+	int b = (axis + 2) % 3;
+	bool used[8]{};
+	double usedDepths[8];
+	for(int i = 0; i < touchingCount; i++) usedDepths[i] = depths[i];
+	int resultCount = 0;
+	for(int corner = 0; corner < 4; corner++) {
+		double signA = (corner == 1 || corner == 2) ? 1.0 : -1.0;
+		double signB = (corner >= 2) ? 1.0 : -1.0;
+		int best = -1;
+		for(int i = 0; i < touchingCount; i++) {
+			if(used[i]) continue;
+			if(best == -1 || polygon[i][a] * signA + polygon[i][b] * signB > polygon[best][a] * signA + polygon[best][b] * signB) best = i;
+		}
+		used[best] = true;
+		points[resultCount] = polygon[best];
+		depths[resultCount] = usedDepths[best];
+		resultCount++;
+	}
+	return resultCount;
+}
+
+int cubeCubeContactPoints(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const Vec3& exitVector, Vec3* points, double* depths) {
+	double exitLength = length(exitVector);
+	if(exitLength == 0.0) return 0;
+	Vec3 halfExtentsFirst(scaleFirst[0], scaleFirst[1], scaleFirst[2]);
+	Vec3 halfExtentsSecond(scaleSecond[0], scaleSecond[1], scaleSecond[2]);
+
+	Vec3 normal = exitVector / exitLength;
+	// from second to first, local to second
+	Vec3 normalOfSecond = -relativeTransform.relativeToLocal(normal);
+
+	for(int i = 0; i < 3; i++) {
+		if(std::abs(normal[i]) > 1.0 - CUBE_FACE_NORMAL_EPSILON) {
+			Vec3 faceNormal(0.0, 0.0, 0.0);
+			faceNormal[i] = (normal[i] > 0.0) ? 1.0 : -1.0;
+			return cubeFaceContactPoints(halfExtentsFirst, halfExtentsSecond, relativeTransform, i, faceNormal, points, depths);
+		}
+	}
+	for(int i = 0; i < 3; i++) {
+		if(std::abs(normalOfSecond[i]) > 1.0 - CUBE_FACE_NORMAL_EPSILON) {
+			Vec3 faceNormal(0.0, 0.0, 0.0);
+			faceNormal[i] = (normalOfSecond[i] > 0.0) ? 1.0 : -1.0;
+			int count = cubeFaceContactPoints(halfExtentsSecond, halfExtentsFirst, ~relativeTransform, i, faceNormal, points, depths);
+			for(int k = 0; k < count; k++) {
+				points[k] = relativeTransform.localToGlobal(points[k]);
+			}
+			return count;
+		}
+	}
+	return 0;
+}
+
+/*
+	Runs intersector with first and second swapped, and turns the result back to be local to first
+*/
+template<ShapePairIntersector intersector>
+static std::optional<Intersection> swapped(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+	std::optional<Intersection> result = intersector(~relativeTransform, scaleSecond, scaleFirst);
+	if(!result) return result;
+	return Intersection(relativeTransform.localToGlobal(result->intersection), -relativeTransform.localToRelative(result->exitVector));
+}
+
+// indexed by the intersectionClassID of first, then of second
+static const ShapePairIntersector shapePairIntersectors[SHAPE_PAIR_CLASS_ID_COUNT][SHAPE_PAIR_CLASS_ID_COUNT]{
+	/* CUBE_CLASS_ID */     {intersectsCubeCube, intersectsCubeSphere, nullptr},
+	/* SPHERE_CLASS_ID */   {swapped<intersectsCubeSphere>, intersectsSphereSphere, swapped<intersectsCylinderSphere>},
+	/* CYLINDER_CLASS_ID */ {nullptr, intersectsCylinderSphere, nullptr}
+};
+
+ShapePairIntersector getShapePairIntersector(int firstClassID, int secondClassID) {
+	if(firstClassID < 0 || firstClassID >= SHAPE_PAIR_CLASS_ID_COUNT || secondClassID < 0 || secondClassID >= SHAPE_PAIR_CLASS_ID_COUNT) return nullptr;
+	return shapePairIntersectors[firstClassID][secondClassID];
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <optional>
+
+#include "../math/linalg/vec.h"
+#include "../math/linalg/mat.h"
+#include "../math/cframe.h"
+#include "intersection.h"
+
+// intersectionClassIDs below this can have a specialized intersection test against each other, see builtinShapeClasses.h
+#define SHAPE_PAIR_CLASS_ID_COUNT 3
+
+/*
+	Intersection test for one specific pair of ShapeClasses, with the same arguments and results as intersectsTransformed
+	Scales are those of the Shapes, so a sphere's radius is scale[0], a cube's half extents are its scale
+*/
+typedef std::optional<Intersection>(*ShapePairIntersector)(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
+
+/*
+	Returns the specialized test for shapes of these intersectionClassIDs, or nullptr if the pair must be tested with GJK and EPA
+*/
+ShapePairIntersector getShapePairIntersector(int firstClassID, int secondClassID);
+
+std::optional<Intersection> intersectsSphereSphere(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
+std::optional<Intersection> intersectsCubeSphere(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
+std::optional<Intersection> intersectsCylinderSphere(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
+/*
+	Separating axis test of the 3 face normals of either cube and the 9 cross products of their edges
+	Face contacts are placed at the center of the part of the incident face that overlaps the reference face, edge contacts between the two closest points of the edges
+*/
+std::optional<Intersection> intersectsCubeCube(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
+/*
+	The contact area of two cubes touching face to face, given the exitVector intersectsCubeCube found for them
+	Writes up to 4 points local to first and the depth at each of them, from the incident face clipped to the reference face
+	Returns 0 for edge contacts, which only touch at the single point intersectsCubeCube already found
+*/
+int cubeCubeContactPoints(const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const Vec3& exitVector, Vec3* points, double* depths);
@@ -0,0 +1,113 @@
+#include "supportGraph.h"
+
+#include "triangleMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// how far, relative to the size of the mesh, a vertex may stick out above the plane of a neighboring triangle for the mesh to still count as convex
+#define CONVEXITY_TOLERANCE 1e-4f
+
+SupportGraph::SupportGraph(const TriangleMesh& mesh, int minVertexCount) {
+	if(mesh.vertexCount < minVertexCount) return;
+
+	std::vector<std::pair<int, int>> edges;
+	edges.reserve(mesh.triangleCount * 6);
+	for(Triangle triangle : mesh.iterTriangles()) {
+		for(int i = 0; i < 3; i++) {
+			edges.emplace_back(triangle[i], triangle[(i + 1) % 3]);
+			edges.emplace_back(triangle[(i + 1) % 3], triangle[i]);
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+	neighborOffsets.assign(mesh.vertexCount + 1, 0);
+	neighbors.reserve(edges.size());
+	for(const std::pair<int, int>& edge : edges) {
+		neighborOffsets[edge.first + 1]++;
+		neighbors.push_back(edge.second);
+	}
+	for(int i = 0; i < mesh.vertexCount; i++) {
+		neighborOffsets[i + 1] += neighborOffsets[i];
+	}
+
+	vertices.reserve(mesh.vertexCount);
+	for(Vec3f vertex : mesh.iterVertices()) {
+		vertices.push_back(vertex);
+	}
+
+	// every neighbor of the corners of a triangle must lie below its plane, otherwise hill climbing could get stuck in a dent
+	float tolerance = CONVEXITY_TOLERANCE * static_cast<float>(mesh.getMaxRadius());
+	for(Triangle triangle : mesh.iterTriangles()) {
+		Vec3f normal = mesh.getNormalVecOfTriangle(triangle);
+		float normalLength = length(normal);
+		if(normalLength == 0.0f) continue;
+		normal = normal / normalLength;
+		Vec3f corner = vertices[triangle[0]];
+		for(int i = 0; i < 3; i++) {
+			for(int n = neighborOffsets[triangle[i]]; n < neighborOffsets[triangle[i] + 1]; n++) {
+				if((vertices[neighbors[n]] - corner) * normal > tolerance) {
+					vertices.clear();
+					neighborOffsets.clear();
+					neighbors.clear();
+					return;
+				}
+			}
+		}
+	}
+
+	Vec3f axes[3]{Vec3f(1.0f, 0.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f), Vec3f(0.0f, 0.0f, 1.0f)};
+	for(int i = 0; i < 3; i++) {
+		axisExtremes[2 * i] = mesh.furthestIndexInDirection(axes[i]);
+		axisExtremes[2 * i + 1] = mesh.furthestIndexInDirection(-axes[i]);
+	}
+}
+
+int SupportGraph::furthestIndexInDirection(const Vec3f& direction, int startIndex) const {
+	int current = startIndex;
+	float currentDot = vertices[current] * direction;
+	while(true) {
+		int best = current;
+		float bestDot = currentDot;
+		for(int n = neighborOffsets[current]; n < neighborOffsets[current + 1]; n++) {
+			int neighbor = neighbors[n];
+			float dot = vertices[neighbor] * direction;
+			if(dot > bestDot) {
+				best = neighbor;
+				bestDot = dot;
+			}
+		}
+		if(best == current) return current;
+		current = best;
+		currentDot = bestDot;
+	}
+}
+
+int SupportGraph::axisStartIndex(const Vec3f& direction) const {
+	int start = axisExtremes[direction.x < 0.0f ? 1 : 0];
+	float startDot = vertices[start] * direction;
+	for(int axis = 1; axis < 3; axis++) {
+		int candidate = axisExtremes[2 * axis + (direction[axis] < 0.0f ? 1 : 0)];
+		float candidateDot = vertices[candidate] * direction;
+		if(candidateDot > startDot) {
+			start = candidate;
+			startDot = candidateDot;
+		}
+	}
+	return start;
+}
+
+int SupportGraph::furthestIndexInDirection(const Vec3f& direction) const {
+	return furthestIndexInDirection(direction, axisStartIndex(direction));
+}
+
+int SupportGraph::furthestIndexFromHint(const Vec3f& direction, int& hint) const {
+	int start = axisStartIndex(direction);
+	if(hint >= 0 && hint < getVertexCount() && vertices[hint] * direction > vertices[start] * direction) {
+		start = hint;
+	}
+	hint = furthestIndexInDirection(direction, start);
+	return hint;
+}
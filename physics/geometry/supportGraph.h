@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "../math/linalg/vec.h"
+
+class TriangleMesh;
+
+// meshes with fewer vertices than this are faster to scan entirely than to climb, see the supportGraph benchmarks
+#define SUPPORT_GRAPH_MIN_VERTICES 64
+// below this the single pass bounds of TriangleMesh beat 6 climbs from the axis extremes
+#define SUPPORT_GRAPH_MIN_BOUNDS_VERTICES 4096
+
+/*
+	The vertices of a convex mesh together with the edges between them
+	Finds the vertex furthest in a direction by hill climbing, moving along edges as long as that gets further,
+	which on a convex mesh always ends at the furthest vertex, usually after a handful of steps
+
+	Searches start from the best of the vertices furthest along the axes, or from a hint that the caller keeps,
+	GJK and EPA keep one per pair of shapes, so their repeated searches, and those of the same pair in consecutive ticks, start next to their answer
+*/
+class SupportGraph {
+	std::vector<Vec3f> vertices;
+	// the neighbors of vertex i are neighbors[neighborOffsets[i]] .. neighbors[neighborOffsets[i + 1]]
+	std::vector<int> neighborOffsets;
+	std::vector<int> neighbors;
+	// furthest vertices along +x, -x, +y, -y, +z, -z
+	int axisExtremes[6]{};
+
+	int axisStartIndex(const Vec3f& direction) const;
+
+public:
+	/*
+		Builds the graph of mesh, leaves it empty if mesh has fewer than minVertexCount vertices or is not convex
+	*/
+	explicit SupportGraph(const TriangleMesh& mesh, int minVertexCount = SUPPORT_GRAPH_MIN_VERTICES);
+
+	SupportGraph(const SupportGraph&) = delete;
+	SupportGraph& operator=(const SupportGraph&) = delete;
+
+	inline bool isEmpty() const { return vertices.empty(); }
+	inline int getVertexCount() const { return static_cast<int>(vertices.size()); }
+
+	/*
+		Climbs from startIndex to the vertex furthest in direction
+	*/
+	int furthestIndexInDirection(const Vec3f& direction, int startIndex) const;
+	int furthestIndexInDirection(const Vec3f& direction) const;
+	/*
+		Climbs from hint if that is a better start than the axis extremes, hint then receives the result
+		Any value is a valid hint, those that aren't the index of a vertex are ignored
+	*/
+	int furthestIndexFromHint(const Vec3f& direction, int& hint) const;
+
+	inline Vec3f getVertex(int index) const { return vertices[index]; }
+
+	inline Vec3f furthestInDirection(const Vec3f& direction) const {
+		return vertices[furthestIndexInDirection(direction)];
+	}
+};
@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <cstring>
+#include <algorithm>
 #include <vector>
 #include <set>
 #include <math.h>
@@ -444,6 +445,30 @@ TriangleMesh stripUnusedVertices(const Vec3f* vertices, const Triangle* triangle
 }
 
 
+void getBoundsDirections(const Mat3f& referenceFrame, Vec3f* directions) {
+	Mat3f transp = referenceFrame.transpose();
+	directions[0] = transp * Vec3f(1, 0, 0);
+	directions[1] = transp * Vec3f(-1, 0, 0);
+	directions[2] = transp * Vec3f(0, 1, 0);
+	directions[3] = transp * Vec3f(0, -1, 0);
+	directions[4] = transp * Vec3f(0, 0, 1);
+	directions[5] = transp * Vec3f(0, 0, -1);
+}
+
+BoundingBox boundsFromFurthest(const Mat3f& referenceFrame, const Vec3f* furthest) {
+	double xmax = (referenceFrame * furthest[0]).x;
+	double xmin = (referenceFrame * furthest[1]).x;
+	double ymax = (referenceFrame * furthest[2]).y;
+	double ymin = (referenceFrame * furthest[3]).y;
+	double zmax = (referenceFrame * furthest[4]).z;
+	double zmin = (referenceFrame * furthest[5]).z;
+
+	return BoundingBox(xmin, ymin, zmin, xmax, ymax, zmax);
+}
+
+// directions searched together by furthestInDirections, 6 is fastest in the batchedSupportQueries benchmark and matches getBounds
+#define FURTHEST_IN_DIRECTIONS_GROUP 6
+
 #ifdef __AVX__
 #include <immintrin.h>
 #if defined(_MSC_VER) && _MSC_VER == 1922
@@ -713,6 +738,74 @@ BoundingBox TriangleMesh::getBounds(const Mat3f& referenceFrame) const {
 	return toBounds(xMin, xMax, yMin, yMax, zMin, zMax);
 }
 
+void TriangleMesh::furthestInDirections(const Vec3f* directions, int count, Vec3f* results) const {
+	size_t vertexCount = this->vertexCount;
+
+	size_t offset = getOffset(vertexCount);
+	const float* xValues = this->vertices;
+	const float* yValues = this->vertices + offset;
+	const float* zValues = this->vertices + 2 * offset;
+
+	// the directions of a group share the loads of each block, and their independent compare chains overlap
+	for(int groupStart = 0; groupStart < count; groupStart += FURTHEST_IN_DIRECTIONS_GROUP) {
+		int groupSize = std::min(count - groupStart, FURTHEST_IN_DIRECTIONS_GROUP);
+
+		__m256 dx[FURTHEST_IN_DIRECTIONS_GROUP];
+		__m256 dy[FURTHEST_IN_DIRECTIONS_GROUP];
+		__m256 dz[FURTHEST_IN_DIRECTIONS_GROUP];
+		__m256 bestDot[FURTHEST_IN_DIRECTIONS_GROUP];
+		__m256i bestIndices[FURTHEST_IN_DIRECTIONS_GROUP];
+
+		__m256 x = _mm256_load_ps(xValues);
+		__m256 y = _mm256_load_ps(yValues);
+		__m256 z = _mm256_load_ps(zValues);
+		for(int d = 0; d < FURTHEST_IN_DIRECTIONS_GROUP; d++) {
+			// a smaller last group repeats its last direction
+			const Vec3f& direction = directions[groupStart + std::min(d, groupSize - 1)];
+			dx[d] = _mm256_set1_ps(direction.x);
+			dy[d] = _mm256_set1_ps(direction.y);
+			dz[d] = _mm256_set1_ps(direction.z);
+
+			bestDot[d] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx[d], x), _mm256_mul_ps(dy[d], y)), _mm256_mul_ps(dz[d], z));
+			bestIndices[d] = _mm256_set1_epi32(0);
+		}
+
+		for(size_t blockI = 1; blockI < (vertexCount + 7) / 8; blockI++) {
+			__m256i indices = _mm256_set1_epi32(int(blockI));
+
+			__m256 x = _mm256_load_ps(xValues + blockI * 8);
+			__m256 y = _mm256_load_ps(yValues + blockI * 8);
+			__m256 z = _mm256_load_ps(zValues + blockI * 8);
+
+			for(int d = 0; d < FURTHEST_IN_DIRECTIONS_GROUP; d++) {
+				__m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx[d], x), _mm256_mul_ps(dy[d], y)), _mm256_mul_ps(dz[d], z));
+
+				__m256 whichAreMax = _mm256_cmp_ps(dot, bestDot[d], _CMP_GT_OQ); // Greater than, false if dot == NaN
+				bestDot[d] = _mm256_blendv_ps(bestDot[d], dot, whichAreMax);
+				bestIndices[d] = _mm256_blendv_epi32(bestIndices[d], indices, whichAreMax);
+			}
+		}
+
+		for(int d = 0; d < groupSize; d++) {
+			// find max of our 8 left candidates
+			__m256 swap4x4 = _mm256_permute2f128_ps(bestDot[d], bestDot[d], 1);
+			__m256 bestDotInternalMax = _mm256_max_ps(bestDot[d], swap4x4);
+			__m256 swap2x2 = _mm256_permute_ps(bestDotInternalMax, SWAP_2x2);
+			bestDotInternalMax = _mm256_max_ps(bestDotInternalMax, swap2x2);
+			__m256 swap1x1 = _mm256_permute_ps(bestDotInternalMax, SWAP_1x1);
+			bestDotInternalMax = _mm256_max_ps(bestDotInternalMax, swap1x1);
+
+			__m256 compare = _mm256_cmp_ps(bestDotInternalMax, bestDot[d], _CMP_EQ_UQ);
+			uint32_t mask = _mm256_movemask_ps(compare);
+
+			assert(mask != 0);
+
+			uint32_t index = __builtin_ctz(mask);
+			uint32_t block = mm256_extract_epi32_var_indx(bestIndices[d], index);
+			results[groupStart + d] = this->getVertex(block * 8 + index);
+		}
+	}
+}
 
 #else
 int TriangleMesh::furthestIndexInDirection(const Vec3f& direction) const {
@@ -764,15 +857,36 @@ BoundingBox TriangleMesh::getBounds() const {
 }
 
 BoundingBox TriangleMesh::getBounds(const Mat3f& referenceFrame) const {
-	Mat3f transp = referenceFrame.transpose();
-	double xmax = (referenceFrame * this->furthestInDirection(transp * Vec3f(1, 0, 0))).x;
-	double xmin = (referenceFrame * this->furthestInDirection(transp * Vec3f(-1, 0, 0))).x;
-	double ymax = (referenceFrame * this->furthestInDirection(transp * Vec3f(0, 1, 0))).y;
-	double ymin = (referenceFrame * this->furthestInDirection(transp * Vec3f(0, -1, 0))).y;
-	double zmax = (referenceFrame * this->furthestInDirection(transp * Vec3f(0, 0, 1))).z;
-	double zmin = (referenceFrame * this->furthestInDirection(transp * Vec3f(0, 0, -1))).z;
-
-	return BoundingBox(xmin, ymin, zmin, xmax, ymax, zmax);
+	Vec3f directions[6];
+	Vec3f furthest[6];
+	getBoundsDirections(referenceFrame, directions);
+	this->furthestInDirections(directions, 6, furthest);
+	return boundsFromFurthest(referenceFrame, furthest);
+}
+
+void TriangleMesh::furthestInDirections(const Vec3f* directions, int count, Vec3f* results) const {
+	// each vertex is loaded once per group of directions
+	for(int groupStart = 0; groupStart < count; groupStart += FURTHEST_IN_DIRECTIONS_GROUP) {
+		int groupSize = std::min(count - groupStart, FURTHEST_IN_DIRECTIONS_GROUP);
+		const Vec3f* groupDirections = directions + groupStart;
+		Vec3f* groupResults = results + groupStart;
+
+		float bestDots[FURTHEST_IN_DIRECTIONS_GROUP];
+		for(int i = 0; i < groupSize; i++) {
+			groupResults[i] = this->getVertex(0);
+			bestDots[i] = groupResults[i] * groupDirections[i];
+		}
+		for(int vertexI = 1; vertexI < vertexCount; vertexI++) {
+			Vec3f vertex = this->getVertex(vertexI);
+			for(int i = 0; i < groupSize; i++) {
+				float dot = vertex * groupDirections[i];
+				if(dot > bestDots[i]) {
+					bestDots[i] = dot;
+					groupResults[i] = vertex;
+				}
+			}
+		}
+	}
 }
 
 #endif
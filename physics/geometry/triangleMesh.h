@@ -135,8 +135,18 @@ public:
 
 	int furthestIndexInDirection(const Vec3f& direction) const;
 	Vec3f furthestInDirection(const Vec3f& direction) const;
+	/*
+		Same as furthestInDirection for each of the count directions, but goes through the vertices only once for every 6 directions
+	*/
+	void furthestInDirections(const Vec3f* directions, int count, Vec3f* results) const;
 
 	float getIntersectionDistance(Vec3f origin, Vec3f direction) const;
 };
 
 TriangleMesh stripUnusedVertices(const Vec3f* vertices, const Triangle* triangles, int vertexCount, int triangleCount);
+
+/*
+	The 6 directions whose furthest vertices give the bounds of a mesh transformed by referenceFrame, in the order +x, -x, +y, -y, +z, -z
+*/
+void getBoundsDirections(const Mat3f& referenceFrame, Vec3f* directions);
+BoundingBox boundsFromFurthest(const Mat3f& referenceFrame, const Vec3f* furthest);
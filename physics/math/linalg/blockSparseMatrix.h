@@ -0,0 +1,145 @@
+#pragma once
+
+#include "mat.h"
+#include "largeMatrix.h"
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+/*
+	A square matrix made of BlockSize x BlockSize blocks, of which only the nonzero blocks are stored
+	The diagonal block of every row is always present and kept separately, the other blocks of a row are stored sorted by column
+	Rows are built one at a time with addRow, followed by addToRow for every off diagonal block of that row
+*/
+template<typename T, std::size_t BlockSize>
+class BlockSparseMatrix {
+public:
+	using Block = Matrix<T, BlockSize, BlockSize>;
+	using BlockVector = Vector<T, BlockSize>;
+
+	std::vector<Block> diagonal;
+	std::vector<size_t> rowStart;
+	std::vector<size_t> columns;
+	std::vector<Block> blocks;
+
+	BlockSparseMatrix() : rowStart{0} {}
+
+	size_t getBlockCount() const { return diagonal.size(); }
+	size_t getDimension() const { return diagonal.size() * BlockSize; }
+
+	void addRow(const Block& diagonalBlock) {
+		diagonal.push_back(diagonalBlock);
+		rowStart.push_back(blocks.size());
+	}
+
+	/*
+		Adds block to the block at (last row, column), inserting it if the row did not have a block in that column yet
+	*/
+	void addToRow(size_t column, const Block& block) {
+		assert(!diagonal.empty() && column != diagonal.size() - 1);
+		size_t start = rowStart[rowStart.size() - 2];
+		size_t insertAt = start;
+		while(insertAt < columns.size() && columns[insertAt] < column) insertAt++;
+		if(insertAt < columns.size() && columns[insertAt] == column) {
+			blocks[insertAt] += block;
+		} else {
+			columns.insert(columns.begin() + insertAt, column);
+			blocks.insert(blocks.begin() + insertAt, block);
+		}
+		rowStart.back() = blocks.size();
+	}
+
+	/*
+		result = this * vec, vec and result must not overlap
+	*/
+	void multiply(const BlockVector* vec, BlockVector* result) const {
+		for(size_t row = 0; row < diagonal.size(); row++) {
+			BlockVector total = diagonal[row] * vec[row];
+			for(size_t i = rowStart[row]; i < rowStart[row + 1]; i++) {
+				total += blocks[i] * vec[columns[i]];
+			}
+			result[row] = total;
+		}
+	}
+
+	LargeMatrix<T> toLargeMatrix() const {
+		size_t dimension = getDimension();
+		LargeMatrix<T> result(dimension, dimension);
+		for(T& value : result) value = 0;
+		for(size_t row = 0; row < diagonal.size(); row++) {
+			result.setSubMatrix(row * BlockSize, row * BlockSize, diagonal[row]);
+			for(size_t i = rowStart[row]; i < rowStart[row + 1]; i++) {
+				result.setSubMatrix(row * BlockSize, columns[i] * BlockSize, blocks[i]);
+			}
+		}
+		return result;
+	}
+};
+
+/*
+	Solves m * x = b with the conjugate gradient method, preconditioned with the inverses of the diagonal blocks
+	m must be symmetric positive definite. x holds the initial guess and receives the solution, so the previous solution can be used as a warm start
+	Stops once the residual is smaller than relativeTolerance * |b|, or after maxIterations, returns the number of iterations done
+*/
+template<typename T, std::size_t BlockSize>
+int conjugateGradientSolve(const BlockSparseMatrix<T, BlockSize>& m, const Vector<T, BlockSize>* b, Vector<T, BlockSize>* x, int maxIterations, T relativeTolerance) {
+	using BlockVector = Vector<T, BlockSize>;
+	size_t blockCount = m.getBlockCount();
+
+	T bLengthSquared = 0;
+	for(size_t i = 0; i < blockCount; i++) bLengthSquared += lengthSquared(b[i]);
+	if(bLengthSquared == 0) {
+		for(size_t i = 0; i < blockCount; i++) x[i] = BlockVector();
+		return 0;
+	}
+	T maxResidualSquared = relativeTolerance * relativeTolerance * bLengthSquared;
+
+	std::vector<Matrix<T, BlockSize, BlockSize>> preconditioner(blockCount);
+	for(size_t i = 0; i < blockCount; i++) {
+		// a singular diagonal block, for example of a constraint between two anchored physicals, is left unpreconditioned
+		preconditioner[i] = (det(m.diagonal[i]) > 0) ? ~m.diagonal[i] : Matrix<T, BlockSize, BlockSize>::IDENTITY();
+	}
+
+	std::vector<BlockVector> residual(blockCount);
+	std::vector<BlockVector> preconditioned(blockCount);
+	std::vector<BlockVector> direction(blockCount);
+	std::vector<BlockVector> mTimesDirection(blockCount);
+
+	m.multiply(x, residual.data());
+	T residualLengthSquared = 0;
+	T residualDotPreconditioned = 0;
+	for(size_t i = 0; i < blockCount; i++) {
+		residual[i] = b[i] - residual[i];
+		preconditioned[i] = preconditioner[i] * residual[i];
+		direction[i] = preconditioned[i];
+		residualLengthSquared += lengthSquared(residual[i]);
+		residualDotPreconditioned += residual[i] * preconditioned[i];
+	}
+
+	int iteration = 0;
+	for(; iteration < maxIterations && residualLengthSquared > maxResidualSquared; iteration++) {
+		m.multiply(direction.data(), mTimesDirection.data());
+		T curvature = 0;
+		for(size_t i = 0; i < blockCount; i++) curvature += direction[i] * mTimesDirection[i];
+		if(!(curvature > 0)) break; // m is singular along direction, no further progress possible
+
+		T stepSize = residualDotPreconditioned / curvature;
+		residualLengthSquared = 0;
+		T newResidualDotPreconditioned = 0;
+		for(size_t i = 0; i < blockCount; i++) {
+			x[i] += direction[i] * stepSize;
+			residual[i] -= mTimesDirection[i] * stepSize;
+			preconditioned[i] = preconditioner[i] * residual[i];
+			residualLengthSquared += lengthSquared(residual[i]);
+			newResidualDotPreconditioned += residual[i] * preconditioned[i];
+		}
+
+		T directionFactor = newResidualDotPreconditioned / residualDotPreconditioned;
+		residualDotPreconditioned = newResidualDotPreconditioned;
+		for(size_t i = 0; i < blockCount; i++) {
+			direction[i] = preconditioned[i] + direction[i] * directionFactor;
+		}
+	}
+	return iteration;
+}
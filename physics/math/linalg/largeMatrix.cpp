@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <utility>
+#include <algorithm>
 
 template<typename T>
 void swapRows(LargeMatrix<T>& m, LargeVector<T>& v, size_t rowA, size_t rowB) {
@@ -62,3 +63,185 @@ void destructiveSolve(LargeMatrix<T>& m, LargeVector<T>& v) {
 template void destructiveSolve<double>(LargeMatrix<double>& m, LargeVector<double>& v);
 template void destructiveSolve<float>(LargeMatrix<float>& m, LargeVector<float>& v);
 
+template<typename T>
+LargeLUDecomposition<T>::LargeLUDecomposition(const LargeMatrix<T>& m) : lu(m), permutation(new size_t[m.height]) {
+	if (m.width != m.height) throw "Dimensions do not align!";
+	size_t size = m.height;
+	for (size_t i = 0; i < size; i++) permutation[i] = i;
+
+	for (size_t i = 0; i < size; i++) {
+		T bestPivot = std::abs(lu.get(i, i));
+		size_t bestPivotIndex = i;
+		for (size_t j = i + 1; j < size; j++) {
+			T newPivot = std::abs(lu.get(j, i));
+			if (newPivot > bestPivot) {
+				bestPivot = newPivot;
+				bestPivotIndex = j;
+			}
+		}
+
+		if (bestPivotIndex != i) {
+			for (size_t k = 0; k < size; k++) {
+				std::swap(lu.get(i, k), lu.get(bestPivotIndex, k));
+			}
+			std::swap(permutation[i], permutation[bestPivotIndex]);
+		}
+
+		T pivot = lu.get(i, i);
+		const T* pivotRow = &lu.get(i, 0);
+		for (size_t j = i + 1; j < size; j++) {
+			T* row = &lu.get(j, 0);
+			T factor = row[i] / pivot;
+			row[i] = factor;
+			for (size_t k = i + 1; k < size; k++) {
+				row[k] -= pivotRow[k] * factor;
+			}
+		}
+	}
+}
+
+template<typename T>
+void LargeLUDecomposition<T>::solveInPlace(LargeVector<T>& v) const {
+	if (v.size != lu.height) throw "Dimensions do not align!";
+	size_t size = v.size;
+
+	LargeVector<T> permuted(size);
+	for (size_t i = 0; i < size; i++) {
+		permuted[i] = v[permutation[i]];
+	}
+
+	// L has an implicit unit diagonal
+	for (size_t i = 0; i < size; i++) {
+		const T* row = &lu.get(i, 0);
+		T total = permuted[i];
+		for (size_t k = 0; k < i; k++) {
+			total -= row[k] * permuted[k];
+		}
+		permuted[i] = total;
+	}
+	for (size_t i = size; i-- > 0;) {
+		const T* row = &lu.get(i, 0);
+		T total = permuted[i];
+		for (size_t k = i + 1; k < size; k++) {
+			total -= row[k] * permuted[k];
+		}
+		permuted[i] = total / row[i];
+	}
+	v = std::move(permuted);
+}
+
+// the tile size of the blocked Cholesky factorization, 32x32 doubles is 8KB, so the tiles being combined fit in L1
+#define CHOLESKY_BLOCK_SIZE 32
+
+template<typename T>
+static T dotRows(const T* a, const T* b, size_t from, size_t to) {
+	T total = 0;
+	for (size_t k = from; k < to; k++) {
+		total += a[k] * b[k];
+	}
+	return total;
+}
+
+template<typename T>
+LargeCholeskyDecomposition<T>::LargeCholeskyDecomposition(const LargeMatrix<T>& m) : lower(m.height, m.height), positiveDefinite(true) {
+	if (m.width != m.height) throw "Dimensions do not align!";
+	size_t size = m.height;
+	for (size_t i = 0; i < size; i++) {
+		for (size_t j = 0; j <= i; j++) {
+			lower.get(i, j) = m.get(i, j);
+		}
+		for (size_t j = i + 1; j < size; j++) {
+			lower.get(i, j) = 0;
+		}
+	}
+
+	LargeMatrix<T> transposedBlockColumn(size, std::min<size_t>(CHOLESKY_BLOCK_SIZE, size));
+
+	// right looking, after a block column is factorized its contribution is subtracted from the rest of the matrix
+	for (size_t blockStart = 0; blockStart < size; blockStart += CHOLESKY_BLOCK_SIZE) {
+		size_t blockEnd = std::min(blockStart + CHOLESKY_BLOCK_SIZE, size);
+
+		// factorize the diagonal tile
+		for (size_t j = blockStart; j < blockEnd; j++) {
+			T* rowJ = &lower.get(j, 0);
+			T diagonal = rowJ[j] - dotRows(rowJ, rowJ, blockStart, j);
+			if (!(diagonal > 0)) {
+				positiveDefinite = false;
+				return;
+			}
+			rowJ[j] = std::sqrt(diagonal);
+			for (size_t i = j + 1; i < blockEnd; i++) {
+				T* rowI = &lower.get(i, 0);
+				rowI[j] = (rowI[j] - dotRows(rowI, rowJ, blockStart, j)) / rowJ[j];
+			}
+		}
+
+		// the tiles below it
+		for (size_t i = blockEnd; i < size; i++) {
+			T* rowI = &lower.get(i, 0);
+			for (size_t j = blockStart; j < blockEnd; j++) {
+				const T* rowJ = &lower.get(j, 0);
+				rowI[j] = (rowI[j] - dotRows(rowI, rowJ, blockStart, j)) / rowJ[j];
+			}
+		}
+
+		// update the trailing lower triangle, tile by tile
+		// the factorized block column is transposed first, so the update of a row is a sum of contiguous scaled rows which vectorizes well
+		size_t blockWidth = blockEnd - blockStart;
+		for (size_t k = 0; k < blockWidth; k++) {
+			T* transposedRow = &transposedBlockColumn.get(k, 0);
+			for (size_t j = blockEnd; j < size; j++) {
+				transposedRow[j] = lower.get(j, blockStart + k);
+			}
+		}
+		for (size_t tileRow = blockEnd; tileRow < size; tileRow += CHOLESKY_BLOCK_SIZE) {
+			size_t tileRowEnd = std::min(tileRow + CHOLESKY_BLOCK_SIZE, size);
+			for (size_t tileCol = blockEnd; tileCol < tileRowEnd; tileCol += CHOLESKY_BLOCK_SIZE) {
+				for (size_t i = std::max(tileRow, tileCol); i < tileRowEnd; i++) {
+					T* rowI = &lower.get(i, 0);
+					size_t colEnd = std::min(tileCol + CHOLESKY_BLOCK_SIZE, i + 1);
+					for (size_t k = 0; k < blockWidth; k++) {
+						T factor = rowI[blockStart + k];
+						// interaction matrices are mostly banded, whole blocks of zeros are common
+						if (factor == 0) continue;
+						const T* transposedRow = &transposedBlockColumn.get(k, 0);
+						for (size_t j = tileCol; j < colEnd; j++) {
+							rowI[j] -= factor * transposedRow[j];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+template<typename T>
+void LargeCholeskyDecomposition<T>::solveInPlace(LargeVector<T>& v) const {
+	if (v.size != lower.height) throw "Dimensions do not align!";
+	size_t size = v.size;
+
+	// L * y = v
+	for (size_t i = 0; i < size; i++) {
+		const T* row = &lower.get(i, 0);
+		T total = v[i];
+		for (size_t k = 0; k < i; k++) {
+			total -= row[k] * v[k];
+		}
+		v[i] = total / row[i];
+	}
+	// L^T * x = y, L^T is walked by rows of L so the memory access stays contiguous
+	for (size_t i = size; i-- > 0;) {
+		const T* row = &lower.get(i, 0);
+		T value = v[i] / row[i];
+		v[i] = value;
+		for (size_t k = 0; k < i; k++) {
+			v[k] -= row[k] * value;
+		}
+	}
+}
+
+template class LargeLUDecomposition<double>;
+template class LargeLUDecomposition<float>;
+template class LargeCholeskyDecomposition<double>;
+template class LargeCholeskyDecomposition<float>;
+
@@ -238,4 +238,35 @@ LargeVector<T> operator*(const LargeSymmetricMatrix<T>& m, const LargeVector<T>&
 template<typename T>
 void destructiveSolve(LargeMatrix<T>& m, LargeVector<T>& v);
 
+/*
+	LU factorization with partial pivoting, P * m = L * U
+	Computed once, after which any number of right hand sides can be solved in O(n^2) each
+*/
+template<typename T>
+class LargeLUDecomposition {
+	LargeMatrix<T> lu;
+	size_t* permutation;
+public:
+	explicit LargeLUDecomposition(const LargeMatrix<T>& m);
+	~LargeLUDecomposition() { delete[] permutation; }
+	LargeLUDecomposition(const LargeLUDecomposition&) = delete;
+	LargeLUDecomposition& operator=(const LargeLUDecomposition&) = delete;
+
+	void solveInPlace(LargeVector<T>& v) const;
+};
 
+/*
+	Cholesky factorization m = L * L^T of a symmetric positive definite matrix, only the lower triangle of m is read
+	The factorization works on square tiles so the rows it touches stay in cache, every inner loop is a dot product of two contiguous rows
+	If m turns out not to be positive definite isPositiveDefinite returns false and the factorization must not be used
+*/
+template<typename T>
+class LargeCholeskyDecomposition {
+	LargeMatrix<T> lower;
+	bool positiveDefinite;
+public:
+	explicit LargeCholeskyDecomposition(const LargeMatrix<T>& m);
+
+	bool isPositiveDefinite() const { return positiveDefinite; }
+	void solveInPlace(LargeVector<T>& v) const;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../../math/bounds.h"
+#include "../../datastructures/boundsTree.h"
+#include "../../part.h"
+
+struct IntersectsBoundsFilter {
+	Bounds bounds;
+
+	IntersectsBoundsFilter() = default;
+	IntersectsBoundsFilter(const Bounds& bounds) : bounds(bounds) {}
+
+	bool operator()(const TreeNode& node) const {
+		return intersects(node.bounds, bounds);
+	}
+	bool operator()(const Part& part) const {
+		return intersects(part.getBounds(), bounds);
+	}
+};
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "../../math/bounds.h"
+#include "../../math/ray.h"
 #include "../../datastructures/boundsTree.h"
+#include "../../datastructures/childBounds.h"
 #include "../../part.h"
 
+#include <algorithm>
+
 struct RayIntersectBoundsFilter {
 	Ray ray;
 
@@ -15,6 +19,50 @@ struct RayIntersectBoundsFilter {
 		double d;
 		return doRayAndBoundsIntersect(node.bounds, ray, p, d);
 	}
+	/*
+		Tests all children of node at once, using a slab test relative to the ray start
+		Like doRayAndBoundsIntersect the ray extends in both directions
+	*/
+	unsigned int filterChildren(const TreeNode& node) const {
+		RelativeChildBounds children(node, ray.start);
+
+		// a direction of zero is replaced by a tiny one, so that the slab of that axis spans everything or nothing
+		double invX = (ray.direction.x != 0.0) ? 1.0 / ray.direction.x : 1e300;
+		double invY = (ray.direction.y != 0.0) ? 1.0 / ray.direction.y : 1e300;
+		double invZ = (ray.direction.z != 0.0) ? 1.0 / ray.direction.z : 1e300;
+#ifdef __AVX__
+		__m256d invDirX = _mm256_set1_pd(invX);
+		__m256d invDirY = _mm256_set1_pd(invY);
+		__m256d invDirZ = _mm256_set1_pd(invZ);
+
+		unsigned int hits = 0;
+		for(int block = 0; block < children.nodeCount; block += CHILD_BOUNDS_BLOCK) {
+			__m256d tx1 = _mm256_mul_pd(_mm256_load_pd(children.minX + block), invDirX);
+			__m256d tx2 = _mm256_mul_pd(_mm256_load_pd(children.maxX + block), invDirX);
+			__m256d ty1 = _mm256_mul_pd(_mm256_load_pd(children.minY + block), invDirY);
+			__m256d ty2 = _mm256_mul_pd(_mm256_load_pd(children.maxY + block), invDirY);
+			__m256d tz1 = _mm256_mul_pd(_mm256_load_pd(children.minZ + block), invDirZ);
+			__m256d tz2 = _mm256_mul_pd(_mm256_load_pd(children.maxZ + block), invDirZ);
+
+			__m256d tNear = _mm256_max_pd(_mm256_max_pd(_mm256_min_pd(tx1, tx2), _mm256_min_pd(ty1, ty2)), _mm256_min_pd(tz1, tz2));
+			__m256d tFar = _mm256_min_pd(_mm256_min_pd(_mm256_max_pd(tx1, tx2), _mm256_max_pd(ty1, ty2)), _mm256_max_pd(tz1, tz2));
+
+			hits |= static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(tNear, tFar, _CMP_LE_OQ))) << block;
+		}
+		return hits & children.getChildMask();
+#else
+		unsigned int result = 0;
+		for(int i = 0; i < children.nodeCount; i++) {
+			double tx1 = children.minX[i] * invX, tx2 = children.maxX[i] * invX;
+			double ty1 = children.minY[i] * invY, ty2 = children.maxY[i] * invY;
+			double tz1 = children.minZ[i] * invZ, tz2 = children.maxZ[i] * invZ;
+			double tNear = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::min(tz1, tz2));
+			double tFar = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::max(tz1, tz2));
+			if(tNear <= tFar) result |= 1U << i;
+		}
+		return result;
+#endif
+	}
 	bool operator()(const Part& part) const {
 		return true;
 	}
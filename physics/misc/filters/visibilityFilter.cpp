@@ -2,6 +2,7 @@
 
 #include "../../../util/log.h"
 #include "../../math/linalg/trigonometry.h"
+#include "../../datastructures/childBounds.h"
 
 VisibilityFilter::VisibilityFilter(const Position& origin, Vec3 normals[5], double maxDepth) :
 	origin(origin), 
@@ -83,6 +84,37 @@ bool VisibilityFilter::operator()(const TreeNode& node) const {
 	return true;
 }
 
+unsigned int VisibilityFilter::filterChildren(const TreeNode& node) const {
+	RelativeChildBounds children(node, origin);
+
+	double offsets[5]{0,0,0,0,maxDepth};
+	Vec3 normals[5]{up, down, left, right, forward};
+	unsigned int visible = children.getChildMask();
+	for(int i = 0; i < 5; i++) {
+		Vec3& normal = normals[i];
+		// same cornerOfInterest as for a single node, but for all children at once
+		const double* cornerX = (normal.x >= 0) ? children.minX : children.maxX;
+		const double* cornerY = (normal.y >= 0) ? children.minY : children.maxY;
+		const double* cornerZ = (normal.z >= 0) ? children.minZ : children.maxZ;
+#ifdef __AVX__
+		for(int block = 0; block < children.nodeCount; block += CHILD_BOUNDS_BLOCK) {
+			__m256d dot = _mm256_mul_pd(_mm256_load_pd(cornerX + block), _mm256_set1_pd(normal.x));
+			dot = _mm256_add_pd(dot, _mm256_mul_pd(_mm256_load_pd(cornerY + block), _mm256_set1_pd(normal.y)));
+			dot = _mm256_add_pd(dot, _mm256_mul_pd(_mm256_load_pd(cornerZ + block), _mm256_set1_pd(normal.z)));
+			unsigned int outside = static_cast<unsigned int>(_mm256_movemask_pd(_mm256_cmp_pd(dot, _mm256_set1_pd(offsets[i]), _CMP_GT_OQ)));
+			visible &= ~(outside << block);
+		}
+#else
+		for(int j = 0; j < children.nodeCount; j++) {
+			if(cornerX[j] * normal.x + cornerY[j] * normal.y + cornerZ[j] * normal.z > offsets[i])
+				visible &= ~(1U << j);
+		}
+#endif
+		if(visible == 0) break;
+	}
+	return visible;
+}
+
 bool VisibilityFilter::operator()(const Position& point) const {
 	double offsets[5] { 0,0,0,0,maxDepth };
 	Vec3 normals[5] { up, down, left, right, forward };
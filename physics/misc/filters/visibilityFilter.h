@@ -64,6 +64,8 @@ public:
 	static VisibilityFilter forSubWindow(const Position& origin, const Vec3& cameraForward, const Vec3& cameraUp, double fov, double aspect, double maxDepth, double left, double right, double down, double up);
 	
 	bool operator()(const TreeNode& node) const;
+	// returns a mask of the children of node that are visible, equivalent to applying operator()(const TreeNode&) to every child
+	unsigned int filterChildren(const TreeNode& node) const;
 	bool operator()(const Position& point) const;
 	bool operator()(const Part& part) const;
 
@@ -9,9 +9,12 @@ public:
 
 	DirectionalGravity(Vec3 gravity) : gravity(gravity) {}
 
-	virtual void apply(WorldPrototype* world) override {
-		for (MotorizedPhysical* p : world->iterPhysicals()) {
-			p->applyForceAtCenterOfMass(gravity * p->totalMass);
+	virtual bool appliesToPhysicalRanges() const override { return true; }
+	virtual void applyToPhysicals(const WorldPrototype* world, MotorizedPhysical* const* begin, MotorizedPhysical* const* end, ForceBuffer& forces) const override {
+		for (MotorizedPhysical* const* iter = begin; iter != end; ++iter) {
+			MotorizedPhysical* p = *iter;
+			if (p->isAsleep()) continue;
+			forces.applyForceAtCenterOfMass(*p, gravity * p->totalMass);
 		}
 	}
 	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const Part& part) const override {
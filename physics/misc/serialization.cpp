@@ -360,17 +360,24 @@ void DeSerializationSessionPrototype::deserializeWorld(WorldPrototype& world, st
 	uint64_t numberOfTerrainParts = ::deserialize<uint64_t>(istream);
 	world.physicals.reserve(numberOfPhysicals);
 
+	// all parts are added at once, so the trees are built in one go instead of one part at a time
+	std::vector<Part*> mainParts;
+	mainParts.reserve(numberOfPhysicals);
 	for(uint64_t i = 0; i < numberOfPhysicals; i++) {
 		MotorizedPhysical* p = deserializeMotorizedPhysicalWithContext(istream);
-		world.addPart(p->getMainPart());
+		mainParts.push_back(p->getMainPart());
 	}
+	world.addParts(mainParts);
 
+	std::vector<Part*> terrainParts;
+	terrainParts.reserve(numberOfTerrainParts);
 	for(uint64_t i = 0; i < numberOfTerrainParts; i++) {
 		GlobalCFrame cf = ::deserialize<GlobalCFrame>(istream);
 		Part* p = virtualDeserializePart(deserializeRawPart(GlobalCFrame(), istream), istream);
 		p->setCFrame(cf);
-		world.addTerrainPart(p);
+		terrainParts.push_back(p);
 	}
+	world.addTerrainParts(terrainParts);
 
 	std::uint32_t constraintCount = ::deserialize<std::uint32_t>(istream);
 	world.constraints.reserve(constraintCount);
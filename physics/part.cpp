@@ -3,6 +3,8 @@
 #include "physical.h"
 
 #include "geometry/intersection.h"
+#include "geometry/shapePairIntersection.h"
+#include "geometry/builtinShapeClasses.h"
 
 #include "misc/validityHelper.h"
 
@@ -70,8 +72,14 @@ Part& Part::operator=(Part&& other) {
 }
 
 PartIntersection Part::intersects(const Part& other) const {
+	Vec3f searchDirection(0.0f, 0.0f, 0.0f);
+	SupportHints supportHints;
+	return this->intersects(other, searchDirection, supportHints);
+}
+
+PartIntersection Part::intersects(const Part& other, Vec3f& searchDirection, SupportHints& supportHints) const {
 	CFrame relativeTransform = this->cframe.globalToLocal(other.cframe);
-	std::optional<Intersection> result = intersectsTransformed(this->hitbox, other.hitbox, relativeTransform);
+	std::optional<Intersection> result = intersectsTransformed(this->hitbox, other.hitbox, relativeTransform, searchDirection, supportHints);
 	if(result) {
 		Position intersection = this->cframe.localToGlobal(result.value().intersection);
 		Vec3 exitVector = this->cframe.localToRelative(result.value().exitVector);
@@ -85,6 +93,23 @@ PartIntersection Part::intersects(const Part& other) const {
 	return PartIntersection();
 }
 
+bool Part::findContactArea(const Part& other, PartIntersection& intersection) const {
+	if(this->hitbox.baseShape->intersectionClassID != CUBE_CLASS_ID || other.hitbox.baseShape->intersectionClassID != CUBE_CLASS_ID) return false;
+
+	CFrame relativeTransform = this->cframe.globalToLocal(other.cframe);
+	Vec3 points[CONTACT_MANIFOLD_MAX_POINTS];
+	double depths[CONTACT_MANIFOLD_MAX_POINTS];
+	int count = cubeCubeContactPoints(relativeTransform, this->hitbox.scale, other.hitbox.scale, this->cframe.relativeToLocal(intersection.exitVector), points, depths);
+	if(count == 0) return false;
+
+	Vec3 normal = normalize(intersection.exitVector);
+	for(int i = 0; i < count; i++) {
+		intersection.contacts[i] = Contact{this->cframe.localToGlobal(points[i]), normal * depths[i]};
+	}
+	intersection.contactCount = count;
+	return true;
+}
+
 BoundingBox Part::getLocalBounds() const {
 	Vec3 v = Vec3(this->hitbox.scale[0], this->hitbox.scale[1], this->hitbox.scale[2]);
 	return BoundingBox(-v, v);
@@ -8,11 +8,13 @@ class ConnectedPhysical;
 class MotorizedPhysical;
 class WorldPrototype;
 #include "geometry/shape.h"
+#include "geometry/genericCollidable.h"
 #include "math/linalg/mat.h"
 #include "math/position.h"
 #include "math/globalCFrame.h"
 #include "math/bounds.h"
 #include "motion.h"
+#include "contactManifold.h"
 
 struct PartProperties {
 	double density;
@@ -32,12 +34,20 @@ struct PartIntersection {
 	bool intersects;
 	Position intersection;
 	Vec3 exitVector;
+	/*
+		The points the parts touch at, only intersection itself unless filled in by findContactArea or from a ContactManifold
+	*/
+	int contactCount;
+	Contact contacts[CONTACT_MANIFOLD_MAX_POINTS];
 
-	PartIntersection() : intersects(false) {}
+	PartIntersection() : intersects(false), contactCount(0) {}
 	PartIntersection(const Position& intersection, const Vec3& exitVector) :
 		intersects(true),
 		intersection(intersection),
-		exitVector(exitVector) {}
+		exitVector(exitVector),
+		contactCount(1) {
+		contacts[0] = Contact{intersection, exitVector};
+	}
 };
 
 
@@ -70,6 +80,15 @@ public:
 
 
 	PartIntersection intersects(const Part& other) const;
+	/*
+		Warm started intersection test, searchDirection is local to this part, see intersectsTransformed
+	*/
+	PartIntersection intersects(const Part& other, Vec3f& searchDirection, SupportHints& supportHints) const;
+	/*
+		Replaces the single contact of intersection, as found by intersects, by the whole contact area when the shapes of the parts give it directly
+		Only two cubes touching face to face do so for now, returns false for all other pairs
+	*/
+	bool findContactArea(const Part& other, PartIntersection& intersection) const;
 	void scale(double scaleX, double scaleY, double scaleZ);
 
 	Bounds getBounds() const;
@@ -82,6 +101,7 @@ public:
 	Position getCenterOfMass() const { return cframe.localToGlobal(this->getLocalCenterOfMass()); }
 	SymmetricMat3 getInertia() const { return hitbox.getInertia() * properties.density; }
 	const GlobalCFrame& getCFrame() const { return cframe; }
+	// terrain parts that are in a world must be moved with WorldPrototype::setTerrainPartCFrame
 	void setCFrame(const GlobalCFrame& newCFrame);
 
 	CFrame transformCFrameToParent(const CFrame& cframeRelativeToPart);
@@ -8,6 +8,7 @@
 #include "math/linalg/trigonometry.h"
 
 #include "debug.h"
+#include "constants.h"
 #include <algorithm>
 #include <limits>
 
@@ -500,8 +501,13 @@ void ConnectedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
 }
 
 void MotorizedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
+	if(asleep) wakeUp();
 	if(this->mainPhysical->world != nullptr) {
 		Bounds oldMainPartBounds = this->rigidBody.mainPart->getBounds();
+		Bounds oldBounds = oldMainPartBounds;
+		this->forEachPart([&oldBounds](const Part& part) {
+			oldBounds = unionOfBounds(oldBounds, part.getBounds());
+		});
 
 		rigidBody.setCFrame(newCFrame);
 		for(ConnectedPhysical& conPhys : childPhysicals) {
@@ -509,6 +515,8 @@ void MotorizedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
 		}
 
 		this->mainPhysical->world->notifyPartGroupBoundsUpdated(this->rigidBody.mainPart, oldMainPartBounds);
+		// whatever was resting on or against this physical lost its support
+		this->mainPhysical->world->wakeUpPhysicalsNear(oldBounds);
 	} else {
 		rigidBody.setCFrame(newCFrame);
 		for(ConnectedPhysical& conPhys : childPhysicals) {
@@ -680,6 +688,35 @@ void MotorizedPhysical::update(double deltaT) {
 	updateAttachedPhysicals();
 }
 
+void MotorizedPhysical::wakeUp() {
+	asleep = false;
+	ticksResting = 0;
+	averageVelocity = Vec3(0.0, 0.0, 0.0);
+	averageAngularVelocity = Vec3(0.0, 0.0, 0.0);
+}
+
+void MotorizedPhysical::updateSleepState() {
+	averageVelocity += (motionOfCenterOfMass.getVelocity() - averageVelocity) * SLEEP_VELOCITY_SMOOTHING;
+	averageAngularVelocity += (motionOfCenterOfMass.getAngularVelocity() - averageAngularVelocity) * SLEEP_VELOCITY_SMOOTHING;
+
+	bool belowThresholds = 
+		lengthSquared(averageVelocity) < SLEEP_VELOCITY_THRESHOLD * SLEEP_VELOCITY_THRESHOLD && 
+		lengthSquared(averageAngularVelocity) < SLEEP_ANGULAR_VELOCITY_THRESHOLD * SLEEP_ANGULAR_VELOCITY_THRESHOLD;
+
+	if(!belowThresholds || childPhysicals.size() != 0) {
+		ticksResting = 0;
+		return;
+	}
+
+	ticksResting++;
+	if(ticksResting >= SLEEP_TICKS) {
+		asleep = true;
+		motionOfCenterOfMass = Motion();
+		totalForce = Vec3();
+		totalMoment = Vec3();
+	}
+}
+
 #pragma endregion
 
 /*
@@ -690,6 +727,7 @@ void MotorizedPhysical::update(double deltaT) {
 
 void MotorizedPhysical::applyForceAtCenterOfMass(Vec3 force) {
 	assert(isVecValid(force));
+	if(asleep) wakeUp();
 	totalForce += force;
 
 	Debug::logVector(getCenterOfMass(), force, Debug::FORCE);
@@ -698,6 +736,7 @@ void MotorizedPhysical::applyForceAtCenterOfMass(Vec3 force) {
 void MotorizedPhysical::applyForce(Vec3Relative origin, Vec3 force) {
 	assert(isVecValid(origin));
 	assert(isVecValid(force));
+	if(asleep) wakeUp();
 	totalForce += force;
 
 	Debug::logVector(getCenterOfMass() + origin, force, Debug::FORCE);
@@ -707,18 +746,21 @@ void MotorizedPhysical::applyForce(Vec3Relative origin, Vec3 force) {
 
 void MotorizedPhysical::applyMoment(Vec3 moment) {
 	assert(isVecValid(moment));
+	if(asleep) wakeUp();
 	totalMoment += moment;
 	Debug::logVector(getCenterOfMass(), moment, Debug::MOMENT);
 }
 
 void MotorizedPhysical::applyImpulseAtCenterOfMass(Vec3 impulse) {
 	assert(isVecValid(impulse));
+	if(asleep) wakeUp();
 	Debug::logVector(getCenterOfMass(), impulse, Debug::IMPULSE);
 	motionOfCenterOfMass.translation.translation[0] += forceResponse * impulse;
 }
 void MotorizedPhysical::applyImpulse(Vec3Relative origin, Vec3Relative impulse) {
 	assert(isVecValid(origin));
 	assert(isVecValid(impulse));
+	if(asleep) wakeUp();
 	Debug::logVector(getCenterOfMass() + origin, impulse, Debug::IMPULSE);
 	motionOfCenterOfMass.translation.translation[0] += forceResponse * impulse;
 	Vec3 angularImpulse = origin % impulse;
@@ -726,6 +768,7 @@ void MotorizedPhysical::applyImpulse(Vec3Relative origin, Vec3Relative impulse)
 }
 void MotorizedPhysical::applyAngularImpulse(Vec3 angularImpulse) {
 	assert(isVecValid(angularImpulse));
+	if(asleep) wakeUp();
 	Debug::logVector(getCenterOfMass(), angularImpulse, Debug::ANGULAR_IMPULSE);
 	Vec3 localAngularImpulse = getCFrame().relativeToLocal(angularImpulse);
 	Vec3 localRotAcc = momentResponse * localAngularImpulse;
@@ -735,12 +778,14 @@ void MotorizedPhysical::applyAngularImpulse(Vec3 angularImpulse) {
 
 void MotorizedPhysical::applyDragAtCenterOfMass(Vec3 drag) {
 	assert(isVecValid(drag));
+	if(asleep) wakeUp();
 	Debug::logVector(getCenterOfMass(), drag, Debug::POSITION);
 	translate(forceResponse * drag);
 }
 void MotorizedPhysical::applyDrag(Vec3Relative origin, Vec3Relative drag) {
 	assert(isVecValid(origin));
 	assert(isVecValid(drag));
+	if(asleep) wakeUp();
 	Debug::logVector(getCenterOfMass() + origin, drag, Debug::POSITION);
 	translateUnsafeRecursive(forceResponse * drag);
 	Vec3 angularDrag = origin % drag;
@@ -748,6 +793,7 @@ void MotorizedPhysical::applyDrag(Vec3Relative origin, Vec3Relative drag) {
 }
 void MotorizedPhysical::applyAngularDrag(Vec3 angularDrag) {
 	assert(isVecValid(angularDrag));
+	if(asleep) wakeUp();
 	Debug::logVector(getCenterOfMass(), angularDrag, Debug::INFO_VEC);
 	Vec3 localAngularDrag = getCFrame().relativeToLocal(angularDrag);
 	Vec3 localRotAcc = momentResponse * localAngularDrag;
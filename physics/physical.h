@@ -222,6 +222,22 @@ public:
 	SymmetricMat3 momentResponse;
 
 	Motion motionOfCenterOfMass;
+
+	/*
+		Running averages of the velocity, compared against the sleep thresholds
+		Resting contacts make the instantaneous velocity jitter back and forth, the average cancels this out
+	*/
+	Vec3 averageVelocity = Vec3(0.0, 0.0, 0.0);
+	Vec3 averageAngularVelocity = Vec3(0.0, 0.0, 0.0);
+	/*
+		The number of consecutive updates this physical has stayed below the sleep thresholds
+	*/
+	int ticksResting = 0;
+	/*
+		Sleeping physicals are not updated, their bounds are not recalculated, and they aren't tested for colissions against other sleeping physicals or terrain
+		Only worlds with allowSleeping put physicals to sleep
+	*/
+	bool asleep = false;
 	
 	explicit MotorizedPhysical(Part* mainPart);
 	explicit MotorizedPhysical(RigidBody&& rigidBody);
@@ -255,6 +271,18 @@ public:
 
 	void update(double deltaT);
 
+	inline bool isAsleep() const { return asleep; }
+	/*
+		Returns true if the physical was below the sleep thresholds after its last update
+	*/
+	inline bool isResting() const { return ticksResting != 0; }
+	void wakeUp();
+	/*
+		Puts this physical to sleep once it has been resting for SLEEP_TICKS updates, called by the world after update
+		Physicals with attached physicals never sleep, their constraints may keep them moving at no velocity of their own
+	*/
+	void updateSleepState();
+
 	void setCFrame(const GlobalCFrame& newCFrame);
 	void rotateAroundCenterOfMass(const Rotation& rotation);
 	void translate(const Vec3& translation);
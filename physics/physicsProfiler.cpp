@@ -4,7 +4,9 @@ const char * physicsLabels[]{
 	"GJK Col",
 	"GJK No Col",
 	"EPA",
-	"Collision",
+	"Shape Pair",
+	"Broadphase",
+	"Narrowphase",
 	"Externals",
 	"Col. Handling",
 	"Constraints",
@@ -13,6 +15,7 @@ const char * physicsLabels[]{
 	"Wait for lock",
 	"Updates",
 	"Queue",
+	"Snapshot",
 	"Other"
 };
 
@@ -43,6 +46,9 @@ const char* iterationLabels[]{
 	"MAX",
 };
 
+thread_local bool profilePhysicsOnThisThread = true;
+thread_local NarrowphaseIterationTally* narrowphaseIterationTallyOnThisThread = nullptr;
+
 BreakdownAverageProfiler<PhysicsProcess> physicsMeasure(physicsLabels, 100);
 HistoricTally<long long, IntersectionResult> intersectionStatistics(intersectionLabels, 1);
 CircularBuffer<int> gjkCollideIterStats(1);
@@ -6,7 +6,9 @@ enum class PhysicsProcess {
 	GJK_COL,
 	GJK_NO_COL,
 	EPA,
-	COLISSION_OTHER,
+	SHAPE_PAIR,
+	BROADPHASE,
+	NARROWPHASE,
 	EXTERNALS,
 	COLISSION_HANDLING,
 	CONSTRAINTS,
@@ -15,6 +17,7 @@ enum class PhysicsProcess {
 	WAIT_FOR_LOCK,
 	UPDATING,
 	QUEUE,
+	SNAPSHOT,
 	OTHER,
 	COUNT
 };
@@ -35,6 +38,63 @@ enum class IterationTime {
 	COUNT = 17
 };
 
+/*
+	Counts intersection results on a thread that may not touch intersectionStatistics, 
+	to be added to it later from the thread running the tick
+*/
+struct IntersectionTally {
+	long long counts[static_cast<size_t>(IntersectionResult::COUNT)]{};
+
+	inline void addToTally(IntersectionResult category, long long amount) {
+		counts[static_cast<size_t>(category)] += amount;
+	}
+
+	inline void clear() {
+		for(long long& c : counts) c = 0;
+	}
+};
+
+/*
+	Counts GJK or EPA iterations like the IterationTime tallies below, on a thread that may not touch those
+*/
+struct IterationTally {
+	long long counts[static_cast<size_t>(IterationTime::COUNT)]{};
+
+	inline void addToTally(IterationTime category, long long amount) {
+		counts[static_cast<size_t>(category)] += amount;
+	}
+
+	inline void clear() {
+		for(long long& c : counts) c = 0;
+	}
+};
+
+/*
+	The iterations of the GJK and EPA runs of one thread, to be added to GJKCollidesIterationStatistics, 
+	GJKNoCollidesIterationStatistics and EPAIterationStatistics later from the thread running the tick
+*/
+struct NarrowphaseIterationTally {
+	IterationTally gjkCollides;
+	IterationTally gjkNoCollides;
+	IterationTally epa;
+
+	inline void clear() {
+		gjkCollides.clear();
+		gjkNoCollides.clear();
+		epa.clear();
+	}
+};
+
+/*
+	The profilers and tallies below may only be used by one thread at a time, normally the one ticking the world
+	Code that runs intersection tests on other threads turns this off for that thread
+*/
+extern thread_local bool profilePhysicsOnThisThread;
+/*
+	While profilePhysicsOnThisThread is off, GJK and EPA count their iterations here instead, if it is set
+*/
+extern thread_local NarrowphaseIterationTally* narrowphaseIterationTallyOnThisThread;
+
 extern BreakdownAverageProfiler<PhysicsProcess> physicsMeasure;
 extern HistoricTally<long long, IntersectionResult> intersectionStatistics;
 extern CircularBuffer<int> gjkCollideIterStats;
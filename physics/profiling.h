@@ -44,6 +44,10 @@ public:
 		currentTally[static_cast<size_t>(category)] += amount;
 	}
 
+	inline const ParallelArray<Unit, static_cast<size_t>(Category::COUNT)>& getCurrentTally() const {
+		return currentTally;
+	}
+
 	inline void clearCurrentTally() {
 		for(size_t i = 0; i < static_cast<size_t>(Category::COUNT); i++) {
 			currentTally[i] = Unit(0);
@@ -1,80 +1,173 @@
 #pragma once
 
-#include <queue>
 #include <mutex>
 #include <shared_mutex>
 #include <functional>
+#include <utility>
 
 #include "world.h"
 #include "sharedLockGuard.h"
 #include "physicsProfiler.h"
+#include "datastructures/snapshotExchange.h"
+#include "threading/mpscQueue.h"
+#include "threading/inlineFunction.h"
+
+// the number of operations that can wait in each queue of a SynchronizedWorld before pushing them takes a lock, must be a power of two
+#define OPERATION_QUEUE_CAPACITY 4096
+
+/*
+	The properties of a part besides its CFrame, bounds and scale that readers of a snapshot need, copied into every PartSnapshot
+	Empty by default, part types with visuals of their own specialize it
+*/
+template<typename T>
+struct PartSnapshotVisuals {
+	PartSnapshotVisuals(const T&) {}
+};
+
+/*
+	A copy of everything about a part that is needed to draw it, the part itself may be deleted while the snapshot is read
+	partId, parentId and mainPhysicalId only identify the part and its physicals, they are never dereferenced
+*/
+template<typename T>
+struct PartSnapshot {
+	const void* partId;
+	const void* parentId;
+	const void* mainPhysicalId;
+	bool isMainPart;
+	bool isMainPhysical;
+	GlobalCFrame cframe;
+	Bounds bounds;
+	DiagonalMat3 scale;
+	PartSnapshotVisuals<T> visuals;
+
+	PartSnapshot(const T& part) :
+		partId(&part),
+		parentId(part.parent),
+		mainPhysicalId(part.parent != nullptr ? part.parent->mainPhysical : nullptr),
+		isMainPart(part.isMainPart()),
+		isMainPhysical(part.parent != nullptr && part.parent->isMainPhysical()),
+		cframe(part.getCFrame()),
+		bounds(part.getBounds()),
+		scale(part.hitbox.scale),
+		visuals(part) {}
+};
+
+/*
+	The CFrames, bounds and visuals of all parts of a SynchronizedWorld, as they were after a tick or a modification
+*/
+template<typename T>
+struct WorldSnapshot {
+	size_t age = 0;
+	std::vector<PartSnapshot<T>> parts;
+};
 
 template<typename T = Part>
 class SynchronizedWorld : public World<T> {
 	mutable std::shared_mutex lock;
-	mutable std::mutex queueLock;
-	mutable std::mutex readQueueLock;
 
-	std::queue<std::function<void()>> waitingOperations;
-	mutable std::queue<std::function<void()>> waitingReadOnlyOperations;
+	/*
+		Operations that couldn't get the lock right away, run by the ticking thread
+		Pushing never waits for the ticking thread, not even while it runs the operations
+	*/
+	MPSCQueue<InlineFunction> waitingOperations{OPERATION_QUEUE_CAPACITY};
+	mutable MPSCQueue<InlineFunction> waitingReadOnlyOperations{OPERATION_QUEUE_CAPACITY};
 
-	void pushOperation(const std::function<void()>& func) {
-		std::lock_guard<std::mutex> lg(queueLock);
-		waitingOperations.push(func);
-	}
-	void pushReadOnlyOperation(const std::function<void()>& func) const {
-		std::lock_guard<std::mutex> lg(readQueueLock);
-		waitingReadOnlyOperations.push(func);
-	}
+	SnapshotExchange<WorldSnapshot<T>> snapshots;
 
 	void processQueue() {
-		std::lock_guard<std::mutex> lg(queueLock);
-
-		while (!waitingOperations.empty()) {
-			std::function<void()>& operation = waitingOperations.front();
+		waitingOperations.consumeAll([](InlineFunction& operation) {
 			operation();
-			waitingOperations.pop();
-		}
+		});
 	}
 
 	void processReadQueue() const {
-		std::lock_guard<std::mutex> lg(readQueueLock);
-
-		while (!waitingReadOnlyOperations.empty()) {
-			std::function<void()>& operation = waitingReadOnlyOperations.front();
+		waitingReadOnlyOperations.consumeAll([](InlineFunction& operation) {
 			operation();
-			waitingReadOnlyOperations.pop();
+		});
+	}
+
+	void fillSnapshot(WorldSnapshot<T>& snapshot) const {
+		snapshot.age = this->age;
+		snapshot.parts.clear();
+		for (const T& part : this->iterParts(ALL_PARTS)) {
+			snapshot.parts.emplace_back(part);
 		}
 	}
 
+	/*
+		The world may not be modified meanwhile, the caller must hold at least a shared lock
+		Snapshots are only published from the ticking thread or by modifications, which exclude each other through the lock
+	*/
+	void publishSnapshot() {
+		fillSnapshot(snapshots.beginWrite());
+		snapshots.publish();
+	}
+
 public:
+	/*
+		Publishes a snapshot of all parts after every tick and every modification, see readSnapshot and PartSnapshot
+		Readers of snapshots never wait for the ticking thread, and the ticking thread never waits for them
+	*/
+	bool publishSnapshots = false;
 
 	SynchronizedWorld<T>(double deltaT) : World<T>(deltaT) {}
 
 	void syncModification(const std::function<void()>& function) {
 		std::lock_guard<std::shared_mutex> lg(lock);
 		function();
+		if (publishSnapshots) publishSnapshot();
 	}
-	void asyncModification(const std::function<void()>& function) {
+	/*
+		Runs function right away if the world isn't locked, otherwise the ticking thread runs it after the next update
+		function is stored without allocating if it is small enough, see InlineFunction
+	*/
+	template<typename Func>
+	void asyncModification(Func&& function) {
 		if (lock.try_lock()) {
 			UnlockOnDestroy lg(lock);
 			function();
+			if (publishSnapshots) publishSnapshot();
 		} else {
-			pushOperation(function);
+			waitingOperations.push(InlineFunction(std::forward<Func>(function)));
 		}
 	}
 	void syncReadOnlyOperation(const std::function<void()>& function) const {
 		SharedLockGuard lg(lock);
 		function();
 	}
-	void asyncReadOnlyOperation(const std::function<void()>& function) const {
+	template<typename Func>
+	void asyncReadOnlyOperation(Func&& function) const {
 		if (lock.try_lock_shared()) {
 			UnlockSharedOnDestroy lg(lock);
 			function();
 		} else {
-			pushReadOnlyOperation(function);
+			waitingReadOnlyOperations.push(InlineFunction(std::forward<Func>(function)));
+		}
+	}
+	/*
+		Calls function with the latest published snapshot, without taking the lock
+		The snapshot stays valid and unchanged until function returns, even while the world ticks
+		Before the first snapshot is published, function gets a snapshot made on the spot under the shared lock
+	*/
+	void readSnapshot(const std::function<void(const WorldSnapshot<T>&)>& function) const {
+		typename SnapshotExchange<WorldSnapshot<T>>::Reader reader(snapshots);
+		if (reader.hasSnapshot()) {
+			function(*reader);
+		} else {
+			readCurrentSnapshot(function);
 		}
 	}
+	/*
+		Calls function with a snapshot made on the spot under the shared lock, so it also shows parts changed outside of a modification
+		Meant for when the world isn't ticking, for example while paused, the lock is then never contended
+	*/
+	void readCurrentSnapshot(const std::function<void(const WorldSnapshot<T>&)>& function) const {
+		WorldSnapshot<T> snapshot;
+		syncReadOnlyOperation([this, &snapshot]() {
+			fillSnapshot(snapshot);
+		});
+		function(snapshot);
+	}
 
 	virtual void tick() override {
 		SharedLockGuard mutLock(lock);
@@ -85,6 +178,7 @@ public:
 		this->applyExternalForces();
 
 		this->handleColissions();
+		this->applyDeferredForces();
 
 		intersectionStatistics.nextTally();
 
@@ -100,6 +194,11 @@ public:
 		physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
 		mutLock.downgrade();
 
+		if (publishSnapshots) {
+			physicsMeasure.mark(PhysicsProcess::SNAPSHOT);
+			publishSnapshot();
+		}
+
 		physicsMeasure.mark(PhysicsProcess::QUEUE);
 		processReadQueue();
 	}
@@ -0,0 +1,162 @@
+#include "fixedStepTicker.h"
+
+#include "../../util/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std::chrono;
+
+size_t LatencyHistogram::getBucket(nanoseconds duration) {
+	long long micros = duration_cast<microseconds>(duration).count();
+	size_t bucket = 0;
+	while(micros > 0 && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+		micros >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+microseconds LatencyHistogram::getBucketLimit(size_t bucket) {
+	if(bucket >= LATENCY_HISTOGRAM_BUCKETS - 1) return microseconds::max();
+	return microseconds(1LL << bucket);
+}
+
+void LatencyHistogram::add(nanoseconds duration) {
+	if(duration < nanoseconds(0)) duration = nanoseconds(0);
+	counts[getBucket(duration)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::clear() {
+	for(std::atomic<uint64_t>& count : counts) {
+		count.store(0, std::memory_order_relaxed);
+	}
+}
+
+uint64_t LatencyHistogram::getTotalCount() const {
+	uint64_t total = 0;
+	for(size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		total += getCount(i);
+	}
+	return total;
+}
+
+microseconds LatencyHistogram::getPercentileLimit(double fraction) const {
+	uint64_t total = getTotalCount();
+	uint64_t needed = static_cast<uint64_t>(std::ceil(fraction * total));
+	uint64_t counted = 0;
+	for(size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		counted += getCount(i);
+		if(counted >= needed) return getBucketLimit(i);
+	}
+	return getBucketLimit(LATENCY_HISTOGRAM_BUCKETS - 1);
+}
+
+TickPlan FixedStepSchedule::plan(steady_clock::time_point now, const TickerSettings& settings) {
+	TickPlan result;
+	double tickRate = settings.ticksPerSecond * settings.speed;
+	if(!(tickRate >= MIN_TICK_RATE)) {
+		// paused, negative and NaN rates included, there is no tick interval to divide the lag by
+		nextTickDue = now + milliseconds(PAUSED_TICKER_POLL_MS);
+		result.firstTickDue = nextTickDue;
+		return result;
+	}
+	result.tickInterval = std::max(duration_cast<nanoseconds>(duration<double>(1.0 / tickRate)), nanoseconds(1));
+	if(now < nextTickDue) {
+		result.firstTickDue = nextTickDue;
+		return result;
+	}
+
+	nanoseconds lag = now - nextTickDue;
+	if(lag > settings.maxLag) {
+		result.droppedTicks = lag / result.tickInterval;
+		nextTickDue = now;
+		lag = nanoseconds(0);
+	}
+	result.firstTickDue = nextTickDue;
+
+	// the tick at nextTickDue and every one that has come due since
+	long long ticksDue = lag / result.tickInterval + 1;
+
+	switch(settings.policy) {
+	case CatchUpPolicy::NO_CATCH_UP:
+		result.tickCount = 1;
+		break;
+	case CatchUpPolicy::BOUNDED_CATCH_UP:
+		result.tickCount = static_cast<int>(std::min<long long>(ticksDue, 1 + settings.maxCatchUpTicks));
+		break;
+	case CatchUpPolicy::SUBSTEP: {
+		int substeps = std::max(settings.substeps, 1);
+		long long groupsDue = (ticksDue + substeps - 1) / substeps;
+		result.tickCount = static_cast<int>(std::min<long long>(groupsDue, 1 + settings.maxCatchUpTicks)) * substeps;
+		break;
+	}
+	case CatchUpPolicy::ADAPTIVE_STEP:
+		result.tickCount = 1;
+		result.stepScale = std::max(1.0, std::min(static_cast<double>(ticksDue), settings.maxStepScale));
+		break;
+	}
+
+	nextTickDue += duration_cast<nanoseconds>(result.tickInterval * (result.tickCount * result.stepScale));
+	return result;
+}
+
+FixedStepTicker::FixedStepTicker(const TickerSettings& settings, std::function<void(double)> tickAction) :
+	settings(settings), tickAction(std::move(tickAction)) {}
+
+FixedStepTicker::~FixedStepTicker() {
+	stop();
+}
+
+void FixedStepTicker::start() {
+	if(!stopped.exchange(false)) return;
+	schedule.reset(steady_clock::now());
+	thread = std::thread(&FixedStepTicker::run, this);
+}
+
+void FixedStepTicker::stop() {
+	stopped.store(true);
+	if(thread.joinable()) thread.join();
+}
+
+void FixedStepTicker::run() {
+	while(!stopped.load()) {
+		TickPlan plan = schedule.plan(steady_clock::now(), getSettings());
+
+		if(plan.droppedTicks != 0) {
+			droppedTicks.fetch_add(plan.droppedTicks, std::memory_order_relaxed);
+			Log::warn("Can't keep up! Skipping %d ticks!", static_cast<int>(plan.droppedTicks));
+		}
+
+		for(int i = 0; i < plan.tickCount && !stopped.load(); i++) {
+			steady_clock::time_point tickStart = steady_clock::now();
+			tickLatency.add(tickStart - (plan.firstTickDue + plan.tickInterval * i));
+			tickAction(plan.stepScale);
+			tickDuration.add(steady_clock::now() - tickStart);
+			ticksRun.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		std::this_thread::sleep_until(schedule.getNextTickDue());
+	}
+}
+
+void FixedStepTicker::runTick() {
+	tickAction(1.0);
+}
+
+TickerSettings FixedStepTicker::getSettings() const {
+	std::lock_guard<std::mutex> lock(settingsMutex);
+	return settings;
+}
+
+void FixedStepTicker::setSettings(const TickerSettings& newSettings) {
+	std::lock_guard<std::mutex> lock(settingsMutex);
+	settings = newSettings;
+}
+
+void FixedStepTicker::clearStatistics() {
+	tickLatency.clear();
+	tickDuration.clear();
+	ticksRun.store(0);
+	droppedTicks.store(0);
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// bucket 0 of a LatencyHistogram counts durations under a microsecond, bucket i > 0 those of [2^(i-1), 2^i) microseconds, the last bucket everything longer
+#define LATENCY_HISTOGRAM_BUCKETS 24
+// a ticker set to fewer ticks per second than this, ticksPerSecond * speed, is paused, this includes a speed or ticksPerSecond of 0
+#define MIN_TICK_RATE 0.001
+// how long a paused ticker waits before looking at its settings again
+#define PAUSED_TICKER_POLL_MS 10
+
+/*
+	Counts durations in buckets that double in size, can be added to from one thread while others read it
+*/
+class LatencyHistogram {
+	std::atomic<uint64_t> counts[LATENCY_HISTOGRAM_BUCKETS];
+public:
+	LatencyHistogram() { clear(); }
+
+	void add(std::chrono::nanoseconds duration);
+	void clear();
+
+	inline uint64_t getCount(size_t bucket) const { return counts[bucket].load(std::memory_order_relaxed); }
+	uint64_t getTotalCount() const;
+
+	static size_t getBucket(std::chrono::nanoseconds duration);
+	// the durations in bucket are all shorter than this
+	static std::chrono::microseconds getBucketLimit(size_t bucket);
+
+	/*
+		The limit of the first bucket up to which at least fraction of all durations fall, so an upper bound for that percentile
+	*/
+	std::chrono::microseconds getPercentileLimit(double fraction) const;
+};
+
+/*
+	How a FixedStepTicker makes up for ticks that start late, because earlier ticks took too long or the thread was not scheduled
+*/
+enum class CatchUpPolicy {
+	// a single tick per wake-up, the time it falls behind is never made up, only dropped once it exceeds maxLag
+	NO_CATCH_UP,
+	// the ticks that are due run back to back, at most maxCatchUpTicks more than usual in one wake-up
+	BOUNDED_CATCH_UP,
+	// substeps ticks run back to back every substeps tick intervals, catching up like BOUNDED_CATCH_UP in whole groups of substeps
+	SUBSTEP,
+	// a single tick per wake-up, but its step is made up to maxStepScale times as long to cover the ticks that are due
+	ADAPTIVE_STEP
+};
+
+struct TickerSettings {
+	double ticksPerSecond = 100.0;
+	// the ticks are this many times as frequent as ticksPerSecond says, 0 pauses the ticker
+	double speed = 1.0;
+	CatchUpPolicy policy = CatchUpPolicy::BOUNDED_CATCH_UP;
+	int substeps = 1;
+	int maxCatchUpTicks = 4;
+	double maxStepScale = 4.0;
+	// whatever the policy, a lag longer than this is dropped and counted in droppedTicks
+	std::chrono::nanoseconds maxLag = std::chrono::milliseconds(1000);
+};
+
+/*
+	What to do at one wake-up of a FixedStepTicker
+*/
+struct TickPlan {
+	int tickCount = 0;
+	// every tick of this plan covers stepScale tick intervals, only ADAPTIVE_STEP makes this more than 1
+	double stepScale = 1.0;
+	std::chrono::steady_clock::time_point firstTickDue;
+	std::chrono::nanoseconds tickInterval{0};
+	// ticks given up on at this wake-up, because the ticker lagged more than maxLag behind
+	uint64_t droppedTicks = 0;
+};
+
+/*
+	The timing of a FixedStepTicker, without the thread, so it can be driven with any clock
+*/
+class FixedStepSchedule {
+	std::chrono::steady_clock::time_point nextTickDue;
+public:
+	void reset(std::chrono::steady_clock::time_point now) { nextTickDue = now; }
+
+	/*
+		Decides how many ticks to run at now, and moves the schedule past them
+		While the tick rate is below MIN_TICK_RATE no ticks are planned, the schedule is moved PAUSED_TICKER_POLL_MS past now
+	*/
+	TickPlan plan(std::chrono::steady_clock::time_point now, const TickerSettings& settings);
+
+	inline std::chrono::steady_clock::time_point getNextTickDue() const { return nextTickDue; }
+};
+
+/*
+	Runs tickAction on a thread of its own at a fixed rate, following settings.policy when it falls behind
+	tickAction receives the stepScale of its tick, the number of tick intervals of simulated time it should advance
+
+	The latency of every tick, how long after it was due it started, and the time it took are kept in histograms,
+	together with the number of ticks run and dropped, all of which can be read from other threads while ticking
+*/
+class FixedStepTicker {
+	std::thread thread;
+	std::atomic<bool> stopped{true};
+
+	mutable std::mutex settingsMutex;
+	TickerSettings settings;
+
+	FixedStepSchedule schedule;
+	std::function<void(double)> tickAction;
+
+	void run();
+
+public:
+	LatencyHistogram tickLatency;
+	LatencyHistogram tickDuration;
+	std::atomic<uint64_t> ticksRun{0};
+	std::atomic<uint64_t> droppedTicks{0};
+
+	FixedStepTicker(const TickerSettings& settings, std::function<void(double)> tickAction);
+	~FixedStepTicker();
+
+	FixedStepTicker(const FixedStepTicker&) = delete;
+	FixedStepTicker(FixedStepTicker&&) = delete;
+	FixedStepTicker& operator=(const FixedStepTicker&) = delete;
+	FixedStepTicker& operator=(FixedStepTicker&&) = delete;
+
+	/*
+		Starts ticking from now, time spent stopped is not caught up on
+	*/
+	void start();
+	void stop();
+	inline bool isRunning() const { return !stopped.load(); }
+
+	/*
+		Runs a single tick on the calling thread, only allowed while stopped
+	*/
+	void runTick();
+
+	// settings can be changed while ticking, they are picked up at the next wake-up
+	TickerSettings getSettings() const;
+	void setSettings(const TickerSettings& newSettings);
+
+	void clearStatistics();
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// callables up to this size are stored inside the InlineFunction itself, larger ones are allocated
+#define INLINE_FUNCTION_SIZE 56
+
+/*
+	A movable void() callable, like std::function<void()>, but which keeps callables of up to INLINE_FUNCTION_SIZE bytes in place
+	So a lambda capturing a handful of pointers and values never causes a heap allocation
+*/
+class InlineFunction {
+	alignas(std::max_align_t) unsigned char storage[INLINE_FUNCTION_SIZE];
+	void(*invoke)(void* storage) = nullptr;
+	// moves the callable in from to to, or destroys it if to is nullptr
+	void(*manage)(void* from, void* to) = nullptr;
+
+	template<typename Func>
+	static constexpr bool fitsInline() {
+		return sizeof(Func) <= INLINE_FUNCTION_SIZE && alignof(Func) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<Func>::value;
+	}
+
+	void moveFrom(InlineFunction& other) noexcept {
+		invoke = other.invoke;
+		manage = other.manage;
+		if(manage != nullptr) {
+			manage(other.storage, storage);
+			other.manage(other.storage, nullptr);
+			other.invoke = nullptr;
+			other.manage = nullptr;
+		}
+	}
+
+public:
+	InlineFunction() = default;
+
+	template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, InlineFunction>::value>>
+	InlineFunction(F&& function) {
+		using Func = std::decay_t<F>;
+		if constexpr(fitsInline<Func>()) {
+			new(storage) Func(std::forward<F>(function));
+			invoke = [](void* storage) {
+				(*static_cast<Func*>(storage))();
+			};
+			manage = [](void* from, void* to) {
+				Func* fromFunc = static_cast<Func*>(from);
+				if(to != nullptr) {
+					new(to) Func(std::move(*fromFunc));
+				} else {
+					fromFunc->~Func();
+				}
+			};
+		} else {
+			new(storage) Func*(new Func(std::forward<F>(function)));
+			invoke = [](void* storage) {
+				(**static_cast<Func**>(storage))();
+			};
+			manage = [](void* from, void* to) {
+				Func* fromFunc = *static_cast<Func**>(from);
+				if(to != nullptr) {
+					new(to) Func*(fromFunc);
+					*static_cast<Func**>(from) = nullptr;
+				} else {
+					delete fromFunc;
+				}
+			};
+		}
+	}
+
+	InlineFunction(InlineFunction&& other) noexcept {
+		moveFrom(other);
+	}
+	InlineFunction& operator=(InlineFunction&& other) noexcept {
+		if(this != &other) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+	InlineFunction(const InlineFunction&) = delete;
+	InlineFunction& operator=(const InlineFunction&) = delete;
+
+	~InlineFunction() {
+		reset();
+	}
+
+	void reset() {
+		if(manage != nullptr) {
+			manage(storage, nullptr);
+			invoke = nullptr;
+			manage = nullptr;
+		}
+	}
+
+	inline explicit operator bool() const { return invoke != nullptr; }
+
+	inline void operator()() {
+		invoke(storage);
+	}
+};
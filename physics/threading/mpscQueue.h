@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+	A queue that any number of threads can push to at the same time, and a single thread consumes
+
+	Items are kept in a ring of capacity slots, every slot has a sequence number that tells producers and the consumer whose turn it is
+	Producers claim a slot with a compare exchange and never wait for the consumer or for each other
+	When the ring is full items go to an overflow list behind a mutex instead, so push never fails
+	While there is overflow every producer adds to it, and the consumer empties every slot claimed before it takes the overflow,
+	so items pushed by the same thread are always consumed in the order they were pushed
+*/
+template<typename T>
+class MPSCQueue {
+	struct alignas(64) Slot {
+		std::atomic<size_t> sequence;
+		alignas(T) unsigned char storage[sizeof(T)];
+
+		inline T* get() { return reinterpret_cast<T*>(storage); }
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t capacity;
+	alignas(64) std::atomic<size_t> enqueuePosition{0};
+	alignas(64) size_t dequeuePosition = 0; // only used by the consumer
+
+	std::mutex overflowMutex;
+	std::atomic<bool> overflowing{false};
+	std::vector<T> overflow;
+	std::vector<T> overflowBeingConsumed; // only used by the consumer
+
+	bool tryPushToRing(T& item) {
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		while(true) {
+			Slot& slot = slots[position & (capacity - 1)];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if(difference == 0) {
+				if(enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					new(slot.get()) T(std::move(item));
+					slot.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			} else if(difference < 0) {
+				return false; // the consumer hasn't freed this slot yet, the ring is full
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/*
+		Returns false if the next slot is empty, or claimed by a producer that hasn't finished writing it
+	*/
+	template<typename Func>
+	bool consumeOneFromRing(Func& func) {
+		Slot& slot = slots[dequeuePosition & (capacity - 1)];
+		if(slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) return false;
+		T* item = slot.get();
+		func(*item);
+		item->~T();
+		slot.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+		dequeuePosition++;
+		return true;
+	}
+
+public:
+	/*
+		capacity must be a power of two
+	*/
+	MPSCQueue(size_t capacity) : slots(new Slot[capacity]), capacity(capacity) {
+		for(size_t i = 0; i < capacity; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+	~MPSCQueue() {
+		auto discard = [](T&) {};
+		while(consumeOneFromRing(discard)) {}
+	}
+
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue(MPSCQueue&&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(MPSCQueue&&) = delete;
+
+	void push(T&& item) {
+		if(!overflowing.load(std::memory_order_acquire) && tryPushToRing(item)) return;
+
+		std::lock_guard<std::mutex> lock(overflowMutex);
+		overflowing.store(true, std::memory_order_release);
+		overflow.push_back(std::move(item));
+	}
+
+	/*
+		Calls func on every item pushed before consumeAll was called, and removes them
+		Items pushed while consuming, for example by func itself, may be left for the next call
+		Only one thread may consume at a time
+	*/
+	template<typename Func>
+	void consumeAll(Func&& func) {
+		size_t end = enqueuePosition.load(std::memory_order_acquire);
+		while(dequeuePosition != end && consumeOneFromRing(func)) {}
+
+		if(overflowing.load(std::memory_order_acquire)) {
+			size_t ringEnd;
+			{
+				std::lock_guard<std::mutex> lock(overflowMutex);
+				overflowBeingConsumed.swap(overflow);
+				overflowing.store(false, std::memory_order_release);
+				// every slot claimed before these overflow items were pushed lies below ringEnd
+				ringEnd = enqueuePosition.load(std::memory_order_acquire);
+			}
+			// those slots must be consumed first, a producer that claimed one but hasn't written it yet is waited for
+			while(dequeuePosition != ringEnd) {
+				if(!consumeOneFromRing(func)) std::this_thread::yield();
+			}
+			for(T& item : overflowBeingConsumed) {
+				func(item);
+			}
+			overflowBeingConsumed.clear();
+		}
+	}
+};
@@ -0,0 +1,133 @@
+#include "threadPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+ThreadPool::ThreadPool(size_t threadCount) : 
+	threadCount(std::max<size_t>(threadCount, 1)), 
+	queues(new WorkerQueue[std::max<size_t>(threadCount, 1)]) {
+
+	threads.reserve(this->threadCount - 1);
+	for(size_t i = 1; i < this->threadCount; i++) {
+		threads.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		stopping = true;
+	}
+	wakeCondition.notify_all();
+	for(std::thread& t : threads) {
+		t.join();
+	}
+}
+
+void ThreadPool::workerLoop(size_t workerIndex) {
+	size_t seenGeneration = 0;
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock(poolMutex);
+			wakeCondition.wait(lock, [&]() {return stopping || generation != seenGeneration; });
+			if(stopping) return;
+			seenGeneration = generation;
+			// woke up after the batch was already finished
+			if(currentTaskFunc == nullptr) continue;
+			activeWorkers++;
+		}
+
+		workOn(workerIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(poolMutex);
+			activeWorkers--;
+		}
+		doneCondition.notify_one();
+	}
+}
+
+void ThreadPool::workOn(size_t workerIndex) {
+	size_t task;
+	while(takeTask(workerIndex, task) || stealTasks(workerIndex, task)) {
+		currentTaskFunc(currentContext, task, workerIndex);
+		remainingTasks.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+bool ThreadPool::takeTask(size_t workerIndex, size_t& task) {
+	WorkerQueue& queue = queues[workerIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if(queue.begin == queue.end) return false;
+	task = queue.begin++;
+	return true;
+}
+
+bool ThreadPool::stealTasks(size_t workerIndex, size_t& task) {
+	for(size_t offset = 1; offset < threadCount; offset++) {
+		WorkerQueue& victim = queues[(workerIndex + offset) % threadCount];
+		size_t stolenBegin;
+		size_t stolenEnd;
+		{
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			size_t available = victim.end - victim.begin;
+			if(available == 0) continue;
+			stolenBegin = victim.begin + available / 2;
+			stolenEnd = victim.end;
+			victim.end = stolenBegin;
+		}
+		// only the owner adds to its own queue, and it is empty at this point
+		WorkerQueue& ownQueue = queues[workerIndex];
+		{
+			std::lock_guard<std::mutex> lock(ownQueue.mutex);
+			ownQueue.begin = stolenBegin + 1;
+			ownQueue.end = stolenEnd;
+		}
+		task = stolenBegin;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::runTasks(size_t taskCount, void(*taskFunc)(void*, size_t, size_t), void* context) {
+	if(taskCount == 0) return;
+	if(threadCount == 1 || taskCount == 1) {
+		for(size_t i = 0; i < taskCount; i++) {
+			taskFunc(context, i, 0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(poolMutex);
+		assert(currentTaskFunc == nullptr);
+
+		size_t blockSize = taskCount / threadCount;
+		size_t leftOver = taskCount % threadCount;
+		size_t curTask = 0;
+		for(size_t i = 0; i < threadCount; i++) {
+			size_t thisBlock = blockSize + (i < leftOver ? 1 : 0);
+			std::lock_guard<std::mutex> queueLock(queues[i].mutex);
+			queues[i].begin = curTask;
+			queues[i].end = curTask + thisBlock;
+			curTask += thisBlock;
+		}
+
+		currentTaskFunc = taskFunc;
+		currentContext = context;
+		remainingTasks.store(taskCount, std::memory_order_relaxed);
+		generation++;
+	}
+	wakeCondition.notify_all();
+
+	workOn(0);
+
+	while(remainingTasks.load(std::memory_order_acquire) != 0) {
+		std::this_thread::yield();
+	}
+
+	std::unique_lock<std::mutex> lock(poolMutex);
+	currentTaskFunc = nullptr;
+	currentContext = nullptr;
+	doneCondition.wait(lock, [this]() {return activeWorkers == 0; });
+}
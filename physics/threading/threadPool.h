@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+	A fixed set of worker threads that run batches of indexed tasks
+
+	Every batch is dealt out in contiguous blocks, one block per worker
+	Workers take tasks from the front of their own block, and once that is empty steal half of what remains at the back of another worker's block
+	The thread that starts a batch takes part as worker 0, so a pool of n threads only starts n-1 threads of its own
+
+	Only one batch can run at a time, tasks may not start batches of their own
+*/
+class ThreadPool {
+	struct alignas(64) WorkerQueue {
+		std::mutex mutex;
+		size_t begin = 0;
+		size_t end = 0;
+	};
+
+	size_t threadCount;
+	std::unique_ptr<WorkerQueue[]> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex poolMutex;
+	std::condition_variable wakeCondition;
+	std::condition_variable doneCondition;
+	size_t generation = 0;
+	size_t activeWorkers = 0;
+	bool stopping = false;
+
+	void(*currentTaskFunc)(void*, size_t, size_t) = nullptr;
+	void* currentContext = nullptr;
+	std::atomic<size_t> remainingTasks{0};
+
+	void workerLoop(size_t workerIndex);
+	void workOn(size_t workerIndex);
+	bool takeTask(size_t workerIndex, size_t& task);
+	bool stealTasks(size_t workerIndex, size_t& task);
+
+	void runTasks(size_t taskCount, void(*taskFunc)(void*, size_t, size_t), void* context);
+
+public:
+	ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	/*
+		The number of workers, including the thread calling parallelFor
+	*/
+	inline size_t getThreadCount() const { return threadCount; }
+
+	/*
+		Runs func(taskIndex, workerIndex) for every taskIndex in [0, taskCount), returns once all of them are done
+		workerIndex is in [0, getThreadCount()), and can be used to index per-worker buffers without locking
+	*/
+	template<typename Func>
+	void parallelFor(size_t taskCount, Func&& func) {
+		using FuncType = std::remove_reference_t<Func>;
+		runTasks(taskCount, [](void* context, size_t taskIndex, size_t workerIndex) {
+			(*static_cast<FuncType*>(context))(taskIndex, workerIndex);
+		}, static_cast<void*>(&func));
+	}
+};
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include "../util/log.h"
+#include "misc/filters/intersectsBoundsFilter.h"
 
 #ifndef NDEBUG
 #define ASSERT_VALID if (!isValid()) throw "World not valid!";
@@ -140,6 +141,7 @@ void WorldPrototype::addPart(Part* part) {
 	
 	objectTree.add(createNodeFor(part->parent->mainPhysical));
 	physicals.push_back(part->parent->mainPhysical);
+	invalidateBoundsPairs();
 
 	objectCount += part->parent->mainPhysical->getNumberOfPartsInThisAndChildren();
 	
@@ -151,15 +153,48 @@ void WorldPrototype::addPart(Part* part) {
 		this->onPartAdded(&part);
 	});
 }
+void WorldPrototype::addParts(const std::vector<Part*>& parts) {
+	ASSERT_VALID;
+	std::vector<TreeNode> newNodes;
+	newNodes.reserve(parts.size());
+	std::vector<MotorizedPhysical*> newPhysicals;
+	for(Part* part : parts) {
+		part->ensureHasParent();
+		MotorizedPhysical* phys = part->parent->mainPhysical;
+		if(phys->world == this) {
+			Log::warn("Attempting to readd part to world");
+			continue;
+		}
+		newNodes.push_back(createNodeFor(phys));
+		physicals.push_back(phys);
+		newPhysicals.push_back(phys);
+		objectCount += phys->getNumberOfPartsInThisAndChildren();
+		phys->world = this;
+	}
+	objectTree.buildFromNodes(std::move(newNodes), threadPool);
+	invalidateBoundsPairs();
+
+	ASSERT_VALID;
+
+	for(MotorizedPhysical* phys : newPhysicals) {
+		phys->forEachPart([this](Part& part) {
+			this->onPartAdded(&part);
+		});
+	}
+}
 void WorldPrototype::removePart(Part* part) {
 	ASSERT_VALID;
+	invalidateBoundsPairs();
+	Bounds oldBounds = part->getBounds();
 	
 	if(part->parent == nullptr) {
 		this->terrainTree.remove(part);
+		this->colissionPairCache.removePart(part);
 		this->onPartRemoved(part);
 	} else {
 		part->parent->removePart(part);
 	}
+	wakeUpPhysicalsNear(oldBounds);
 
 	ASSERT_VALID;
 }
@@ -179,6 +214,8 @@ void WorldPrototype::clear() {
 	this->objectCount = 0;
 	this->objectTree.clear();
 	this->terrainTree.clear();
+	this->colissionPairCache.clear();
+	invalidateBoundsPairs();
 	for(Part* p : partsToDelete) {
 		this->onPartRemoved(p);
 	}
@@ -186,6 +223,7 @@ void WorldPrototype::clear() {
 
 void WorldPrototype::notifyMainPhysicalObsolete(MotorizedPhysical* motorPhys) {
 	physicals.erase(std::remove(physicals.begin(), physicals.end(), motorPhys));
+	invalidateBoundsPairs();
 
 	ASSERT_VALID;
 }
@@ -194,25 +232,95 @@ void WorldPrototype::addTerrainPart(Part* part) {
 
 	terrainTree.add(part, part->getBounds());
 	part->isTerrainPart = true;
+	invalidateBoundsPairs();
 
 	ASSERT_VALID;
 
 	this->onPartAdded(part);
 }
-void WorldPrototype::optimizeTerrain() {
-	for(int i = 0; i < 5; i++) {
-		terrainTree.improveStructure();
+void WorldPrototype::addTerrainParts(const std::vector<Part*>& parts) {
+	ASSERT_VALID;
+	std::vector<std::pair<Part*, Bounds>> partsAndBounds;
+	partsAndBounds.reserve(parts.size());
+	for(Part* part : parts) {
+		partsAndBounds.emplace_back(part, part->getBounds());
+		part->isTerrainPart = true;
+	}
+	objectCount += parts.size();
+	terrainTree.buildFrom(partsAndBounds, threadPool);
+	invalidateBoundsPairs();
+
+	ASSERT_VALID;
+
+	for(Part* part : parts) {
+		this->onPartAdded(part);
 	}
+}
+void WorldPrototype::optimizeTerrain() {
+	terrainTree.rebuild(threadPool);
+	ASSERT_VALID;
+}
+void WorldPrototype::setTerrainPartCFrame(Part* part, const GlobalCFrame& newCFrame) {
+	assert(part->isTerrainPart);
+	Bounds oldBounds = part->getBounds();
+	part->setCFrame(newCFrame);
+	terrainTree.updateObjectBounds(part, oldBounds);
+	invalidateBoundsPairs();
+
+	// sleeping physicals aren't tested against terrain, so both those it left and those it moved into must wake up
+	wakeUpPhysicalsNear(oldBounds);
+	wakeUpPhysicalsNear(part->getBounds());
 	ASSERT_VALID;
 }
 
+void WorldPrototype::wakeUpPhysicalsNear(const Bounds& bounds) {
+	std::vector<Bounds> boundsToCheck{bounds};
+	std::vector<MotorizedPhysical*> wokenPhysicals;
+	while(!boundsToCheck.empty()) {
+		IntersectsBoundsFilter filter(boundsToCheck.back());
+		boundsToCheck.pop_back();
+		for(Part& part : objectTree.iterFiltered(filter)) {
+			MotorizedPhysical* physical = part.parent->mainPhysical;
+			if(physical->isAsleep() && filter(part)) {
+				physical->wakeUp();
+				wokenPhysicals.push_back(physical);
+			}
+		}
+		for(MotorizedPhysical* physical : wokenPhysicals) {
+			physical->forEachPart([&boundsToCheck](const Part& part) {
+				boundsToCheck.push_back(part.getBounds());
+			});
+		}
+		wokenPhysicals.clear();
+	}
+}
+
+void WorldPrototype::markPartMoved(Part* part) {
+	if(!incrementalBroadphase || !boundsPairsValid) return;
+	if(movedPartIndices.emplace(part, movedParts.size()).second) {
+		movedParts.push_back(part);
+	}
+}
+
+void WorldPrototype::invalidateBoundsPairs() {
+	boundsPairsValid = false;
+	objectBoundsPairs.clear();
+	terrainBoundsPairs.clear();
+	movedParts.clear();
+	movedPartIndices.clear();
+}
+
 void WorldPrototype::notifyPartBoundsUpdated(const Part* updatedPart, const Bounds& oldBounds) {
 	objectTree.updateObjectBounds(updatedPart, oldBounds);
+	markPartMoved(const_cast<Part*>(updatedPart));
 	ASSERT_VALID;
 }
 
 void WorldPrototype::notifyPartGroupBoundsUpdated(const Part* mainPart, const Bounds& oldMainPartBounds) {
 	objectTree.updateObjectGroupBounds(mainPart, oldMainPartBounds);
+	mainPart->parent->mainPhysical->forEachPart([this](Part& part) {
+		this->markPartMoved(&part);
+	});
 	ASSERT_VALID;
 }
 
@@ -226,6 +334,7 @@ void WorldPrototype::notifyPhysicalHasBeenSplit(const MotorizedPhysical* mainPhy
 	assert(mainPhysical->world == this);
 	assert(newlySplitPhysical->world == nullptr);
 	this->notifyNewPhysicalCreatedWhenSplitting(newlySplitPhysical);
+	invalidateBoundsPairs();
 	
 	ASSERT_TREE_VALID(objectTree);
 
@@ -272,6 +381,7 @@ static void removePhysicalFromList(std::vector<MotorizedPhysical*>& physicals, M
 
 void WorldPrototype::mergePhysicalGroups(const MotorizedPhysical* firstPhysical, MotorizedPhysical* secondPhysical) {
 	assert(firstPhysical->world == this);
+	invalidateBoundsPairs();
 
 	TreeNode newNode;
 
@@ -303,6 +413,7 @@ void WorldPrototype::notifyNewPartAddedToPhysical(const MotorizedPhysical* physi
 
 	this->objectTree.addToExistingGroup(newPart, newPart->getBounds(), physical->getMainPart(), physical->getMainPart()->getBounds());
 	objectCount++;
+	invalidateBoundsPairs();
 	ASSERT_TREE_VALID(objectTree);
 
 	onPartAdded(newPart);
@@ -310,6 +421,8 @@ void WorldPrototype::notifyNewPartAddedToPhysical(const MotorizedPhysical* physi
 
 void WorldPrototype::notifyPartStdMoved(Part* oldPartPtr, Part* newPartPtr) {
 	(*getTreeForPart(oldPartPtr).find(oldPartPtr, newPartPtr->getBounds()))->object = newPartPtr;
+	invalidateBoundsPairs();
+	colissionPairCache.removePart(oldPartPtr);
 	ASSERT_TREE_VALID(objectTree);
 }
 
@@ -320,6 +433,7 @@ void WorldPrototype::notifyPartDetachedFromPhysical(Part* part) {
 	assert(part->parent->isMainPhysical());
 
 	objectTree.moveOutOfGroup(part);
+	invalidateBoundsPairs();
 	ASSERT_TREE_VALID(objectTree);
 }
 
@@ -328,6 +442,8 @@ void WorldPrototype::notifyPartRemovedFromPhysical(Part* part) {
 
 	objectTree.remove(part);
 	objectCount--;
+	invalidateBoundsPairs();
+	colissionPairCache.removePart(part);
 	ASSERT_TREE_VALID(objectTree);
 
 	this->onPartRemoved(part);
@@ -345,6 +461,12 @@ void WorldPrototype::removeExternalForce(ExternalForce* force) {
 	externalForces.erase(std::remove(externalForces.begin(), externalForces.end(), force));
 }
 
+void ExternalForce::apply(WorldPrototype* world) {
+	ForceBuffer forces;
+	applyToPhysicals(world, world->physicals.data(), world->physicals.data() + world->physicals.size(), forces);
+	forces.applyCommands(0, forces.size());
+}
+
 IteratorFactoryWithEnd<WorldPartIter> WorldPrototype::iterParts(int partsMask) {
 	size_t size = 0;
 	IteratorFactoryWithEnd<BoundsTreeIter<TreeIterator, Part>> iters[2]{};
@@ -1,14 +1,20 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
 
 #include "part.h"
 #include "physical.h"
 #include "constraintGroup.h"
+#include "colissionIslands.h"
+#include "colissionPairCache.h"
+#include "dynamicsStore.h"
+#include "forceBuffer.h"
 #include "datastructures/iterators.h"
 #include "datastructures/iteratorEnd.h"
 #include "datastructures/boundsTree.h"
 #include "math/linalg/largeMatrix.h"
+#include "physicsProfiler.h"
 
 #define FREE_PARTS 0x1
 #define TERRAIN_PARTS 0x2
@@ -19,10 +25,36 @@ struct Colission {
 	Part* p2;
 	Position intersection;
 	Vec3 exitVector;
+	// see PartIntersection
+	int contactCount;
+	Contact contacts[CONTACT_MANIFOLD_MAX_POINTS];
+};
+
+struct ColissionCandidate {
+	Part* p1;
+	Part* p2;
+};
+
+/*
+	A piece of the broadphase that can run on its own, either all pairs within first, or all pairs between first and second
+	The candidates it finds are candidatesBegin..candidatesEnd in the buffer of the worker that ran it
+*/
+struct BroadphaseTask {
+	TreeNode* first;
+	TreeNode* second; // nullptr for pairs within first
+	size_t worker;
+	size_t candidatesBegin;
+	size_t candidatesEnd;
+};
+
+struct BroadphaseWorkerBuffer {
+	std::vector<ColissionCandidate> candidates;
+	IntersectionTally tally;
 };
 
 class ExternalForce;
 class Layer;
+class ThreadPool;
 
 template<typename Filter>
 using DoubleFilterIter = FilteredIterator<IteratorGroup<TreeIterFactory<Part, Filter>, 2>, IteratorEnd, Filter>;
@@ -43,6 +75,48 @@ private:
 	std::vector<Colission> currentObjectColissions;
 	std::vector<Colission> currentTerrainColissions;
 
+	/*
+		Pairs of parts that passed the broadphase, to be tested by the narrowphase
+	*/
+	std::vector<ColissionCandidate> objectColissionCandidates;
+	std::vector<ColissionCandidate> terrainColissionCandidates;
+
+	/*
+		State of the incremental broadphase, see incrementalBroadphase
+		boundsPairs are the pairs of parts of which the bounds overlapped at the last broadphase, 
+		movedParts are the parts of which the bounds changed since then
+	*/
+	std::vector<ColissionCandidate> objectBoundsPairs;
+	std::vector<ColissionCandidate> terrainBoundsPairs;
+	std::vector<Part*> movedParts;
+	std::unordered_map<const Part*, size_t> movedPartIndices;
+	bool boundsPairsValid = false;
+
+	/*
+		Scratch space for integrating free physicals, see useDynamicsStore
+	*/
+	DynamicsStore dynamicsStore;
+	std::vector<MotorizedPhysical*> hierarchicalPhysicals;
+
+	/*
+		Forces recorded by tasks running in parallel, applied by applyDeferredForces
+	*/
+	DeferredForces deferredForces;
+
+	/*
+		GJK search directions of the pairs tested last tick, used to warm start the narrowphase, and their contact manifolds
+	*/
+	ColissionPairCache colissionPairCache;
+
+	// scratch space of the parallel colission detection, reused between ticks
+	std::vector<BroadphaseTask> objectBroadphaseTasks;
+	std::vector<BroadphaseTask> terrainBroadphaseTasks;
+	std::vector<BroadphaseWorkerBuffer> broadphaseWorkerBuffers;
+	std::vector<PartIntersection> narrowphaseResults;
+	std::vector<NarrowphaseIterationTally> narrowphaseWorkerTallies;
+	std::vector<ColissionPairCache::CachedPair*> narrowphasePairs;
+	ColissionIslands colissionIslands;
+
 	/*
 		Called when then bounds of a part are updated
 	*/
@@ -98,6 +172,16 @@ private:
 private: // actually private fields and methods, not to be used by any friends
 	void mergePhysicalGroups(const MotorizedPhysical* first, MotorizedPhysical* second);
 
+	/*
+		Records that the bounds of part changed, for the incremental broadphase
+	*/
+	void markPartMoved(Part* part);
+	/*
+		Makes the incremental broadphase start over from a full broadphase, 
+		called whenever parts are added, removed, or change groups
+	*/
+	void invalidateBoundsPairs();
+
 	BoundsTree<Part>& getTreeForPart(const Part* part);
 	const BoundsTree<Part>& getTreeForPart(const Part* part) const;
 
@@ -111,9 +195,24 @@ protected:
 	// World tick steps
 	virtual void applyExternalForces();
 	virtual void findColissions();
+	void findColissionCandidates();
+	void findColissionCandidatesParallel();
+	void findColissionCandidatesIncremental();
 	virtual void handleColissions();
+	void handleColissionsParallel();
+	void handleColissionsDeferred();
+	/*
+		Applies the consecutive forces first..last, which all appliesToPhysicalRanges, one range of physicals per task
+	*/
+	void applyPhysicalRangeForces(ExternalForce* const* first, ExternalForce* const* last);
+	/*
+		Applies the forces recorded in deferredForces, in the order of the tasks that recorded them
+	*/
+	void applyDeferredForces();
 	virtual void handleConstraints();
 	virtual void update();
+	void updatePhysical(MotorizedPhysical& physical);
+	void updateWithDynamicsStore();
 
 
 	// event handlers
@@ -132,6 +231,59 @@ public:
 	size_t objectCount = 0;
 	double deltaT;
 
+	/*
+		When set, colission detection, colission handling and updating physicals are spread over the threads of this pool
+		Colissions are handled per island, in the same order as without it for every physical, so ticks stay deterministic
+		The pool is not owned by the world, and may be shared with other worlds that aren't ticked at the same time
+	*/
+	ThreadPool* threadPool = nullptr;
+
+	/*
+		Lets physicals that have come to rest fall asleep, see MotorizedPhysical::updateSleepState
+	*/
+	bool allowSleeping = false;
+
+	/*
+		Keeps the pairs of parts with overlapping bounds between ticks, and only looks for new pairs for the parts that moved
+		This makes the broadphase scale with the number of moving parts instead of the size of the world, best combined with allowSleeping
+		The incremental broadphase always runs on the calling thread, and finds pairs in a different order than the full broadphase
+	*/
+	bool incrementalBroadphase = false;
+
+	/*
+		Stores the bounds of moving parts in objectTree expanded by a margin that grows with their speed, see FAT_BOUNDS_MARGIN
+		The tree is then only refit and restructured when a part moves out of its stored bounds, instead of every tick
+		The broadphase finds some more pairs, which are still rejected before GJK
+	*/
+	bool fattenObjectBounds = false;
+
+	/*
+		Lays out objectTree depth first in memory every OBJECT_TREE_COMPACTION_TICKS ticks, so traversing it walks mostly forward through memory
+		Pays off for large trees that are queried a lot, for 50000 parts a compaction takes about 6ms and speeds up walks through the tree by 10 to 20 percent
+	*/
+	bool compactObjectTree = false;
+
+	/*
+		Integrates physicals without childPhysicals from a structure of arrays copy of their state, DYNAMICS_STORE_LANES at a time
+		Only physicals with childPhysicals, which have hard constraints to update, still go through MotorizedPhysical::update
+		Free physicals then skip refreshPhysicalProperties, changes to their parts' properties must be followed by a call to it
+	*/
+	bool useDynamicsStore = false;
+
+	/*
+		Handles all colissions against the motion physicals had at the start of colission handling, recording their forces and impulses instead of applying them
+		The recorded forces are applied afterwards, in colission order, so results are the same with or without threadPool, and for any number of threads
+		Unlike handling colissions by island, this also spreads a single large pile of colliding physicals over all threads
+		A colission no longer sees the impulses of colissions handled before it in the same tick, so results differ from those without this option
+	*/
+	bool deferColissionForces = false;
+
+	/*
+		Keeps up to CONTACT_MANIFOLD_MAX_POINTS contacts for every colliding pair of parts over consecutive ticks, see ContactManifold
+		Colissions are then handled at every contact, sharing the depth force by depth and the impulses equally, so boxes rest on their faces instead of rocking between corners
+	*/
+	bool persistentContactManifolds = false;
+
 
 	WorldPrototype(double deltaT);
 	~WorldPrototype();
@@ -148,7 +300,24 @@ public:
 	void removePart(Part* part);
 
 	void addTerrainPart(Part* part);
+	/*
+		Adds many parts at once with BoundsTree::buildFrom, which rebuilds the tree they are added to if they are a large part of it
+		Faster than adding them one by one, and results in a better tree
+	*/
+	void addParts(const std::vector<Part*>& parts);
+	void addTerrainParts(const std::vector<Part*>& parts);
+	// rebuilds terrainTree from scratch, call after adding terrain parts one by one
 	void optimizeTerrain();
+	/*
+		Moves a terrain part of this world, Part::setCFrame alone doesn't update terrainTree for terrain parts
+	*/
+	void setTerrainPartCFrame(Part* part, const GlobalCFrame& newCFrame);
+
+	/*
+		Wakes the sleeping physicals with bounds intersecting bounds, and the sleeping physicals those rest on or carry in turn
+		Called when something is removed or moved away from bounds, the physicals resting against it would otherwise stay asleep in mid air
+	*/
+	void wakeUpPhysicalsNear(const Bounds& bounds);
 
 	// removes everything from this world, parts, physicals, forces, constraints
 	void clear();
@@ -157,6 +326,14 @@ public:
 		return objectCount;
 	}
 
+	inline const ColissionPairCache& getColissionPairCache() const {
+		return colissionPairCache;
+	}
+
+	/*
+		The totals are summed on the calling thread, never on threadPool, which may be running a batch of the ticking thread
+		So readers can call these under the shared lock of a SynchronizedWorld
+	*/
 	virtual double getTotalKineticEnergy() const;
 	virtual double getTotalPotentialEnergy() const;
 	virtual double getPotentialEnergyOfPhysical(const MotorizedPhysical& p) const;
@@ -212,9 +389,26 @@ public:
 	IteratorFactoryWithEnd<ConstWorldPartIter> iterParts(int partsMask = ALL_PARTS) const;
 };
 
+/*
+	Forces applied to a sleeping physical wake it up, forces that act on every physical all the time, like gravity, should skip sleeping physicals
+
+	Forces that act on every physical on its own, like gravity, wind or buoyancy, should implement applyToPhysicals and return true from appliesToPhysicalRanges
+	The world then splits its physicals into ranges and applies such forces on all threads of its threadPool
+	Other forces implement apply, which is always called on the thread running the tick
+*/
 class ExternalForce {
 public:
-	virtual void apply(WorldPrototype* world) = 0;
+	/*
+		By default records applyToPhysicals for all physicals of the world, and applies the result
+	*/
+	virtual void apply(WorldPrototype* world);
+	virtual bool appliesToPhysicalRanges() const { return false; }
+	/*
+		Records the forces this force applies to the physicals begin..end, a contiguous range of world->physicals, in forces
+		May be called for several ranges at the same time from different threads, so it should only read the world, and not change anything
+	*/
+	virtual void applyToPhysicals(const WorldPrototype* world, MotorizedPhysical* const* begin, MotorizedPhysical* const* end, ForceBuffer& forces) const {}
+
 	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const Part&) const = 0;
 	virtual double getPotentialEnergyForObject(const WorldPrototype* world, const MotorizedPhysical& phys) const {
 		double total = 0.0;
@@ -223,6 +417,7 @@ public:
 		}
 		return total;
 	}
+	// the totals of the world don't use this, they add up getPotentialEnergyForObject per physical for all forces at once
 	virtual double getTotalPotentialEnergyForThisForce(const WorldPrototype* world) const {
 		double total = 0.0;
 		for (MotorizedPhysical* p : world->iterPhysicals()) {
@@ -14,13 +14,29 @@
 #include "debug.h"
 #include "constants.h"
 #include "physicsProfiler.h"
+#include "threading/threadPool.h"
+#include "datastructures/childBounds.h"
 
 #include <vector>
 
+/*
+	Applies forces to physicals right away, used when colissions are handled one after another
+	Colissions handled with deferColissionForces record them in a ForceBuffer instead
+*/
+struct ImmediateForces {
+	void applyForce(MotorizedPhysical& physical, Vec3Relative origin, Vec3 force) { physical.applyForce(origin, force); }
+	void applyImpulse(MotorizedPhysical& physical, Vec3Relative origin, Vec3Relative impulse) { physical.applyImpulse(origin, impulse); }
+	void wakeUp(MotorizedPhysical& physical) { physical.wakeUp(); }
+};
+
 /*
 	exitVector is the distance p2 must travel so that the shapes are no longer colliding
+	relativeVelocity is the velocity of part1 relative to part2 at collisionPoint, before any contact of the colission was handled
+	depthWeight and impulseWeight are the shares of the depth force and of the impulses this contact takes, when a colission is handled at several contacts
+	contactInertia is the inertia the colission pushes with, that of a single contact at the center of all contacts
 */
-void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exitVector) {
+template<typename Forces>
+void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exitVector, Vec3 relativeVelocity, double depthWeight, double impulseWeight, double contactInertia, Forces& forces) {
 	Debug::logPoint(collisionPoint, Debug::INTERSECTION);
 	Physical& parent1 = *part1.parent;
 	Physical& parent2 = *part2.parent;
@@ -36,24 +52,15 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 	Vec3 collissionRelP1 = collisionPoint - phys1.getCenterOfMass();
 	Vec3 collissionRelP2 = collisionPoint - phys2.getCenterOfMass();
 
-	double inertia1A = phys1.getInertiaOfPointInDirectionRelative(collissionRelP1, exitVector);
-	double inertia2A = phys2.getInertiaOfPointInDirectionRelative(collissionRelP2, exitVector);
-	double combinedInertia = 1 / (1 / inertia1A + 1 / inertia2A);
-
 	// Friction
 	double staticFriction = part1.properties.friction * part2.properties.friction;
 	double dynamicFriction = part1.properties.friction * part2.properties.friction;
 
 	
-	Vec3 depthForce = -exitVector * (COLLISSION_DEPTH_FORCE_MULTIPLIER * combinedInertia);
-
-	phys1.applyForce(collissionRelP1, depthForce);
-	phys2.applyForce(collissionRelP2, -depthForce);
+	Vec3 depthForce = -exitVector * (COLLISSION_DEPTH_FORCE_MULTIPLIER * contactInertia * depthWeight);
 
-	Vec3 part1ToColission = collisionPoint - part1.getPosition();
-	Vec3 part2ToColission = collisionPoint - part2.getPosition();
-
-	Vec3 relativeVelocity = (part1.getMotion().getVelocityOfPoint(part1ToColission) - part1.properties.conveyorEffect) - (part2.getMotion().getVelocityOfPoint(part2ToColission) - part2.properties.conveyorEffect);
+	forces.applyForce(phys1, collissionRelP1, depthForce);
+	forces.applyForce(phys2, collissionRelP2, -depthForce);
 
 	bool isImpulseColission = relativeVelocity * exitVector > 0;
 
@@ -63,11 +70,11 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 
 	if(isImpulseColission) { // moving towards the other object
 		Vec3 desiredAccel = -exitVector * (relativeVelocity * exitVector) / lengthSquared(exitVector) * (1.0 + combinedBouncyness);
-		Vec3 zeroRelVelImpulse = desiredAccel * combinedInertia;
-		impulse = zeroRelVelImpulse;
-		phys1.applyImpulse(collissionRelP1, impulse);
-		phys2.applyImpulse(collissionRelP2, -impulse);
-		relativeVelocity += desiredAccel;
+		Vec3 zeroRelVelImpulse = desiredAccel * contactInertia;
+		impulse = zeroRelVelImpulse * impulseWeight;
+		forces.applyImpulse(phys1, collissionRelP1, impulse);
+		forces.applyImpulse(phys2, collissionRelP2, -impulse);
+		relativeVelocity += desiredAccel * impulseWeight;
 	}
 
 	Vec3 slidingVelocity = exitVector % relativeVelocity % exitVector / lengthSquared(exitVector);
@@ -79,12 +86,12 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 
 	if (isImpulseColission) {
 		Vec3 maxFrictionImpulse = -exitVector % impulse % exitVector / lengthSquared(exitVector) * staticFriction;
-		Vec3 stopFricImpulse = -slidingVelocity * combinedHorizontalInertia;
+		Vec3 stopFricImpulse = -slidingVelocity * (combinedHorizontalInertia * impulseWeight);
 
 		Vec3 fricImpulse = (lengthSquared(stopFricImpulse) < lengthSquared(maxFrictionImpulse)) ? stopFricImpulse : maxFrictionImpulse;
 
-		phys1.applyImpulse(collissionRelP1, fricImpulse);
-		phys2.applyImpulse(collissionRelP2, -fricImpulse);
+		forces.applyImpulse(phys1, collissionRelP1, fricImpulse);
+		forces.applyImpulse(phys2, collissionRelP2, -fricImpulse);
 	}
 
 	double normalForce = length(depthForce);
@@ -98,8 +105,8 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 		double effectFactor = slidingSpeed / (dynamicSaturationSpeed);
 		dynamicFricForce = -slidingVelocity / slidingSpeed * frictionForce * effectFactor;
 	}
-	phys1.applyForce(collissionRelP1, dynamicFricForce);
-	phys2.applyForce(collissionRelP2, -dynamicFricForce);
+	forces.applyForce(phys1, collissionRelP1, dynamicFricForce);
+	forces.applyForce(phys2, collissionRelP2, -dynamicFricForce);
 
 	assert(phys1.isValid());
 	assert(phys2.isValid());
@@ -107,8 +114,12 @@ void handleCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exi
 
 /*
 	exitVector is the distance p2 must travel so that the shapes are no longer colliding
+	relativeVelocity is the velocity of part1 relative to part2 at collisionPoint, before any contact of the colission was handled
+	depthWeight and impulseWeight are the shares of the depth force and of the impulses this contact takes, when a colission is handled at several contacts
+	contactInertia is the inertia the colission pushes with, that of a single contact at the center of all contacts
 */
-void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exitVector) {
+template<typename Forces>
+void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, Vec3 exitVector, Vec3 relativeVelocity, double depthWeight, double impulseWeight, double contactInertia, Forces& forces) {
 	Debug::logPoint(collisionPoint, Debug::INTERSECTION);
 	Physical& parent1 = *part1.parent;
 	MotorizedPhysical& phys1 = *parent1.mainPhysical;
@@ -120,20 +131,14 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 
 	Vec3 collissionRelP1 = collisionPoint - phys1.getCenterOfMass();
 
-	double inertia = phys1.getInertiaOfPointInDirectionRelative(collissionRelP1, exitVector);
-
 	// Friction
 	double staticFriction = part1.properties.friction * part2.properties.friction;
 	double dynamicFriction = part1.properties.friction * part2.properties.friction;
 
 
-	Vec3 depthForce = -exitVector * (COLLISSION_DEPTH_FORCE_MULTIPLIER * inertia);
+	Vec3 depthForce = -exitVector * (COLLISSION_DEPTH_FORCE_MULTIPLIER * contactInertia * depthWeight);
 
-	phys1.applyForce(collissionRelP1, depthForce);
-
-	//Vec3 rigidBodyToPart = part1.getCFrame().getPosition() - parent1.rigidBody.getCenterOfMass();
-	Vec3 partToColission = collisionPoint - part1.getPosition();
-	Vec3 relativeVelocity = part1.getMotion().getVelocityOfPoint(partToColission) - part1.properties.conveyorEffect + part2.getCFrame().localToRelative(part2.properties.conveyorEffect);
+	forces.applyForce(phys1, collissionRelP1, depthForce);
 
 	bool isImpulseColission = relativeVelocity * exitVector > 0;
 
@@ -144,10 +149,10 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 
 	if (isImpulseColission) { // moving towards the other object
 		Vec3 desiredAccel = -exitVector * (relativeVelocity * exitVector) / lengthSquared(exitVector) * (1.0 + combinedBouncyness);
-		Vec3 zeroRelVelImpulse = desiredAccel * inertia;
-		impulse = zeroRelVelImpulse;
-		phys1.applyImpulse(collissionRelP1, impulse);
-		relativeVelocity += desiredAccel;
+		Vec3 zeroRelVelImpulse = desiredAccel * contactInertia;
+		impulse = zeroRelVelImpulse * impulseWeight;
+		forces.applyImpulse(phys1, collissionRelP1, impulse);
+		relativeVelocity += desiredAccel * impulseWeight;
 	}
 
 	Vec3 slidingVelocity = exitVector % relativeVelocity % exitVector / lengthSquared(exitVector);
@@ -157,11 +162,11 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 
 	if (isImpulseColission) {
 		Vec3 maxFrictionImpulse = -exitVector % impulse % exitVector / lengthSquared(exitVector) * staticFriction;
-		Vec3 stopFricImpulse = -slidingVelocity * combinedHorizontalInertia;
+		Vec3 stopFricImpulse = -slidingVelocity * (combinedHorizontalInertia * impulseWeight);
 
 		Vec3 fricImpulse = (lengthSquared(stopFricImpulse) < lengthSquared(maxFrictionImpulse)) ? stopFricImpulse : maxFrictionImpulse;
 
-		phys1.applyImpulse(collissionRelP1, fricImpulse);
+		forces.applyImpulse(phys1, collissionRelP1, fricImpulse);
 	}
 
 	double normalForce = length(depthForce);
@@ -175,17 +180,123 @@ void handleTerrainCollision(Part& part1, Part& part2, Position collisionPoint, V
 		double effectFactor = slidingSpeed / (dynamicSaturationSpeed);
 		dynamicFricForce = -slidingVelocity / slidingSpeed * frictionForce * effectFactor;
 	}
-	phys1.applyForce(collissionRelP1, dynamicFricForce);
+	forces.applyForce(phys1, collissionRelP1, dynamicFricForce);
 
 	assert(phys1.isValid());
 }
 
+/*
+	The shares of the depth force the contacts of c take, in proportion to their depth
+	Contacts that only just touch take none, if none of them is deeper they all take an equal share
+*/
+inline void getDepthWeights(const Colission& c, double* depthWeights) {
+	double totalDepth = 0.0;
+	for (int i = 0; i < c.contactCount; i++) {
+		depthWeights[i] = length(c.contacts[i].exitVector);
+		totalDepth += depthWeights[i];
+	}
+	for (int i = 0; i < c.contactCount; i++) {
+		depthWeights[i] = (totalDepth > 0.0) ? depthWeights[i] / totalDepth : 1.0 / c.contactCount;
+	}
+}
+
+/*
+	The average position of the contacts of c weighted by depthWeights, a single contact standing in for all of them would be here
+*/
+inline Position getCenterOfContacts(const Colission& c, const double* depthWeights) {
+	Vec3 offset(0.0, 0.0, 0.0);
+	for (int i = 1; i < c.contactCount; i++) {
+		offset += Vec3(c.contacts[i].position - c.contacts[0].position) * depthWeights[i];
+	}
+	return c.contacts[0].position + Vec3Fix(offset);
+}
+
+inline Vec3 getRelativeVelocity(const Part& part1, const Part& part2, Position point) {
+	return (part1.getMotion().getVelocityOfPoint(point - part1.getPosition()) - part1.properties.conveyorEffect) - (part2.getMotion().getVelocityOfPoint(point - part2.getPosition()) - part2.properties.conveyorEffect);
+}
+
+inline Vec3 getTerrainRelativeVelocity(const Part& part, const Part& terrain, Position point) {
+	return part.getMotion().getVelocityOfPoint(point - part.getPosition()) - part.properties.conveyorEffect + terrain.getCFrame().localToRelative(terrain.properties.conveyorEffect);
+}
+
+/*
+	Handles every contact of c as a terrain colission of its own, all pushing along the exitVector of c
+	The impulses are shared equally and measured before any of them is applied, so the order of the contacts doesn't set the part spinning
+	With swapParts p2 is handled as the moving part and p1 as terrain
+*/
+template<typename Forces>
+void handleTerrainContacts(const Colission& c, bool swapParts, Forces& forces) {
+	Part& part = swapParts ? *c.p2 : *c.p1;
+	Part& terrain = swapParts ? *c.p1 : *c.p2;
+	MotorizedPhysical& phys = *part.parent->mainPhysical;
+	Vec3 exitVector = swapParts ? -c.exitVector : c.exitVector;
+
+	double depthWeights[CONTACT_MANIFOLD_MAX_POINTS];
+	getDepthWeights(c, depthWeights);
+	double contactInertia = phys.getInertiaOfPointInDirectionRelative(getCenterOfContacts(c, depthWeights) - phys.getCenterOfMass(), exitVector);
+
+	Vec3 relativeVelocities[CONTACT_MANIFOLD_MAX_POINTS];
+	for (int i = 0; i < c.contactCount; i++) {
+		relativeVelocities[i] = getTerrainRelativeVelocity(part, terrain, c.contacts[i].position);
+	}
+
+	double impulseWeight = 1.0 / c.contactCount;
+	for (int i = 0; i < c.contactCount; i++) {
+		handleTerrainCollision(part, terrain, c.contacts[i].position, exitVector, relativeVelocities[i], depthWeights[i], impulseWeight, contactInertia, forces);
+	}
+}
+
+/*
+	A sleeping physical is woken up when something that is still moving hits it
+	When hit by a physical that is coming to rest itself it stays asleep and acts as terrain, so the two don't keep waking each other up
+*/
+template<typename Forces>
+void handleObjectCollision(const Colission& c, Forces& forces) {
+	MotorizedPhysical& phys1 = *c.p1->parent->mainPhysical;
+	MotorizedPhysical& phys2 = *c.p2->parent->mainPhysical;
+
+	if (phys1.isAsleep() != phys2.isAsleep()) {
+		MotorizedPhysical& sleeping = phys1.isAsleep() ? phys1 : phys2;
+		MotorizedPhysical& awake = phys1.isAsleep() ? phys2 : phys1;
+		if (awake.isResting()) {
+			handleTerrainContacts(c, !phys2.isAsleep(), forces);
+			return;
+		}
+		forces.wakeUp(sleeping);
+	}
+	double depthWeights[CONTACT_MANIFOLD_MAX_POINTS];
+	getDepthWeights(c, depthWeights);
+	Position center = getCenterOfContacts(c, depthWeights);
+	double inertia1 = phys1.getInertiaOfPointInDirectionRelative(center - phys1.getCenterOfMass(), c.exitVector);
+	double inertia2 = phys2.getInertiaOfPointInDirectionRelative(center - phys2.getCenterOfMass(), c.exitVector);
+	double contactInertia = 1 / (1 / inertia1 + 1 / inertia2);
+
+	Vec3 relativeVelocities[CONTACT_MANIFOLD_MAX_POINTS];
+	for (int i = 0; i < c.contactCount; i++) {
+		relativeVelocities[i] = getRelativeVelocity(*c.p1, *c.p2, c.contacts[i].position);
+	}
+
+	double impulseWeight = 1.0 / c.contactCount;
+	for (int i = 0; i < c.contactCount; i++) {
+		handleCollision(*c.p1, *c.p2, c.contacts[i].position, c.exitVector, relativeVelocities[i], depthWeights[i], impulseWeight, contactInertia, forces);
+	}
+}
+
 bool boundsSphereEarlyEnd(const DiagonalMat3& scale, const Vec3& sphereCenter, double sphereRadius) {
 	return std::abs(sphereCenter.x) > scale[0] + sphereRadius || std::abs(sphereCenter.y) > scale[1] + sphereRadius || std::abs(sphereCenter.z) > scale[2] + sphereRadius;
 }
 
-inline void runColissionTests(Part& p1, Part& p2, WorldPrototype& world, std::vector<Colission>& colissions) {
-	if (p1.isTerrainPart && p2.isTerrainPart) return; // TODO Unneccecary test?
+inline bool isAtRest(const Part& p) {
+	return p.isTerrainPart || p.parent->mainPhysical->isAsleep();
+}
+
+/*
+	Rejects pairs of parts that are too far apart to intersect, without running GJK
+	Returns true if the pair must still be tested further
+*/
+template<typename Tally>
+inline bool passesEarlyRejectTests(const Part& p1, const Part& p2, Tally& tally) {
+	if (isAtRest(p1) && isAtRest(p2)) return false; // terrain and sleeping physicals can't push each other
 
 	
 	double maxRadiusBetween = p1.maxRadius + p2.maxRadius;
@@ -194,90 +305,386 @@ inline void runColissionTests(Part& p1, Part& p2, WorldPrototype& world, std::ve
 	double distanceSqBetween = lengthSquared(deltaPosition);
 
 	if (distanceSqBetween > maxRadiusBetween * maxRadiusBetween) {
-		intersectionStatistics.addToTally(IntersectionResult::PART_DISTANCE_REJECT, 1);
-		return;
+		tally.addToTally(IntersectionResult::PART_DISTANCE_REJECT, 1);
+		return false;
 	}
 	if (boundsSphereEarlyEnd(p1.hitbox.scale, p1.getCFrame().globalToLocal(p2.getPosition()), p2.maxRadius)) {
-		intersectionStatistics.addToTally(IntersectionResult::PART_BOUNDS_REJECT, 1);
-		return;
+		tally.addToTally(IntersectionResult::PART_BOUNDS_REJECT, 1);
+		return false;
 	}
 	if (boundsSphereEarlyEnd(p2.hitbox.scale, p2.getCFrame().globalToLocal(p1.getPosition()), p1.maxRadius)) {
-		intersectionStatistics.addToTally(IntersectionResult::PART_BOUNDS_REJECT, 1);
+		tally.addToTally(IntersectionResult::PART_BOUNDS_REJECT, 1);
+		return false;
+	}
+	return true;
+}
+
+inline PartIntersection runNarrowphaseTests(Part& p1, Part& p2, Vec3f& searchDirection, SupportHints& supportHints) {
+#ifdef CATCH_INTERSECTION_ERRORS
+	try {
+		return p1.intersects(p2, searchDirection, supportHints);
+	} catch(const std::exception& err) {
+		Log::fatal("Error occurred during intersection: %s", err.what());
+
+		Debug::saveIntersectionError(&p1, &p2, "colError");
+
+		throw err;
+	} catch(...) {
+		Log::fatal("Unknown error occured during intersection");
+
+		Debug::saveIntersectionError(&p1, &p2, "colError");
+
+		throw "exit";
+	}
+#else
+	return p1.intersects(p2, searchDirection, supportHints);
+#endif
+}
+
+/*
+	Adds the contact found by the narrowphase to the manifold of the pair, and gives result all contacts of the manifold instead
+	Pairs of which Part::findContactArea finds the whole contact area use that and don't need a manifold
+*/
+inline void updateContactManifold(const Part& p1, const Part& p2, ContactManifold& manifold, PartIntersection& result) {
+	if (!result.intersects) {
+		manifold.clear();
+		return;
+	}
+	// a contact area that follows from the shapes themselves is better than the contacts gathered over earlier ticks
+	if (p1.findContactArea(p2, result)) {
+		manifold.clear();
 		return;
 	}
+	double sizeOrder = std::min(p1.maxRadius, p2.maxRadius);
+	manifold.update(p1.getCFrame(), p2.getCFrame(), result.intersection, result.exitVector, sizeOrder);
+	result.contactCount = manifold.getContacts(p1.getCFrame(), p2.getCFrame(), result.exitVector, result.contacts);
+}
 
-	PartIntersection result = p1.intersects(p2);
+inline void addColissionIfIntersecting(const ColissionCandidate& candidate, const PartIntersection& result, std::vector<Colission>& colissions) {
 	if (result.intersects) {
 		intersectionStatistics.addToTally(IntersectionResult::COLISSION, 1);
 
-		colissions.push_back(Colission{ &p1, &p2, result.intersection, result.exitVector });
+		Colission colission{ candidate.p1, candidate.p2, result.intersection, result.exitVector, result.contactCount, {} };
+		std::copy(result.contacts, result.contacts + result.contactCount, colission.contacts);
+		colissions.push_back(colission);
 	} else {
 		intersectionStatistics.addToTally(IntersectionResult::GJK_REJECT, 1);
 	}
-	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
 }
 
-void recursiveFindColissionsInternal(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& trunkNode);
-void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& first, TreeNode& second);
-
-void recursiveFindColissionsInternal(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& trunkNode) {
+/*
+	PartPairHandler is called with every pair of parts whose bounds intersect, in a fixed order that only depends on the structure of the trees
+*/
+template<typename PartPairHandler>
+void recursiveFindColissionsInternal(TreeNode& trunkNode, PartPairHandler& handler);
+template<typename PartPairHandler>
+void recursiveFindColissionsBetween(TreeNode& first, TreeNode& second, PartPairHandler& handler);
+template<typename PartPairHandler>
+void recursiveFindColissionsBetweenIntersecting(TreeNode& first, TreeNode& second, PartPairHandler& handler);
+
+template<typename PartPairHandler>
+void recursiveFindColissionsInternal(TreeNode& trunkNode, PartPairHandler& handler) {
 	// within the same node
 	if (trunkNode.isLeafNode() || trunkNode.isGroupHead)
 		return;
 
+	ChildBounds children(trunkNode);
 	for (int i = 0; i < trunkNode.nodeCount; i++) {
 		TreeNode& A = trunkNode[i];
-		recursiveFindColissionsInternal(world, colissions, A);
+		recursiveFindColissionsInternal(A, handler);
+		// only the siblings after A, so every pair is found once
+		unsigned int intersectingSiblings = intersectingChildren(children, A.bounds) & (~0U << (i + 1));
 		for (int j = i + 1; j < trunkNode.nodeCount; j++) {
-			TreeNode& B = trunkNode[j];
-			recursiveFindColissionsBetween(world, colissions, A, B);
+			if (intersectingSiblings & (1U << j)) {
+				recursiveFindColissionsBetweenIntersecting(A, trunkNode[j], handler);
+			}
 		}
 	}
 }
 
-void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& first, TreeNode& second) {
+template<typename PartPairHandler>
+void recursiveFindColissionsBetween(TreeNode& first, TreeNode& second, PartPairHandler& handler) {
 	if (!intersects(first.bounds, second.bounds)) return;
-	
-	if (first.isLeafNode() && second.isLeafNode()) {
-		Part* firstObj = static_cast<Part*>(first.object);
-		Part* secondObj = static_cast<Part*>(second.object);
-#ifdef CATCH_INTERSECTION_ERRORS
-		try {
-			runColissionTests(*firstObj, *secondObj, world, colissions);
-		} catch(const std::exception& err) {
-			Log::fatal("Error occurred during intersection: %s", err.what());
 
-			Debug::saveIntersectionError(firstObj, secondObj, "colError");
-
-			throw err;
-		} catch(...) {
-			Log::fatal("Unknown error occured during intersection");
-
-			Debug::saveIntersectionError(firstObj, secondObj, "colError");
+	recursiveFindColissionsBetweenIntersecting(first, second, handler);
+}
 
-			throw "exit";
-		}
-#else
-		runColissionTests(*firstObj, *secondObj, world, colissions);
-#endif
+/*
+	Same as recursiveFindColissionsBetween, but the bounds of first and second are already known to intersect
+	The children of the split node are tested against the other node all at once
+*/
+template<typename PartPairHandler>
+void recursiveFindColissionsBetweenIntersecting(TreeNode& first, TreeNode& second, PartPairHandler& handler) {
+	if (first.isLeafNode() && second.isLeafNode()) {
+		handler(*static_cast<Part*>(first.object), *static_cast<Part*>(second.object));
 	} else {
 		bool preferFirst = computeCost(first.bounds) <= computeCost(second.bounds);
 		if (preferFirst && !first.isLeafNode() || second.isLeafNode()) {
 			// split first
-
-			for (TreeNode& node : first) {
-				recursiveFindColissionsBetween(world, colissions, node, second);
+			unsigned int intersecting = intersectingChildren(first, second.bounds);
+			for (int i = 0; i < first.nodeCount; i++) {
+				if (intersecting & (1U << i)) {
+					recursiveFindColissionsBetweenIntersecting(first[i], second, handler);
+				}
 			}
 		} else {
 			// split second
+			unsigned int intersecting = intersectingChildren(second, first.bounds);
+			for (int i = 0; i < second.nodeCount; i++) {
+				if (intersecting & (1U << i)) {
+					recursiveFindColissionsBetweenIntersecting(first, second[i], handler);
+				}
+			}
+		}
+	}
+}
+
+#pragma region parallel colission detection
+
+/*
+	The number of levels of the tree that are expanded on the calling thread before the remaining subtrees are handed out as tasks
+	Every level multiplies the number of tasks by about MAX_BRANCHES
+*/
+#define BROADPHASE_TASK_SPLIT_DEPTH 4
+
+/*
+	Mirrors recursiveFindColissionsInternal and recursiveFindColissionsBetween for the top levels of the tree, 
+	but instead of descending further it emits tasks, in the same order the serial recursion would visit them
+*/
+static void splitBroadphaseBetween(TreeNode& first, TreeNode& second, int depthLeft, std::vector<BroadphaseTask>& tasks);
+
+static void splitBroadphaseInternal(TreeNode& trunkNode, int depthLeft, std::vector<BroadphaseTask>& tasks) {
+	if (trunkNode.isLeafNode() || trunkNode.isGroupHead)
+		return;
+
+	if (depthLeft == 0) {
+		tasks.push_back(BroadphaseTask{&trunkNode, nullptr, 0, 0, 0});
+		return;
+	}
+
+	for (int i = 0; i < trunkNode.nodeCount; i++) {
+		TreeNode& A = trunkNode[i];
+		splitBroadphaseInternal(A, depthLeft - 1, tasks);
+		for (int j = i + 1; j < trunkNode.nodeCount; j++) {
+			TreeNode& B = trunkNode[j];
+			splitBroadphaseBetween(A, B, depthLeft - 1, tasks);
+		}
+	}
+}
+
+static void splitBroadphaseBetween(TreeNode& first, TreeNode& second, int depthLeft, std::vector<BroadphaseTask>& tasks) {
+	if (!intersects(first.bounds, second.bounds)) return;
+
+	if (depthLeft == 0 || (first.isLeafNode() && second.isLeafNode())) {
+		tasks.push_back(BroadphaseTask{&first, &second, 0, 0, 0});
+		return;
+	}
+
+	bool preferFirst = computeCost(first.bounds) <= computeCost(second.bounds);
+	if ((preferFirst && !first.isLeafNode()) || second.isLeafNode()) {
+		for (TreeNode& node : first) {
+			splitBroadphaseBetween(node, second, depthLeft - 1, tasks);
+		}
+	} else {
+		for (TreeNode& node : second) {
+			splitBroadphaseBetween(first, node, depthLeft - 1, tasks);
+		}
+	}
+}
+
+template<typename Tally>
+struct ColissionCandidateCollector {
+	std::vector<ColissionCandidate>& candidates;
+	Tally& tally;
+
+	void operator()(Part& p1, Part& p2) {
+		if(passesEarlyRejectTests(p1, p2, tally)) {
+			candidates.push_back(ColissionCandidate{&p1, &p2});
+		}
+	}
+};
+
+static void runBroadphaseTasks(ThreadPool& pool, std::vector<BroadphaseTask>& tasks, std::vector<BroadphaseWorkerBuffer>& workerBuffers) {
+	pool.parallelFor(tasks.size(), [&](size_t taskIndex, size_t workerIndex) {
+		BroadphaseTask& task = tasks[taskIndex];
+		BroadphaseWorkerBuffer& buffer = workerBuffers[workerIndex];
+		ColissionCandidateCollector<IntersectionTally> collector{buffer.candidates, buffer.tally};
+
+		task.worker = workerIndex;
+		task.candidatesBegin = buffer.candidates.size();
+		if(task.second == nullptr) {
+			recursiveFindColissionsInternal(*task.first, collector);
+		} else {
+			recursiveFindColissionsBetween(*task.first, *task.second, collector);
+		}
+		task.candidatesEnd = buffer.candidates.size();
+	});
+}
+
+/*
+	Concatenates the candidates of all tasks in task order, which is the order the serial broadphase would have found them in
+*/
+static void mergeBroadphaseResults(const std::vector<BroadphaseTask>& tasks, const std::vector<BroadphaseWorkerBuffer>& workerBuffers, std::vector<ColissionCandidate>& candidates) {
+	candidates.clear();
+	for(const BroadphaseTask& task : tasks) {
+		const std::vector<ColissionCandidate>& workerCandidates = workerBuffers[task.worker].candidates;
+		candidates.insert(candidates.end(), workerCandidates.begin() + task.candidatesBegin, workerCandidates.begin() + task.candidatesEnd);
+	}
+}
+
+/*
+	The number of candidates each narrowphase task tests, small enough to keep all workers busy when a few pairs need EPA
+*/
+#define NARROWPHASE_TASK_SIZE 16
+
+/*
+	Profiling is turned off while running tasks, the calling thread takes part in running them too
+	GJK and EPA iterations are counted in iterationTally meanwhile, if given
+*/
+class PhysicsProfilingDisabledScope {
+	bool wasEnabled;
+	NarrowphaseIterationTally* previousIterationTally;
+public:
+	PhysicsProfilingDisabledScope(NarrowphaseIterationTally* iterationTally = nullptr) : wasEnabled(profilePhysicsOnThisThread), previousIterationTally(narrowphaseIterationTallyOnThisThread) {
+		profilePhysicsOnThisThread = false;
+		narrowphaseIterationTallyOnThisThread = iterationTally;
+	}
+	~PhysicsProfilingDisabledScope() {
+		profilePhysicsOnThisThread = wasEnabled;
+		narrowphaseIterationTallyOnThisThread = previousIterationTally;
+	}
+};
+
+/*
+	The GJK and EPA iterations of every task are counted in workerTallies[workerIndex], see addNarrowphaseIterations
+*/
+static void runNarrowphaseParallel(ThreadPool& pool, const std::vector<ColissionCandidate>& candidates, ColissionPairCache& pairCache, bool useManifolds, std::vector<ColissionPairCache::CachedPair*>& cachedPairs, std::vector<PartIntersection>& results, std::vector<NarrowphaseIterationTally>& workerTallies, std::vector<Colission>& colissions) {
+	results.resize(candidates.size());
+
+	// the cache can't be modified from multiple threads, look up every pair beforehand, tasks then only write to their own pairs
+	cachedPairs.resize(candidates.size());
+	for(size_t i = 0; i < candidates.size(); i++) {
+		cachedPairs[i] = &pairCache.getPair(candidates[i].p1, candidates[i].p2);
+	}
 
-			for (TreeNode& node : second) {
-				recursiveFindColissionsBetween(world, colissions, first, node);
+	size_t taskCount = (candidates.size() + NARROWPHASE_TASK_SIZE - 1) / NARROWPHASE_TASK_SIZE;
+	pool.parallelFor(taskCount, [&](size_t taskIndex, size_t workerIndex) {
+		PhysicsProfilingDisabledScope profilingDisabled(&workerTallies[workerIndex]);
+
+		size_t begin = taskIndex * NARROWPHASE_TASK_SIZE;
+		size_t end = std::min(begin + NARROWPHASE_TASK_SIZE, candidates.size());
+		for(size_t i = begin; i < end; i++) {
+			results[i] = runNarrowphaseTests(*candidates[i].p1, *candidates[i].p2, cachedPairs[i]->searchDirection, cachedPairs[i]->supportHints);
+			if(useManifolds) updateContactManifold(*candidates[i].p1, *candidates[i].p2, cachedPairs[i]->manifold, results[i]);
+		}
+	});
+
+	// results are kept in candidate order, so colissions come out in the same order as the serial narrowphase
+	for(size_t i = 0; i < candidates.size(); i++) {
+		addColissionIfIntersecting(candidates[i], results[i], colissions);
+	}
+}
+
+static void addIterationTally(HistoricTally<long long, IterationTime>& statistics, const IterationTally& tally) {
+	for(size_t i = 0; i < static_cast<size_t>(IterationTime::COUNT); i++) {
+		statistics.addToTally(static_cast<IterationTime>(i), tally.counts[i]);
+	}
+}
+
+/*
+	Adds the iterations counted by the tasks of runNarrowphaseParallel to the statistics, from the thread running the tick
+*/
+static void addNarrowphaseIterations(const std::vector<NarrowphaseIterationTally>& workerTallies) {
+	for(const NarrowphaseIterationTally& tally : workerTallies) {
+		addIterationTally(GJKCollidesIterationStatistics, tally.gjkCollides);
+		addIterationTally(GJKNoCollidesIterationStatistics, tally.gjkNoCollides);
+		addIterationTally(EPAIterationStatistics, tally.epa);
+	}
+}
+
+/*
+	The number of physicals each task of applyPhysicalRangeForces applies its forces to
+*/
+#define EXTERNAL_FORCE_TASK_SIZE 256
+
+/*
+	The number of colissions each task of handleColissionsDeferred handles
+*/
+#define COLISSION_TASK_SIZE 64
+
+/*
+	The number of physicals each task of the parallel update integrates
+*/
+#define UPDATE_TASK_SIZE 64
+
+#pragma endregion
+
+#pragma region incremental broadphase
+
+struct BoundsPairCollector {
+	std::vector<ColissionCandidate>& pairs;
+
+	void operator()(Part& p1, Part& p2) {
+		pairs.push_back(ColissionCandidate{&p1, &p2});
+	}
+};
+
+template<typename Handler>
+static void recursiveFindOverlappingPartsIntersecting(TreeNode& node, const Bounds& bounds, Handler& handler) {
+	if (node.isLeafNode()) {
+		handler(*static_cast<Part*>(node.object));
+	} else {
+		unsigned int intersecting = intersectingChildren(node, bounds);
+		for (int i = 0; i < node.nodeCount; i++) {
+			if (intersecting & (1U << i)) {
+				recursiveFindOverlappingPartsIntersecting(node[i], bounds, handler);
 			}
 		}
 	}
 }
 
+/*
+	Calls handler with every object in the tree of which the bounds intersect the given bounds
+*/
+template<typename Handler>
+static void recursiveFindOverlappingParts(TreeNode& node, const Bounds& bounds, Handler& handler) {
+	if (!intersects(node.bounds, bounds)) return;
+
+	recursiveFindOverlappingPartsIntersecting(node, bounds, handler);
+}
+
+/*
+	Removes the pairs that contain a moved part, these are found again from the moved parts
+	Pairs of unmoved parts keep their order
+*/
+static void removePairsOfMovedParts(std::vector<ColissionCandidate>& pairs, const std::unordered_map<const Part*, size_t>& movedPartIndices) {
+	pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [&](const ColissionCandidate& pair) {
+		return movedPartIndices.count(pair.p1) != 0 || movedPartIndices.count(pair.p2) != 0;
+	}), pairs.end());
+}
+
+template<typename Tally>
+static void filterCandidates(const std::vector<ColissionCandidate>& pairs, std::vector<ColissionCandidate>& candidates, Tally& tally) {
+	candidates.clear();
+	for (const ColissionCandidate& pair : pairs) {
+		if (passesEarlyRejectTests(*pair.p1, *pair.p2, tally)) {
+			candidates.push_back(pair);
+		}
+	}
+}
+
+#pragma endregion
+
+static void runNarrowphase(const std::vector<ColissionCandidate>& candidates, ColissionPairCache& pairCache, bool useManifolds, std::vector<Colission>& colissions) {
+	for(const ColissionCandidate& candidate : candidates) {
+		ColissionPairCache::CachedPair& cachedPair = pairCache.getPair(candidate.p1, candidate.p2);
+		PartIntersection result = runNarrowphaseTests(*candidate.p1, *candidate.p2, cachedPair.searchDirection, cachedPair.supportHints);
+		if(useManifolds) updateContactManifold(*candidate.p1, *candidate.p2, cachedPair.manifold, result);
+		addColissionIfIntersecting(candidate, result, colissions);
+		physicsMeasure.mark(PhysicsProcess::NARROWPHASE);
+	}
+}
+
 /*
 	===== World Tick =====
 */
@@ -290,6 +697,7 @@ void WorldPrototype::tick() {
 	applyExternalForces();
 
 	handleColissions();
+	applyDeferredForces();
 
 	intersectionStatistics.nextTally();
 	
@@ -298,64 +706,370 @@ void WorldPrototype::tick() {
 	update();
 }
 
+/*
+	Forces that appliesToPhysicalRanges are applied together with the ones directly after them, the others one by one in between
+	Every physical still gets the forces in the order they were added to the world
+*/
 void WorldPrototype::applyExternalForces() {
-	for (ExternalForce* force : externalForces) {
-		force->apply(this);
+	size_t i = 0;
+	while (i < externalForces.size()) {
+		if (!externalForces[i]->appliesToPhysicalRanges()) {
+			externalForces[i]->apply(this);
+			i++;
+			continue;
+		}
+		size_t runEnd = i + 1;
+		while (runEnd < externalForces.size() && externalForces[runEnd]->appliesToPhysicalRanges()) runEnd++;
+		applyPhysicalRangeForces(externalForces.data() + i, externalForces.data() + runEnd);
+		i = runEnd;
 	}
 }
 
+void WorldPrototype::applyPhysicalRangeForces(ExternalForce* const* first, ExternalForce* const* last) {
+	size_t taskCount = (physicals.size() + EXTERNAL_FORCE_TASK_SIZE - 1) / EXTERNAL_FORCE_TASK_SIZE;
+	size_t workerCount = (threadPool != nullptr) ? threadPool->getThreadCount() : 1;
+	size_t firstTask = deferredForces.addTasks(taskCount, workerCount);
+
+	auto applyTask = [&](size_t taskIndex, size_t workerIndex) {
+		ForceBuffer& forces = deferredForces.beginTask(firstTask + taskIndex, workerIndex);
+		MotorizedPhysical* const* begin = physicals.data() + taskIndex * EXTERNAL_FORCE_TASK_SIZE;
+		MotorizedPhysical* const* end = physicals.data() + std::min((taskIndex + 1) * EXTERNAL_FORCE_TASK_SIZE, physicals.size());
+		for (ExternalForce* const* force = first; force != last; ++force) {
+			(*force)->applyToPhysicals(this, begin, end, forces);
+		}
+		deferredForces.endTask(firstTask + taskIndex, workerIndex);
+	};
+
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(taskCount, applyTask);
+	} else {
+		for (size_t taskIndex = 0; taskIndex < taskCount; taskIndex++) {
+			applyTask(taskIndex, 0);
+		}
+	}
+	deferredForces.apply();
+}
+
 void WorldPrototype::findColissions() {
-	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
+	physicsMeasure.mark(PhysicsProcess::BROADPHASE);
+
+	if(incrementalBroadphase) {
+		findColissionCandidatesIncremental();
+	} else if(threadPool == nullptr) {
+		invalidateBoundsPairs();
+		findColissionCandidates();
+	} else {
+		invalidateBoundsPairs();
+		findColissionCandidatesParallel();
+	}
+
+	physicsMeasure.mark(PhysicsProcess::NARROWPHASE);
 
 	currentObjectColissions.clear();
 	currentTerrainColissions.clear();
 
-	recursiveFindColissionsInternal(*this, currentObjectColissions, objectTree.rootNode);
-	recursiveFindColissionsBetween(*this, currentTerrainColissions, objectTree.rootNode, terrainTree.rootNode);
+	if(threadPool == nullptr) {
+		runNarrowphase(objectColissionCandidates, colissionPairCache, persistentContactManifolds, currentObjectColissions);
+		runNarrowphase(terrainColissionCandidates, colissionPairCache, persistentContactManifolds, currentTerrainColissions);
+	} else {
+		narrowphaseWorkerTallies.resize(threadPool->getThreadCount());
+		for(NarrowphaseIterationTally& tally : narrowphaseWorkerTallies) {
+			tally.clear();
+		}
+		runNarrowphaseParallel(*threadPool, objectColissionCandidates, colissionPairCache, persistentContactManifolds, narrowphasePairs, narrowphaseResults, narrowphaseWorkerTallies, currentObjectColissions);
+		runNarrowphaseParallel(*threadPool, terrainColissionCandidates, colissionPairCache, persistentContactManifolds, narrowphasePairs, narrowphaseResults, narrowphaseWorkerTallies, currentTerrainColissions);
+		addNarrowphaseIterations(narrowphaseWorkerTallies);
+	}
+
+	colissionPairCache.removeUnusedPairs();
+}
+
+void WorldPrototype::findColissionCandidates() {
+	objectColissionCandidates.clear();
+	terrainColissionCandidates.clear();
+
+	ColissionCandidateCollector<decltype(intersectionStatistics)> objectCollector{objectColissionCandidates, intersectionStatistics};
+	ColissionCandidateCollector<decltype(intersectionStatistics)> terrainCollector{terrainColissionCandidates, intersectionStatistics};
+	recursiveFindColissionsInternal(objectTree.rootNode, objectCollector);
+	recursiveFindColissionsBetween(objectTree.rootNode, terrainTree.rootNode, terrainCollector);
 }
+
+void WorldPrototype::findColissionCandidatesParallel() {
+	objectBroadphaseTasks.clear();
+	terrainBroadphaseTasks.clear();
+	splitBroadphaseInternal(objectTree.rootNode, BROADPHASE_TASK_SPLIT_DEPTH, objectBroadphaseTasks);
+	splitBroadphaseBetween(objectTree.rootNode, terrainTree.rootNode, BROADPHASE_TASK_SPLIT_DEPTH, terrainBroadphaseTasks);
+
+	broadphaseWorkerBuffers.resize(threadPool->getThreadCount());
+	for(BroadphaseWorkerBuffer& buffer : broadphaseWorkerBuffers) {
+		buffer.candidates.clear();
+		buffer.tally.clear();
+	}
+
+	runBroadphaseTasks(*threadPool, objectBroadphaseTasks, broadphaseWorkerBuffers);
+	runBroadphaseTasks(*threadPool, terrainBroadphaseTasks, broadphaseWorkerBuffers);
+
+	mergeBroadphaseResults(objectBroadphaseTasks, broadphaseWorkerBuffers, objectColissionCandidates);
+	mergeBroadphaseResults(terrainBroadphaseTasks, broadphaseWorkerBuffers, terrainColissionCandidates);
+
+	for(const BroadphaseWorkerBuffer& buffer : broadphaseWorkerBuffers) {
+		for(size_t i = 0; i < static_cast<size_t>(IntersectionResult::COUNT); i++) {
+			intersectionStatistics.addToTally(static_cast<IntersectionResult>(i), buffer.tally.counts[i]);
+		}
+	}
+}
+
+void WorldPrototype::findColissionCandidatesIncremental() {
+	if(!boundsPairsValid) {
+		objectBoundsPairs.clear();
+		terrainBoundsPairs.clear();
+
+		BoundsPairCollector objectCollector{objectBoundsPairs};
+		BoundsPairCollector terrainCollector{terrainBoundsPairs};
+		recursiveFindColissionsInternal(objectTree.rootNode, objectCollector);
+		recursiveFindColissionsBetween(objectTree.rootNode, terrainTree.rootNode, terrainCollector);
+
+		boundsPairsValid = true;
+	} else {
+		removePairsOfMovedParts(objectBoundsPairs, movedPartIndices);
+		removePairsOfMovedParts(terrainBoundsPairs, movedPartIndices);
+
+		for(size_t i = 0; i < movedParts.size(); i++) {
+			Part* movedPart = movedParts[i];
+			// the bounds stored in the tree, these may be fattened
+			Bounds movedBounds = (*objectTree.find(movedPart, movedPart->getBounds()))->bounds;
+
+			auto addObjectPair = [&](Part& other) {
+				if(other.parent->mainPhysical == movedPart->parent->mainPhysical) return;
+				auto otherMoved = movedPartIndices.find(&other);
+				// pairs of two moved parts are added by the first of the two
+				if(otherMoved != movedPartIndices.end() && otherMoved->second < i) return;
+				objectBoundsPairs.push_back(ColissionCandidate{movedPart, &other});
+			};
+			auto addTerrainPair = [&](Part& terrain) {
+				terrainBoundsPairs.push_back(ColissionCandidate{movedPart, &terrain});
+			};
+			if(!objectTree.isEmpty()) recursiveFindOverlappingParts(objectTree.rootNode, movedBounds, addObjectPair);
+			if(!terrainTree.isEmpty()) recursiveFindOverlappingParts(terrainTree.rootNode, movedBounds, addTerrainPair);
+		}
+	}
+	movedParts.clear();
+	movedPartIndices.clear();
+
+	filterCandidates(objectBoundsPairs, objectColissionCandidates, intersectionStatistics);
+	filterCandidates(terrainBoundsPairs, terrainColissionCandidates, intersectionStatistics);
+}
+
 void WorldPrototype::handleColissions() {
 	physicsMeasure.mark(PhysicsProcess::COLISSION_HANDLING);
-	for (Colission c : currentObjectColissions) {
-		handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+	if (deferColissionForces) {
+		handleColissionsDeferred();
+		return;
+	}
+	if (threadPool != nullptr) {
+		handleColissionsParallel();
+		return;
 	}
-	for (Colission c : currentTerrainColissions) {
-		handleTerrainCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+	ImmediateForces forces;
+	for (const Colission& c : currentObjectColissions) {
+		handleObjectCollision(c, forces);
+	}
+	for (const Colission& c : currentTerrainColissions) {
+		handleTerrainContacts(c, false, forces);
+	}
+}
+/*
+	Islands share no physicals, so the forces and impulses applied by the colissions of one island can't race with those of another
+	Every island handles its object colissions before its terrain colissions, just like the serial path does
+*/
+void WorldPrototype::handleColissionsParallel() {
+	colissionIslands.build(currentObjectColissions, currentTerrainColissions);
+
+	threadPool->parallelFor(colissionIslands.size(), [this](size_t island, size_t workerIndex) {
+		ImmediateForces forces;
+		for (const Colission* c : colissionIslands.getObjectColissions(island)) {
+			handleObjectCollision(*c, forces);
+		}
+		for (const Colission* c : colissionIslands.getTerrainColissions(island)) {
+			handleTerrainContacts(*c, false, forces);
+		}
+	});
+}
+/*
+	Every colission only reads the physicals it touches and records its forces in deferredForces, 
+	so the colissions can be handled in any order, on any thread, even when they share physicals
+	The tasks split the object colissions and then the terrain colissions into runs of COLISSION_TASK_SIZE, 
+	applyDeferredForces applies their forces in that same order
+*/
+void WorldPrototype::handleColissionsDeferred() {
+	size_t objectTaskCount = (currentObjectColissions.size() + COLISSION_TASK_SIZE - 1) / COLISSION_TASK_SIZE;
+	size_t terrainTaskCount = (currentTerrainColissions.size() + COLISSION_TASK_SIZE - 1) / COLISSION_TASK_SIZE;
+	size_t workerCount = (threadPool != nullptr) ? threadPool->getThreadCount() : 1;
+	size_t firstTask = deferredForces.addTasks(objectTaskCount + terrainTaskCount, workerCount);
+
+	auto handleTask = [&](size_t taskIndex, size_t workerIndex) {
+		ForceBuffer& forces = deferredForces.beginTask(firstTask + taskIndex, workerIndex);
+		if (taskIndex < objectTaskCount) {
+			size_t begin = taskIndex * COLISSION_TASK_SIZE;
+			size_t end = std::min(begin + COLISSION_TASK_SIZE, currentObjectColissions.size());
+			for (size_t i = begin; i < end; i++) {
+				handleObjectCollision(currentObjectColissions[i], forces);
+			}
+		} else {
+			size_t begin = (taskIndex - objectTaskCount) * COLISSION_TASK_SIZE;
+			size_t end = std::min(begin + COLISSION_TASK_SIZE, currentTerrainColissions.size());
+			for (size_t i = begin; i < end; i++) {
+				const Colission& c = currentTerrainColissions[i];
+				handleTerrainContacts(c, false, forces);
+			}
+		}
+		deferredForces.endTask(firstTask + taskIndex, workerIndex);
+	};
+
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(objectTaskCount + terrainTaskCount, handleTask);
+	} else {
+		for (size_t taskIndex = 0; taskIndex < objectTaskCount + terrainTaskCount; taskIndex++) {
+			handleTask(taskIndex, 0);
+		}
 	}
 }
+void WorldPrototype::applyDeferredForces() {
+	if (deferredForces.isEmpty()) return;
+	deferredForces.apply();
+}
 void WorldPrototype::handleConstraints() {
 	physicsMeasure.mark(PhysicsProcess::CONSTRAINTS);
-	for (const ConstraintGroup& group : constraints) {
+	for (ConstraintGroup& group : constraints) {
 		group.apply();
 	}
 }
+/*
+	The margin the bounds of a part are expanded by when fattenObjectBounds is set, 
+	enough to keep the part inside them for FAT_BOUNDS_TICKS ticks at its current speed
+*/
+static double getFatBoundsMargin(const Part& part, double deltaT) {
+	const MotorizedPhysical& phys = *part.parent->mainPhysical;
+	Motion motion = phys.getMotionOfCenterOfMass();
+	double reach = length(Vec3(part.getPosition() - phys.getCenterOfMass())) + part.maxRadius;
+	double speed = length(motion.getVelocity()) + length(motion.getAngularVelocity()) * reach;
+	return FAT_BOUNDS_MARGIN + speed * deltaT * FAT_BOUNDS_TICKS;
+}
+
+void WorldPrototype::updatePhysical(MotorizedPhysical& physical) {
+	if (physical.isAsleep()) return;
+	physical.update(this->deltaT);
+	if (allowSleeping) physical.updateSleepState();
+}
+void WorldPrototype::updateWithDynamicsStore() {
+	dynamicsStore.clear();
+	hierarchicalPhysicals.clear();
+	for (MotorizedPhysical* physical : iterPhysicals()) {
+		if (physical->isAsleep()) continue;
+		if (physical->childPhysicals.size() == 0) {
+			dynamicsStore.add(physical);
+		} else {
+			hierarchicalPhysicals.push_back(physical);
+		}
+	}
+	dynamicsStore.prepare();
+
+	auto updateStoreRange = [this](size_t begin, size_t end) {
+		dynamicsStore.load(begin, end);
+		dynamicsStore.integrate(begin, end, this->deltaT);
+		dynamicsStore.store(begin, end);
+		if (allowSleeping) {
+			for (size_t i = begin; i < end; i++) {
+				dynamicsStore.physicals[i]->updateSleepState();
+			}
+		}
+	};
+
+	static_assert(UPDATE_TASK_SIZE % DYNAMICS_STORE_LANES == 0, "tasks must cover whole lanes of the dynamics store");
+	size_t storeTaskCount = (dynamicsStore.size() + UPDATE_TASK_SIZE - 1) / UPDATE_TASK_SIZE;
+	size_t hierarchicalTaskCount = (hierarchicalPhysicals.size() + UPDATE_TASK_SIZE - 1) / UPDATE_TASK_SIZE;
+	auto runTask = [this, storeTaskCount, &updateStoreRange](size_t taskIndex, size_t workerIndex) {
+		if (taskIndex < storeTaskCount) {
+			size_t begin = taskIndex * UPDATE_TASK_SIZE;
+			updateStoreRange(begin, std::min(begin + UPDATE_TASK_SIZE, dynamicsStore.size()));
+		} else {
+			size_t begin = (taskIndex - storeTaskCount) * UPDATE_TASK_SIZE;
+			size_t end = std::min(begin + UPDATE_TASK_SIZE, hierarchicalPhysicals.size());
+			for (size_t i = begin; i < end; i++) {
+				updatePhysical(*hierarchicalPhysicals[i]);
+			}
+		}
+	};
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(storeTaskCount + hierarchicalTaskCount, runTask);
+	} else {
+		for (size_t taskIndex = 0; taskIndex < storeTaskCount + hierarchicalTaskCount; taskIndex++) {
+			runTask(taskIndex, 0);
+		}
+	}
+}
 void WorldPrototype::update() {
 	physicsMeasure.mark(PhysicsProcess::UPDATING);
-	for (MotorizedPhysical* physical : iterPhysicals()) {
-		physical->update(this->deltaT);
+	if (useDynamicsStore) {
+		updateWithDynamicsStore();
+	} else if (threadPool != nullptr) {
+		// updating a physical only touches that physical and the parts attached to it
+		size_t taskCount = (physicals.size() + UPDATE_TASK_SIZE - 1) / UPDATE_TASK_SIZE;
+		threadPool->parallelFor(taskCount, [this](size_t taskIndex, size_t workerIndex) {
+			size_t end = std::min((taskIndex + 1) * UPDATE_TASK_SIZE, physicals.size());
+			for (size_t i = taskIndex * UPDATE_TASK_SIZE; i < end; i++) {
+				updatePhysical(*physicals[i]);
+			}
+		});
+	} else {
+		for (MotorizedPhysical* physical : iterPhysicals()) {
+			updatePhysical(*physical);
+		}
 	}
 
 	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_BOUNDS);
-	objectTree.recalculateBounds();
+	auto isGroupAsleep = [](const Part& firstPartOfGroup) {return firstPartOfGroup.parent->mainPhysical->isAsleep(); };
+	auto onPartMoved = [this](Part& movedPart) {this->markPartMoved(&movedPart); };
+	bool treeChanged = true;
+	if (fattenObjectBounds) {
+		treeChanged = objectTree.recalculateFattenedBounds(isGroupAsleep, [this](const Part& part) {return getFatBoundsMargin(part, this->deltaT); }, onPartMoved);
+	} else if (incrementalBroadphase) {
+		objectTree.recalculateBounds(isGroupAsleep, onPartMoved);
+	} else if (allowSleeping) {
+		objectTree.recalculateBounds(isGroupAsleep);
+	} else {
+		objectTree.recalculateBounds();
+	}
 	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_STRUCTURE);
-	objectTree.improveStructure();
+	if (treeChanged) objectTree.improveStructure();
+	if (compactObjectTree && age % OBJECT_TREE_COMPACTION_TICKS == 0) objectTree.compact();
 	age++;
 }
 
 
 
-double WorldPrototype::getTotalKineticEnergy() const {
+/*
+	Sums energyOf over all physicals on the calling thread
+	Never uses the world's thread pool, readers call this under the shared lock while the ticking thread may be running a batch of its own on the pool
+*/
+template<typename EnergyOf>
+static double sumOverPhysicals(const std::vector<MotorizedPhysical*>& physicals, const EnergyOf& energyOf) {
 	double total = 0.0;
-	for(const MotorizedPhysical* p : iterPhysicals()) {
-		total += p->getKineticEnergy();
+	for (const MotorizedPhysical* physical : physicals) {
+		total += energyOf(*physical);
 	}
 	return total;
 }
+
+double WorldPrototype::getTotalKineticEnergy() const {
+	return sumOverPhysicals(physicals, [](const MotorizedPhysical& p) {
+		return p.getKineticEnergy();
+	});
+}
 double WorldPrototype::getTotalPotentialEnergy() const {
-	double total = 0.0;
-	for(ExternalForce* force : externalForces) {
-		total += force->getTotalPotentialEnergyForThisForce(this);
-	}
-	return total;
+	return sumOverPhysicals(physicals, [this](const MotorizedPhysical& p) {
+		return getPotentialEnergyOfPhysical(p);
+	});
 }
 double WorldPrototype::getPotentialEnergyOfPhysical(const MotorizedPhysical& p) const {
 	double total = 0.0;
@@ -365,5 +1079,7 @@ double WorldPrototype::getPotentialEnergyOfPhysical(const MotorizedPhysical& p)
 	return total;
 }
 double WorldPrototype::getTotalEnergy() const {
-	return getTotalKineticEnergy() + getTotalPotentialEnergy();
+	return sumOverPhysicals(physicals, [this](const MotorizedPhysical& p) {
+		return p.getKineticEnergy() + getPotentialEnergyOfPhysical(p);
+	});
 }
@@ -0,0 +1,48 @@
+#include "allocationCounter.h"
+
+#include "../physics/datastructures/alignedPtr.h"
+
+#include <cstdlib>
+#include <new>
+
+static thread_local size_t allocationCount = 0;
+
+size_t getAllocationCount() {
+	return allocationCount + getAlignedAllocationCount();
+}
+
+void* operator new(std::size_t size) {
+	allocationCount++;
+	void* result = std::malloc(size == 0 ? 1 : size);
+	if(result == nullptr) throw std::bad_alloc();
+	return result;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	allocationCount++;
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
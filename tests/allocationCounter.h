@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+	The tests replace the global operator new, so allocations can be counted
+	Returns the number of allocations the calling thread has made so far, including aligned buffers, see alignedPtr.h
+*/
+size_t getAllocationCount();
@@ -15,6 +15,11 @@
 #include "../physics/constraints/motorConstraint.h"
 #include "../physics/constraints/sinusoidalPistonConstraint.h"
 #include "../physics/math/linalg/trigonometry.h"
+#include "../physics/math/mathUtil.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
 
 #define ASSERT(cond) ASSERT_TOLERANT(cond, 0.05)
 
@@ -454,3 +459,43 @@ TEST_CASE(testInternalMotionOfCenterOfMass) {
 
 	ASSERT(motionOfCom == estimatedMotion);
 }
+
+// applies a ConstraintGroup to a chain of randomly moving spheres, returns the largest remaining position or velocity difference between the two sides of a joint
+static double getBallConstraintChainViolation(size_t linkCount) {
+	std::vector<std::unique_ptr<Part>> parts;
+	std::vector<BallConstraint> ballConstraints;
+	ballConstraints.reserve(linkCount);
+	ConstraintGroup group;
+	for (size_t i = 0; i <= linkCount; i++) {
+		parts.emplace_back(new Part(sphereShape(1.0), GlobalCFrame(2.0 * i, 0.0, 0.0), {1.0 + i % 3, 1.0, 1.0}));
+		parts.back()->ensureHasParent();
+		MotorizedPhysical* phys = parts.back()->parent->mainPhysical;
+		phys->motionOfCenterOfMass = Motion(Vec3(fRand(-1.0, 1.0), fRand(-1.0, 1.0), fRand(-1.0, 1.0)), Vec3(fRand(-1.0, 1.0), fRand(-1.0, 1.0), fRand(-1.0, 1.0)));
+		phys->applyForceAtCenterOfMass(Vec3(fRand(-1.0, 1.0), fRand(-1.0, 1.0), fRand(-1.0, 1.0)));
+	}
+	for (size_t i = 0; i < linkCount; i++) {
+		ballConstraints.emplace_back(Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0));
+		group.add(parts[i]->parent, parts[i + 1]->parent, &ballConstraints.back());
+	}
+
+	group.apply();
+
+	double worstViolation = 0.0;
+	for (const PhysicalConstraint& pc : group.constraints) {
+		Position posA = pc.physA->getCFrame().localToGlobal(pc.constraint->attachA);
+		Position posB = pc.physB->getCFrame().localToGlobal(pc.constraint->attachB);
+		Vec3 va = pc.physA->getMotionOfCenterOfMass().getVelocityOfPoint(pc.physA->getCFrame().localToRelative(pc.constraint->attachA));
+		Vec3 vb = pc.physB->getMotionOfCenterOfMass().getVelocityOfPoint(pc.physB->getCFrame().localToRelative(pc.constraint->attachB));
+		worstViolation = std::max(worstViolation, length(Vec3(posB - posA)));
+		worstViolation = std::max(worstViolation, length(vb - va));
+	}
+	return worstViolation;
+}
+
+TEST_CASE(testBallConstraintChainDense) {
+	ASSERT_TRUE(getBallConstraintChainViolation(4) < 0.0001);
+}
+
+TEST_CASE(testBallConstraintChainSparse) {
+	ASSERT_TRUE(getBallConstraintChainViolation(40) < 0.0001);
+}
@@ -4,12 +4,489 @@
 #include "../physics/misc/toString.h"
 
 #include "../physics/datastructures/boundsTree.h"
+#include "../physics/datastructures/childBounds.h"
+#include "../physics/datastructures/snapshotExchange.h"
+#include "../physics/threading/mpscQueue.h"
+#include "../physics/threading/inlineFunction.h"
+#include "../physics/misc/filters/rayIntersectsBoundsFilter.h"
+#include "../physics/misc/filters/visibilityFilter.h"
+
+#include <vector>
+#include <set>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <array>
+#include <algorithm>
+#include <stdlib.h>
 
 struct BasicBounded {
-	
+	Bounds bounds;
 };
 
+static double randomCoordinate(double range) {
+	return range * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+static Bounds createRandomBounds(double range, double maxSize) {
+	Position min(randomCoordinate(range), randomCoordinate(range), randomCoordinate(range));
+	Vec3Fix size(maxSize * rand() / RAND_MAX, maxSize * rand() / RAND_MAX, maxSize * rand() / RAND_MAX);
+	return Bounds(min, min + size);
+}
+
+// a node with between 2 and MAX_BRANCHES leaf children with random bounds
+static TreeNode createRandomNode() {
+	int nodeCount = 2 + rand() % (MAX_BRANCHES - 1);
+	TreeNode* subTrees = allocateSubTrees();
+	for(int i = 0; i < nodeCount; i++) {
+		subTrees[i] = TreeNode(nullptr, createRandomBounds(10.0, 5.0));
+	}
+	return TreeNode(subTrees, nodeCount);
+}
+
+template<typename Filter>
+static unsigned int filterChildrenOneByOne(const Filter& filter, const TreeNode& node) {
+	return filterChildrenOf(filter, node, choice<0>());
+}
+
 TEST_CASE(testBoundsTree) {
 
 }
 
+TEST_CASE(intersectingChildrenMatchesIntersects) {
+	for(int iter = 0; iter < 1000; iter++) {
+		TreeNode node = createRandomNode();
+		Bounds testBounds = createRandomBounds(10.0, 5.0);
+
+		unsigned int expected = 0;
+		for(int i = 0; i < node.nodeCount; i++) {
+			if(intersects(node[i].bounds, testBounds)) expected |= 1U << i;
+		}
+		ASSERT_STRICT(intersectingChildren(node, testBounds) == expected);
+	}
+}
+
+TEST_CASE(intersectingChildrenIncludesTouchingBounds) {
+	TreeNode* subTrees = allocateSubTrees();
+	subTrees[0] = TreeNode(nullptr, Bounds(Position(0.0, 0.0, 0.0), Position(1.0, 1.0, 1.0)));
+	subTrees[1] = TreeNode(nullptr, Bounds(Position(2.0, 0.0, 0.0), Position(3.0, 1.0, 1.0)));
+	subTrees[2] = TreeNode(nullptr, Bounds(Position(1.0, 1.0, 1.0), Position(2.0, 2.0, 2.0)));
+	TreeNode node(subTrees, 3);
+
+	ASSERT_STRICT(intersectingChildren(node, Bounds(Position(1.0, 0.5, 0.5), Position(1.0, 0.5, 0.5))) == 0b001U);
+	ASSERT_STRICT(intersectingChildren(node, Bounds(Position(1.0, 1.0, 1.0), Position(2.0, 1.0, 1.0))) == 0b111U);
+	ASSERT_STRICT(intersectingChildren(node, Bounds(Position(-2.0, -2.0, -2.0), Position(-1.0, -1.0, -1.0))) == 0U);
+}
+
+TEST_CASE(rayFilterChildrenMatchesSingleNodeFilter) {
+	for(int iter = 0; iter < 1000; iter++) {
+		TreeNode node = createRandomNode();
+		Ray ray{Position(randomCoordinate(15.0), randomCoordinate(15.0), randomCoordinate(15.0)), Vec3(randomCoordinate(1.0), randomCoordinate(1.0), randomCoordinate(1.0))};
+		RayIntersectBoundsFilter filter(ray);
+
+		ASSERT_STRICT(filter.filterChildren(node) == filterChildrenOneByOne(filter, node));
+	}
+}
+
+TEST_CASE(visibilityFilterChildrenMatchesSingleNodeFilter) {
+	for(int iter = 0; iter < 1000; iter++) {
+		TreeNode node = createRandomNode();
+		Position origin(randomCoordinate(15.0), randomCoordinate(15.0), randomCoordinate(15.0));
+		Vec3 forward(randomCoordinate(1.0), randomCoordinate(1.0), randomCoordinate(1.0));
+		Vec3 up = forward % Vec3(randomCoordinate(1.0), randomCoordinate(1.0), randomCoordinate(1.0));
+		VisibilityFilter filter = VisibilityFilter::forWindow(origin, forward, up, 1.2, 1.5, 20.0);
+
+		ASSERT_STRICT(filter.filterChildren(node) == filterChildrenOneByOne(filter, node));
+	}
+}
+
+struct BasicBoundsFilter {
+	Bounds filterBounds;
+
+	bool operator()(const TreeNode& node) const { return intersects(node.bounds, filterBounds); }
+	bool operator()(const BasicBounded& b) const { return true; }
+};
+
+struct BasicBoundsChildFilter : public BasicBoundsFilter {
+	unsigned int filterChildren(const TreeNode& node) const { return intersectingChildren(node, filterBounds); }
+};
+
+TEST_CASE(filteredIterationWithChildMasks) {
+	std::vector<BasicBounded> objects(300);
+	BoundsTree<BasicBounded> tree;
+	for(BasicBounded& obj : objects) {
+		obj.bounds = createRandomBounds(20.0, 3.0);
+		tree.add(&obj, obj.bounds);
+	}
+	tree.improveStructure();
+
+	for(int iter = 0; iter < 50; iter++) {
+		Bounds filterBounds = createRandomBounds(20.0, 8.0);
+
+		std::set<const BasicBounded*> expected;
+		for(const BasicBounded& obj : objects) {
+			if(intersects(obj.bounds, filterBounds)) expected.insert(&obj);
+		}
+
+		std::set<const BasicBounded*> foundOneByOne;
+		for(BasicBounded& obj : tree.iterFiltered(BasicBoundsFilter{filterBounds})) {
+			foundOneByOne.insert(&obj);
+		}
+		std::set<const BasicBounded*> foundWithMasks;
+		for(BasicBounded& obj : tree.iterFiltered(BasicBoundsChildFilter{filterBounds})) {
+			foundWithMasks.insert(&obj);
+		}
+
+		ASSERT_TRUE(foundOneByOne == expected);
+		ASSERT_TRUE(foundWithMasks == expected);
+	}
+}
+
+static void collectSubTreesDepthFirst(const TreeNode& node, std::vector<const TreeNode*>& arrays) {
+	if(node.isLeafNode()) return;
+	arrays.push_back(node.subTrees);
+	for(const TreeNode& subNode : node) {
+		collectSubTreesDepthFirst(subNode, arrays);
+	}
+}
+
+TEST_CASE(compactedTreeIsDepthFirstInMemory) {
+	std::vector<BasicBounded> objects(300);
+	BoundsTree<BasicBounded> tree;
+	for(BasicBounded& obj : objects) {
+		obj.bounds = createRandomBounds(20.0, 3.0);
+		tree.add(&obj, obj.bounds);
+	}
+	tree.improveStructure();
+	// churn the pool so that the arrays are no longer in order
+	for(int i = 0; i < 100; i += 2) {
+		NodeStack(tree.rootNode, &objects[i], objects[i].bounds).remove();
+	}
+	for(int i = 0; i < 100; i += 2) {
+		tree.add(&objects[i], objects[i].bounds);
+	}
+	tree.improveStructure();
+
+	Bounds rootBounds = tree.rootNode.bounds;
+	size_t longestBranch = tree.rootNode.getLengthOfLongestBranch();
+	std::vector<const TreeNode*> arraysBefore;
+	collectSubTreesDepthFirst(tree.rootNode, arraysBefore);
+
+	tree.compact();
+
+	std::vector<const TreeNode*> arrays;
+	collectSubTreesDepthFirst(tree.rootNode, arrays);
+	for(size_t i = 1; i < arrays.size(); i++) {
+		ASSERT_TRUE(arrays[i - 1] < arrays[i]);
+	}
+	// the same arrays, only their contents moved
+	std::sort(arraysBefore.begin(), arraysBefore.end());
+	ASSERT_TRUE(arrays == arraysBefore);
+
+	ASSERT_TRUE(tree.rootNode.bounds == rootBounds);
+	ASSERT_STRICT(tree.rootNode.getLengthOfLongestBranch() == longestBranch);
+	ASSERT_STRICT(tree.getNumberOfObjects() == objects.size());
+	std::set<const BasicBounded*> found;
+	for(TreeIterator iter(tree.rootNode); iter != IteratorEnd(); ++iter) {
+		const TreeNode* leaf = *iter;
+		const BasicBounded* obj = static_cast<const BasicBounded*>(leaf->object);
+		ASSERT_TRUE(leaf->bounds == obj->bounds);
+		found.insert(obj);
+	}
+	ASSERT_STRICT(found.size() == objects.size());
+}
+
+static bool allBoundsContainChildren(const TreeNode& node) {
+	if(node.isLeafNode()) return true;
+	for(const TreeNode& subNode : node) {
+		if(!node.bounds.contains(subNode.bounds)) return false;
+		if(!allBoundsContainChildren(subNode)) return false;
+	}
+	return true;
+}
+
+static long long totalCostOfInternalNodes(const TreeNode& node) {
+	if(node.isLeafNode()) return 0;
+	long long total = computeCost(node.bounds);
+	for(const TreeNode& subNode : node) {
+		total += totalCostOfInternalNodes(subNode);
+	}
+	return total;
+}
+
+TEST_CASE(bulkBuiltTreeMatchesIncrementalTree) {
+	std::vector<BasicBounded> objects(20000);
+	std::vector<std::pair<BasicBounded*, Bounds>> objectsAndBounds;
+	BoundsTree<BasicBounded> incrementalTree;
+	for(BasicBounded& obj : objects) {
+		obj.bounds = createRandomBounds(200.0, 3.0);
+		objectsAndBounds.emplace_back(&obj, obj.bounds);
+		incrementalTree.add(&obj, obj.bounds);
+	}
+	for(int i = 0; i < 5; i++) {
+		incrementalTree.improveStructure();
+	}
+
+	BoundsTree<BasicBounded> bulkTree;
+	bulkTree.buildFrom(objectsAndBounds);
+
+	ASSERT_STRICT(bulkTree.getNumberOfObjects() == objects.size());
+	ASSERT_TRUE(bulkTree.rootNode.getLengthOfLongestBranch() < MAX_HEIGHT);
+	ASSERT_TRUE(allBoundsContainChildren(bulkTree.rootNode));
+
+	logf("incremental cost %lld, bulk cost %lld", totalCostOfInternalNodes(incrementalTree.rootNode), totalCostOfInternalNodes(bulkTree.rootNode));
+	ASSERT_TRUE(totalCostOfInternalNodes(bulkTree.rootNode) < totalCostOfInternalNodes(incrementalTree.rootNode));
+
+	for(int iter = 0; iter < 20; iter++) {
+		Bounds filterBounds = createRandomBounds(200.0, 20.0);
+
+		std::set<const BasicBounded*> expected;
+		for(const BasicBounded& obj : objects) {
+			if(intersects(obj.bounds, filterBounds)) expected.insert(&obj);
+		}
+		std::set<const BasicBounded*> found;
+		for(BasicBounded& obj : bulkTree.iterFiltered(BasicBoundsChildFilter{filterBounds})) {
+			found.insert(&obj);
+		}
+		ASSERT_TRUE(found == expected);
+	}
+}
+
+TEST_CASE(smallBatchIsAddedWithoutRebuildingTree) {
+	std::vector<BasicBounded> objects(1010);
+	std::vector<std::pair<BasicBounded*, Bounds>> firstBatch;
+	std::vector<std::pair<BasicBounded*, Bounds>> secondBatch;
+	for(size_t i = 0; i < objects.size(); i++) {
+		objects[i].bounds = createRandomBounds(100.0, 3.0);
+		(i < 1000 ? firstBatch : secondBatch).emplace_back(&objects[i], objects[i].bounds);
+	}
+
+	BoundsTree<BasicBounded> tree;
+	tree.buildFrom(firstBatch);
+	// a rebuild would move the existing nodes to other arrays
+	const TreeNode* firstChildren = tree.rootNode.subTrees;
+	Bounds firstChildBounds = tree.rootNode[0].bounds;
+	tree.buildFrom(secondBatch);
+
+	ASSERT_TRUE(tree.rootNode.subTrees == firstChildren);
+	ASSERT_TRUE(tree.rootNode[0].bounds.contains(firstChildBounds));
+	ASSERT_STRICT(tree.getNumberOfObjects() == objects.size());
+	ASSERT_TRUE(allBoundsContainChildren(tree.rootNode));
+	for(BasicBounded& obj : objects) {
+		NodeStack stack(tree.rootNode, &obj, obj.bounds);
+	}
+}
+
+TEST_CASE(bulkBuildKeepsGroupsWhole) {
+	std::vector<BasicBounded> objects(200);
+	BoundsTree<BasicBounded> tree;
+	for(size_t i = 0; i < objects.size(); i += 4) {
+		for(size_t j = i; j < i + 4; j++) {
+			objects[j].bounds = createRandomBounds(20.0, 3.0);
+		}
+		TreeNode group(&objects[i], objects[i].bounds, true);
+		for(size_t j = i + 1; j < i + 4; j++) {
+			group.addInside(TreeNode(&objects[j], objects[j].bounds, false));
+		}
+		tree.add(std::move(group));
+	}
+
+	tree.rebuild();
+
+	ASSERT_STRICT(tree.getNumberOfObjects() == objects.size());
+	ASSERT_TRUE(allBoundsContainChildren(tree.rootNode));
+	for(size_t i = 0; i < objects.size(); i += 4) {
+		// every object must still be in the same group as before
+		NodeStack stack(tree.rootNode, &objects[i], objects[i].bounds);
+		stack.riseUntilGroupHeadWhile();
+		std::set<const BasicBounded*> group;
+		for(TreeIterator iter(*stack.top->node); iter != IteratorEnd(); ++iter) {
+			group.insert(static_cast<const BasicBounded*>((*iter)->object));
+		}
+		ASSERT_STRICT(group.size() == 4);
+		for(size_t j = i; j < i + 4; j++) {
+			ASSERT_TRUE(group.count(&objects[j]) == 1);
+		}
+	}
+}
+
+TEST_CASE(snapshotExchangeKeepsReadSnapshots) {
+	SnapshotExchange<int> exchange;
+	ASSERT_FALSE(SnapshotExchange<int>::Reader(exchange).hasSnapshot());
+
+	exchange.beginWrite() = 1;
+	exchange.publish();
+	{
+		SnapshotExchange<int>::Reader firstReader(exchange);
+		ASSERT_STRICT(*firstReader == 1);
+
+		exchange.beginWrite() = 2;
+		exchange.publish();
+		exchange.beginWrite() = 3;
+		exchange.publish();
+
+		// the snapshot held by firstReader must not be written to, so a third one is needed
+		ASSERT_STRICT(*firstReader == 1);
+		ASSERT_STRICT(exchange.getSnapshotCount() == 3);
+		ASSERT_STRICT(*SnapshotExchange<int>::Reader(exchange) == 3);
+	}
+	for(int i = 4; i < 10; i++) {
+		exchange.beginWrite() = i;
+		exchange.publish();
+	}
+	ASSERT_STRICT(*SnapshotExchange<int>::Reader(exchange) == 9);
+	ASSERT_STRICT(exchange.getSnapshotCount() == 3);
+}
+
+TEST_CASE(snapshotExchangeReadersSeeWholeSnapshots) {
+	SnapshotExchange<std::vector<int>> exchange;
+	std::atomic<bool> done(false);
+	std::atomic<int> tornReads(0);
+	std::atomic<int> reads(0);
+
+	std::vector<std::thread> readers;
+	for(int t = 0; t < 3; t++) {
+		readers.emplace_back([&]() {
+			while(!done.load()) {
+				SnapshotExchange<std::vector<int>>::Reader reader(exchange);
+				if(!reader.hasSnapshot()) continue;
+				for(int value : *reader) {
+					if(value != reader->front()) tornReads++;
+				}
+				reads++;
+			}
+		});
+	}
+	for(int i = 0; i < 2000; i++) {
+		std::vector<int>& snapshot = exchange.beginWrite();
+		snapshot.assign(1000, i);
+		exchange.publish();
+		// gives readers time to get hold of snapshots on machines with few cores
+		if(i % 100 == 0) std::this_thread::yield();
+	}
+	done = true;
+	for(std::thread& reader : readers) reader.join();
+
+	ASSERT_STRICT(tornReads.load() == 0);
+	ASSERT_TRUE(reads.load() > 0);
+}
+
+TEST_CASE(inlineFunctionRunsAndDestroysCallables) {
+	std::shared_ptr<int> counter = std::make_shared<int>(0);
+	std::array<double, 32> largeCapture{};
+	largeCapture[31] = 5.0;
+	{
+		InlineFunction small([counter]() { (*counter)++; });
+		InlineFunction large([counter, largeCapture]() { (*counter) += static_cast<int>(largeCapture[31]); });
+		ASSERT_STRICT(counter.use_count() == 3);
+
+		small();
+		large();
+		ASSERT_STRICT(*counter == 6);
+
+		InlineFunction moved(std::move(small));
+		ASSERT_FALSE(static_cast<bool>(small));
+		moved();
+		ASSERT_STRICT(*counter == 7);
+
+		moved = std::move(large);
+		ASSERT_STRICT(counter.use_count() == 2);
+		moved();
+		ASSERT_STRICT(*counter == 12);
+	}
+	ASSERT_STRICT(counter.use_count() == 1);
+}
+
+struct QueuedItem {
+	int producer;
+	int index;
+};
+
+TEST_CASE(mpscQueueKeepsOrderOfEveryProducer) {
+	const int producerCount = 4;
+	const int itemsPerProducer = 20000;
+	// a small ring, so the producers regularly run into the overflow
+	MPSCQueue<QueuedItem> queue(64);
+	std::atomic<int> producersDone(0);
+
+	std::vector<std::thread> producers;
+	for(int p = 0; p < producerCount; p++) {
+		producers.emplace_back([&, p]() {
+			for(int i = 0; i < itemsPerProducer; i++) {
+				queue.push(QueuedItem{p, i});
+			}
+			producersDone++;
+		});
+	}
+
+	std::vector<int> nextIndex(producerCount, 0);
+	int outOfOrder = 0;
+	auto consume = [&](QueuedItem& item) {
+		if(item.index != nextIndex[item.producer]) outOfOrder++;
+		nextIndex[item.producer] = item.index + 1;
+	};
+	while(producersDone.load() != producerCount) {
+		queue.consumeAll(consume);
+		std::this_thread::yield();
+	}
+	for(std::thread& producer : producers) producer.join();
+	queue.consumeAll(consume);
+
+	ASSERT_STRICT(outOfOrder == 0);
+	for(int p = 0; p < producerCount; p++) {
+		ASSERT_STRICT(nextIndex[p] == itemsPerProducer);
+	}
+}
+
+struct ProducerStall {
+	std::atomic<bool> writing{false};
+	std::atomic<bool> release{false};
+};
+
+// moving an item with a stall into the queue blocks until the stall is released, like a producer that is descheduled between claiming and writing its slot
+struct StallingItem {
+	int producer;
+	int index;
+	ProducerStall* stall;
+
+	StallingItem(int producer, int index, ProducerStall* stall) : producer(producer), index(index), stall(stall) {}
+	StallingItem(StallingItem&& other) noexcept : producer(other.producer), index(other.index), stall(other.stall) {
+		if(stall != nullptr) {
+			stall->writing = true;
+			while(!stall->release) std::this_thread::yield();
+		}
+	}
+};
+
+TEST_CASE(mpscQueueKeepsOrderPastStalledProducer) {
+	MPSCQueue<StallingItem> queue(4);
+	ProducerStall stall;
+
+	// claims the first slot and stalls while writing it
+	std::thread stalledProducer([&]() {
+		queue.push(StallingItem(1, 0, &stall));
+	});
+	while(!stall.writing) std::this_thread::yield();
+
+	// fills the rest of the ring, the last item goes to the overflow
+	for(int i = 0; i < 4; i++) {
+		queue.push(StallingItem(0, i, nullptr));
+	}
+
+	std::vector<int> consumedIndices[2];
+	auto consume = [&](StallingItem& item) {
+		consumedIndices[item.producer].push_back(item.index);
+	};
+	std::thread consumer([&]() {
+		queue.consumeAll(consume);
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	stall.release = true;
+	consumer.join();
+	stalledProducer.join();
+	queue.consumeAll(consume);
+
+	ASSERT_TRUE(consumedIndices[0] == std::vector<int>({0, 1, 2, 3}));
+	ASSERT_TRUE(consumedIndices[1] == std::vector<int>({0}));
+}
@@ -11,10 +11,21 @@
 
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/boundingBox.h"
+#include "../physics/geometry/intersection.h"
+#include "../physics/geometry/shapeClass.h"
+#include "../physics/geometry/supportGraph.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/geometry/shapePairIntersection.h"
+#include "../physics/physicsProfiler.h"
 
 #include "../physics/misc/shapeLibrary.h"
 
 #include "testValues.h"
+#include "allocationCounter.h"
+
+#include <optional>
+#include <thread>
+#include <vector>
 
 #define ASSERT(condition) ASSERT_TOLERANT(condition, 0.00001)
 
@@ -155,3 +166,296 @@ TEST_CASE(testGetFurthestPointInDirection) {
 		ASSERT(Library::icosahedron.furthestInDirection(vertex) == vertex);
 	}
 }
+
+TEST_CASE(concurrentIntersectionTests) {
+	Shape first = polyhedronShape(Library::house);
+	Shape second = polyhedronShape(Library::icosahedron);
+
+	std::vector<CFrame> transforms;
+	for(int i = 0; i < 200; i++) {
+		transforms.push_back(CFrame(Vec3(0.3 + 0.01 * i, 0.5 - 0.007 * i, 0.2), Rotation::fromEulerAngles(0.03 * i, 0.05 * i, 0.01 * i)));
+	}
+
+	std::vector<std::optional<Intersection>> expected;
+	for(const CFrame& transform : transforms) {
+		expected.push_back(intersectsTransformed(first, second, transform));
+	}
+
+	const int threadCount = 4;
+	std::vector<std::vector<std::optional<Intersection>>> results(threadCount);
+	std::vector<std::thread> threads;
+	for(int t = 0; t < threadCount; t++) {
+		threads.emplace_back([&, t]() {
+			profilePhysicsOnThisThread = false;
+			for(const CFrame& transform : transforms) {
+				results[t].push_back(intersectsTransformed(first, second, transform));
+			}
+		});
+	}
+	for(std::thread& t : threads) {
+		t.join();
+	}
+
+	for(const std::vector<std::optional<Intersection>>& result : results) {
+		for(size_t i = 0; i < transforms.size(); i++) {
+			ASSERT_STRICT(result[i].has_value() == expected[i].has_value());
+			if(expected[i]) {
+				ASSERT_STRICT(result[i].value().intersection == expected[i].value().intersection);
+				ASSERT_STRICT(result[i].value().exitVector == expected[i].value().exitVector);
+			}
+		}
+	}
+}
+
+static long long totalGJKIterations(const HistoricTally<long long, IterationTime>& tally) {
+	long long total = 0;
+	for(size_t i = 0; i < tally.size(); i++) {
+		total += tally.getCurrentTally().values[i] * static_cast<long long>(i);
+	}
+	return total;
+}
+
+static long long totalGJKIterations() {
+	return totalGJKIterations(GJKCollidesIterationStatistics) + totalGJKIterations(GJKNoCollidesIterationStatistics);
+}
+
+TEST_CASE(warmStartedGJKNeedsFewerIterations) {
+	Shape first = polyhedronShape(Library::house);
+	Shape second = polyhedronShape(Library::icosahedron);
+
+	// slowly moving pairs, some separated and some touching, like persistent contacts over a number of ticks
+	std::vector<std::vector<CFrame>> paths;
+	for(int i = 0; i < 20; i++) {
+		std::vector<CFrame> path;
+		for(int tick = 0; tick < 10; tick++) {
+			path.push_back(CFrame(Vec3(0.5 + 0.1 * i + 0.002 * tick, 0.3 - 0.003 * tick, 0.2), Rotation::fromEulerAngles(0.1 * i, 0.07 * i + 0.001 * tick, 0.02 * i)));
+		}
+		paths.push_back(path);
+	}
+
+	GJKCollidesIterationStatistics.clearCurrentTally();
+	GJKNoCollidesIterationStatistics.clearCurrentTally();
+	std::vector<std::optional<Intersection>> coldResults;
+	for(const std::vector<CFrame>& path : paths) {
+		for(const CFrame& transform : path) {
+			coldResults.push_back(intersectsTransformed(first, second, transform));
+		}
+	}
+	long long coldIterations = totalGJKIterations();
+
+	GJKCollidesIterationStatistics.clearCurrentTally();
+	GJKNoCollidesIterationStatistics.clearCurrentTally();
+	std::vector<std::optional<Intersection>> warmResults;
+	for(const std::vector<CFrame>& path : paths) {
+		Vec3f searchDirection(0.0f, 0.0f, 0.0f);
+		SupportHints supportHints;
+		for(const CFrame& transform : path) {
+			warmResults.push_back(intersectsTransformed(first, second, transform, searchDirection, supportHints));
+		}
+	}
+	long long warmIterations = totalGJKIterations();
+
+	for(size_t i = 0; i < coldResults.size(); i++) {
+		ASSERT_STRICT(warmResults[i].has_value() == coldResults[i].has_value());
+	}
+	logf("GJK iterations cold: %lld, warm started: %lld", coldIterations, warmIterations);
+	ASSERT_TRUE(warmIterations < coldIterations);
+
+	GJKCollidesIterationStatistics.clearCurrentTally();
+	GJKNoCollidesIterationStatistics.clearCurrentTally();
+}
+
+// the distance over which the specialized tests and GJK may disagree on whether shapes touch
+#define SHAPE_PAIR_CONTACT_TOLERANCE 0.01
+
+/*
+	Compares the specialized intersection test of a shape pair to GJK and EPA, over a range of transforms
+	Returns the number of transforms where they disagree
+*/
+static int countShapePairMismatches(const Shape& first, const Shape& second) {
+	int mismatches = 0;
+	// starts from 1, EPA can't handle shapes at the exact same position
+	for(int i = 1; i < 300; i++) {
+		double distance = 0.02 * i;
+		Vec3 offset(distance * std::cos(0.37 * i), distance * std::sin(0.23 * i), 0.4 * std::sin(0.11 * i));
+		CFrame transform(offset, Rotation::fromEulerAngles(0.13 * i, 0.07 * i, 0.05 * i));
+
+		std::optional<Intersection> specialized = intersectsTransformed(first, second, transform);
+		std::optional<Intersection> generic = intersectsTransformed(*first.baseShape, *second.baseShape, transform, first.scale, second.scale);
+
+		if(specialized.has_value() != generic.has_value()) {
+			const std::optional<Intersection>& touching = specialized ? specialized : generic;
+			if(length(touching.value().exitVector) > SHAPE_PAIR_CONTACT_TOLERANCE) mismatches++;
+			continue;
+		}
+		if(!specialized) continue;
+
+		Vec3 exitVector = specialized.value().exitVector;
+		Vec3 genericExitVector = generic.value().exitVector;
+		// face axes are preferred over slightly shallower edge axes, so the specialized depth may be a bit larger
+		if(length(exitVector) < length(genericExitVector) - SHAPE_PAIR_CONTACT_TOLERANCE || length(exitVector) > length(genericExitVector) * 1.06 + SHAPE_PAIR_CONTACT_TOLERANCE) {
+			mismatches++;
+			continue;
+		}
+
+		// pushing second out along exitVector separates the shapes
+		CFrame separated(offset + exitVector * 1.01 + normalize(exitVector) * 0.001, transform.getRotation());
+		if(intersectsTransformed(first, second, separated)) mismatches++;
+	}
+	return mismatches;
+}
+
+TEST_CASE(shapePairIntersectionsMatchGJK) {
+	Shape box = boxShape(1.0, 2.0, 0.6);
+	Shape otherBox = boxShape(0.8, 0.8, 1.4);
+	Shape sphere = sphereShape(0.7);
+	Shape otherSphere = sphereShape(0.4);
+	Shape cylinder = cylinderShape(0.5, 1.6);
+
+	ASSERT_STRICT(countShapePairMismatches(sphere, otherSphere) == 0);
+	ASSERT_STRICT(countShapePairMismatches(box, sphere) == 0);
+	ASSERT_STRICT(countShapePairMismatches(sphere, box) == 0);
+	ASSERT_STRICT(countShapePairMismatches(cylinder, sphere) == 0);
+	ASSERT_STRICT(countShapePairMismatches(sphere, cylinder) == 0);
+	ASSERT_STRICT(countShapePairMismatches(box, otherBox) == 0);
+}
+
+TEST_CASE(boxRestingOnBoxContactIsCenteredOnFace) {
+	Shape floor = boxShape(10.0, 1.0, 10.0);
+	Shape box = boxShape(1.0, 1.0, 1.0);
+
+	std::optional<Intersection> result = intersectsTransformed(floor, box, CFrame(Vec3(2.0, 0.99, -1.0)));
+	ASSERT_TRUE(result.has_value());
+	ASSERT(result.value().exitVector == Vec3(0.0, 0.01, 0.0));
+	ASSERT(result.value().intersection == Vec3(2.0, 0.495, -1.0));
+}
+
+TEST_CASE(boxRestingOnBoxContactPointsAreItsCorners) {
+	DiagonalMat3 floor{5.0, 0.5, 5.0};
+	DiagonalMat3 box{0.5, 0.5, 0.5};
+	CFrame boxOnFloor(Vec3(2.0, 0.99, -1.0));
+
+	Vec3 points[4];
+	double depths[4];
+	// the box is the incident cube
+	ASSERT_STRICT(cubeCubeContactPoints(boxOnFloor, floor, box, Vec3(0.0, 0.01, 0.0), points, depths) == 4);
+	for(int i = 0; i < 4; i++) {
+		ASSERT(std::abs(points[i].x - 2.0) == 0.5);
+		ASSERT(points[i].y == 0.495);
+		ASSERT(std::abs(points[i].z + 1.0) == 0.5);
+		ASSERT(depths[i] == 0.01);
+	}
+
+	// the floor is the incident cube, its face is clipped to the bottom of the box
+	ASSERT_STRICT(cubeCubeContactPoints(~boxOnFloor, box, floor, Vec3(0.0, -0.01, 0.0), points, depths) == 4);
+	for(int i = 0; i < 4; i++) {
+		ASSERT(std::abs(points[i].x) == 0.5);
+		ASSERT(points[i].y == -0.495);
+		ASSERT(std::abs(points[i].z) == 0.5);
+		ASSERT(depths[i] == 0.01);
+	}
+
+	// resting on an edge
+	CFrame onEdge(Vec3(0.0, 0.5 + 0.5 * std::sqrt(2.0) - 0.01, 0.0), Rotation::rotZ(M_PI / 4));
+	ASSERT_STRICT(cubeCubeContactPoints(onEdge, floor, box, Vec3(0.0, 0.01, 0.0), points, depths) == 2);
+	for(int i = 0; i < 2; i++) {
+		ASSERT(points[i].x == 0.0);
+		ASSERT(depths[i] == 0.01);
+	}
+}
+
+TEST_CASE(intersectionTestsDontAllocate) {
+	Shape box = boxShape(1.0, 2.0, 0.6);
+	Shape sphere = sphereShape(0.7);
+	Shape cylinder = cylinderShape(0.5, 1.6);
+	Shape house = polyhedronShape(Library::house);
+
+	std::vector<std::pair<const Shape*, const Shape*>> pairs{{&box, &box}, {&box, &sphere}, {&box, &cylinder}, {&cylinder, &house}, {&house, &box}};
+	std::vector<CFrame> transforms;
+	for(int i = 0; i < 50; i++) {
+		transforms.push_back(CFrame(Vec3(0.4 + 0.02 * i, 0.3 - 0.01 * i, 0.1), Rotation::fromEulerAngles(0.1 * i, 0.03 * i, 0.07 * i)));
+	}
+
+	// the first EPA run on a thread sets up its buffers
+	for(const std::pair<const Shape*, const Shape*>& pair : pairs) {
+		intersectsTransformed(*pair.first, *pair.second, transforms[0]);
+	}
+
+	size_t allocationsBefore = getAllocationCount();
+	int colissions = 0;
+	for(const std::pair<const Shape*, const Shape*>& pair : pairs) {
+		for(const CFrame& transform : transforms) {
+			if(intersectsTransformed(*pair.first, *pair.second, transform)) colissions++;
+			// all through GJK and EPA
+			intersectsTransformed(*pair.first->baseShape, *pair.second->baseShape, transform, pair.first->scale, pair.second->scale);
+		}
+	}
+	size_t allocations = getAllocationCount() - allocationsBefore;
+
+	ASSERT_TRUE(colissions > 0);
+	ASSERT_STRICT(allocations == 0);
+}
+
+TEST_CASE(supportGraphFindsFurthestVertex) {
+	Polyhedron sphere = Library::createSphere(1.0f, 3);
+	Polyhedron stretched = Library::createSphere(1.0f, 2).scaled(3.0f, 0.5f, 1.0f);
+
+	for(const Polyhedron* mesh : {&sphere, &stretched}) {
+		SupportGraph graph(*mesh, 0);
+		ASSERT_FALSE(graph.isEmpty());
+		int hint = -1;
+		for(int i = 0; i < 500; i++) {
+			Vec3f direction(std::cos(0.37f * i), std::sin(0.23f * i), std::cos(0.11f * i + 0.5f));
+			float expected = mesh->furthestInDirection(direction) * direction;
+			ASSERT_TOLERANT(graph.furthestInDirection(direction) * direction == expected, 0.00001f);
+			// from any start
+			int start = (i * 7) % mesh->vertexCount;
+			ASSERT_TOLERANT(mesh->getVertex(graph.furthestIndexInDirection(direction, start)) * direction == expected, 0.00001f);
+			// from the previous result, and from hints that aren't vertices
+			ASSERT_TOLERANT(graph.getVertex(graph.furthestIndexFromHint(direction, hint)) * direction == expected, 0.00001f);
+			int invalidHint = (i % 2 == 0) ? -5 : mesh->vertexCount + i;
+			ASSERT_TOLERANT(graph.getVertex(graph.furthestIndexFromHint(direction, invalidHint)) * direction == expected, 0.00001f);
+		}
+	}
+}
+
+TEST_CASE(supportGraphSkipsSmallAndConcaveMeshes) {
+	ASSERT_TRUE(SupportGraph(Library::icosahedron).isEmpty());
+	ASSERT_FALSE(SupportGraph(Library::icosahedron, 0).isEmpty());
+	ASSERT_FALSE(SupportGraph(Library::house, 0).isEmpty());
+
+	// a sphere with one vertex pushed in
+	EditableMesh dented(Library::createSphere(1.0f, 1));
+	dented.setVertex(0, dented.getVertex(0) * 0.5f);
+	ASSERT_TRUE(SupportGraph(Polyhedron(std::move(dented)), 0).isEmpty());
+}
+
+TEST_CASE(furthestInDirectionsMatchesSingleQueries) {
+	Polyhedron sphere = Library::createSphere(1.0f, 2);
+	Vec3f directions[13];
+	for(int i = 0; i < 13; i++) {
+		directions[i] = Vec3f(std::cos(0.37f * i), std::sin(0.23f * i), std::cos(0.11f * i + 0.5f));
+	}
+
+	for(int count : {1, 6, 8, 13}) {
+		Vec3f results[13];
+		sphere.furthestInDirections(directions, count, results);
+		for(int i = 0; i < count; i++) {
+			ASSERT_TOLERANT(results[i] * directions[i] == sphere.furthestInDirection(directions[i]) * directions[i], 0.00001f);
+		}
+	}
+}
+
+TEST_CASE(supportGraphBoundsMatchMeshBounds) {
+	Shape shape = polyhedronShape(Library::createSphere(1.0f, 5).scaled(2.0f, 0.7f, 1.3f));
+	Polyhedron mesh = shape.baseShape->asPolyhedron();
+
+	for(int i = 0; i < 20; i++) {
+		Rotation rotation = Rotation::fromEulerAngles(0.3 * i, -0.7 * i, 0.9 + 0.1 * i);
+		DiagonalMat3 scale{1.0 + 0.1 * i, 0.5, 2.0};
+		BoundingBox bounds = shape.baseShape->getBounds(rotation, scale);
+		BoundingBox expected = mesh.getBounds(Mat3f(rotation.asRotationMatrix() * scale));
+		ASSERT_TOLERANT(bounds.min == expected.min, 0.0001);
+		ASSERT_TOLERANT(bounds.max == expected.max, 0.0001);
+	}
+}
@@ -9,6 +9,7 @@
 #include "../physics/math/linalg/mat.h"
 #include "../physics/math/linalg/trigonometry.h"
 #include "../physics/math/linalg/largeMatrix.h"
+#include "../physics/math/linalg/blockSparseMatrix.h"
 #include "../physics/math/linalg/eigen.h"
 #include "../physics/math/mathUtil.h"
 #include "../physics/math/taylorExpansion.h"
@@ -231,6 +232,126 @@ TEST_CASE(largeMatrixVectorSolve) {
 	ASSERT(solutionVector == vec);
 }
 
+static LargeMatrix<double> createRandomSymmetricPositiveDefinite(size_t size) {
+	LargeMatrix<double> randomMat(size, size);
+	for (double& v : randomMat) v = fRand(-1.0, 1.0);
+	// randomMat * randomMat^T + size * I
+	LargeMatrix<double> result(size, size);
+	for (size_t i = 0; i < size; i++) {
+		for (size_t j = 0; j < size; j++) {
+			double total = (i == j) ? double(size) : 0.0;
+			for (size_t k = 0; k < size; k++) {
+				total += randomMat.get(i, k) * randomMat.get(j, k);
+			}
+			result.get(i, j) = total;
+		}
+	}
+	return result;
+}
+
+TEST_CASE(largeMatrixDecompositionsSolve) {
+	// 75 is not a multiple of the Cholesky tile size, so partial tiles are covered too
+	size_t size = 75;
+	LargeMatrix<double> mat = createRandomSymmetricPositiveDefinite(size);
+	LargeCholeskyDecomposition<double> cholesky(mat);
+	LargeLUDecomposition<double> lu(mat);
+	ASSERT_TRUE(cholesky.isPositiveDefinite());
+
+	// one factorization, several right hand sides
+	for (int rhs = 0; rhs < 3; rhs++) {
+		LargeVector<double> vec(size);
+		for (size_t i = 0; i < size; i++) {
+			vec[i] = fRand(-1.0, 1.0);
+		}
+		LargeVector<double> newVector = mat * vec;
+
+		LargeVector<double> choleskySolution = newVector;
+		cholesky.solveInPlace(choleskySolution);
+		LargeVector<double> luSolution = newVector;
+		lu.solveInPlace(luSolution);
+
+		for (size_t i = 0; i < size; i++) {
+			ASSERT(choleskySolution[i] == vec[i]);
+			ASSERT(luSolution[i] == vec[i]);
+		}
+	}
+}
+
+TEST_CASE(largeMatrixLUDecompositionPivots) {
+	LargeMatrix<double> mat(5, 5);
+	LargeVector<double> vec(5);
+	for (int i = 0; i < 5; i++) {
+		vec[i] = fRand(-1.0, 1.0);
+		for (int j = 0; j < 5; j++) {
+			mat.get(i, j) = fRand(-1.0, 1.0);
+		}
+	}
+	mat.get(0, 0) = 0;
+
+	LargeVector<double> solution = mat * vec;
+	LargeLUDecomposition<double> lu(mat);
+	lu.solveInPlace(solution);
+
+	ASSERT(solution == vec);
+}
+
+TEST_CASE(largeCholeskyDecompositionRejectsIndefinite) {
+	LargeMatrix<double> mat = createRandomSymmetricPositiveDefinite(40);
+	mat.get(37, 37) = -1.0;
+	LargeCholeskyDecomposition<double> cholesky(mat);
+	ASSERT_FALSE(cholesky.isPositiveDefinite());
+}
+
+TEST_CASE(blockSparseConjugateGradientSolve) {
+	// a chain, every block only couples with its neighbours, made positive definite by a dominant diagonal
+	size_t blockCount = 40;
+	std::vector<Mat3> couplings(blockCount);
+	for (Mat3& c : couplings) {
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				c(i, j) = fRand(-0.3, 0.3);
+			}
+		}
+	}
+	BlockSparseMatrix<double, 3> mat;
+	for (size_t row = 0; row < blockCount; row++) {
+		Mat3 diagonal = Mat3::IDENTITY() * 4.0;
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j <= i; j++) {
+				double v = fRand(-0.5, 0.5);
+				diagonal(i, j) += v;
+				diagonal(j, i) += (i == j) ? 0.0 : v;
+			}
+		}
+		mat.addRow(diagonal);
+		if (row > 0) mat.addToRow(row - 1, couplings[row - 1].transpose());
+		if (row + 1 < blockCount) mat.addToRow(row + 1, couplings[row]);
+	}
+
+	std::vector<Vec3> expected(blockCount);
+	for (Vec3& v : expected) v = Vec3(fRand(-1.0, 1.0), fRand(-1.0, 1.0), fRand(-1.0, 1.0));
+	std::vector<Vec3> b(blockCount);
+	mat.multiply(expected.data(), b.data());
+
+	LargeMatrix<double> denseMat = mat.toLargeMatrix();
+	LargeVector<double> denseSolution(blockCount * 3);
+	for (size_t i = 0; i < blockCount; i++) denseSolution.setSubVector(i * 3, b[i]);
+	destructiveSolve(denseMat, denseSolution);
+
+	std::vector<Vec3> solution(blockCount);
+	int iterations = conjugateGradientSolve(mat, b.data(), solution.data(), 1000, 1e-12);
+	for (size_t i = 0; i < blockCount; i++) {
+		ASSERT(solution[i] == expected[i]);
+		Vec3 denseBlock = denseSolution.getSubVector<Vector, 3>(i * 3);
+		ASSERT(denseBlock == expected[i]);
+	}
+
+	// starting from the solution there is nothing left to do
+	int warmIterations = conjugateGradientSolve(mat, b.data(), solution.data(), 1000, 1e-8);
+	ASSERT_STRICT(warmIterations == 0);
+	ASSERT_TRUE(iterations > 0);
+}
+
 TEST_CASE(testTaylorExpansion) {
 	FullTaylorExpansion<double, double, 4> testTaylor{2.0, {5.0, 2.0, 3.0, -0.7}};
 
@@ -6,8 +6,11 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <thread>
+#include <atomic>
 
 #include "../physics/world.h"
+#include "../physics/synchonizedWorld.h"
 #include "../physics/inertia.h"
 #include "../physics/misc/shapeLibrary.h"
 #include "../physics/math/linalg/trigonometry.h"
@@ -17,6 +20,7 @@
 #include "../physics/misc/gravityForce.h"
 #include "../physics/constraints/motorConstraint.h"
 #include "../physics/constraints/sinusoidalPistonConstraint.h"
+#include "../physics/threading/threadPool.h"
 #include "../util/log.h"
 
 
@@ -404,3 +408,540 @@ TEST_CASE(testPhysicalInertiaDerivatives) {
 
 	ASSERT_TOLERANT(inertiaTaylor == estimatedInertiaTaylor, 0.01);
 }
+
+/*
+	Adds a floor, gravity and a grid of sizeX by sizeY by sizeZ parts of partShape, sized to fit in a unit cube
+	The parts are spacing apart horizontally and stacked just above each other, slightly rotated so they don't all come to rest at once
+*/
+static std::vector<Part*> createPartGrid(WorldPrototype& world, int sizeX, int sizeY, int sizeZ, double spacing, const Shape& partShape = boxShape(1.0, 1.0, 1.0)) {
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	world.addTerrainPart(new Part(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 0.7, 0.3}));
+
+	std::vector<Part*> parts;
+	for(int x = 0; x < sizeX; x++) {
+		for(int y = 0; y < sizeY; y++) {
+			for(int z = 0; z < sizeZ; z++) {
+				GlobalCFrame cf(x * spacing - 3.0, y * 1.1 + 0.6 + 0.02 * x, z * spacing - 3.0, Rotation::fromEulerAngles(0.05 * x, 0.1 * y, 0.03 * z));
+				Part* newPart = new Part(partShape, cf, {1.0, 0.7, 0.3});
+				world.addPart(newPart);
+				parts.push_back(newPart);
+			}
+		}
+	}
+	return parts;
+}
+
+// a pile of boxes that keeps colliding for a while
+static std::vector<Part*> createCubePile(WorldPrototype& world) {
+	return createPartGrid(world, 6, 4, 6, 1.05);
+}
+
+// boxes dropped a little apart, which soon all rest on the floor
+static std::vector<Part*> createSpreadOutCubes(WorldPrototype& world) {
+	return createPartGrid(world, 5, 1, 5, 3.0);
+}
+
+/*
+	The same scene in two worlds, tested is configured differently than reference to check that it ticks to the same result
+	Both worlds are cleared when it goes out of scope, also when an assertion fails
+*/
+struct SideBySideWorlds {
+	WorldPrototype reference;
+	WorldPrototype tested;
+	std::vector<Part*> referenceParts;
+	std::vector<Part*> testedParts;
+
+	SideBySideWorlds() : reference(DELTA_T), tested(DELTA_T) {}
+	~SideBySideWorlds() {
+		reference.clear();
+		tested.clear();
+	}
+
+	// call once both worlds are configured
+	template<typename CreateScene>
+	void create(const CreateScene& createScene) {
+		referenceParts = createScene(reference);
+		testedParts = createScene(tested);
+	}
+
+	void tick(int ticks) {
+		for(int i = 0; i < ticks; i++) {
+			reference.tick();
+			tested.tick();
+		}
+	}
+
+	// whether every part of tested is within tolerance of its counterpart in reference, exactly in the same place by default
+	bool partsMatch(double tolerance = 0.0) const {
+		if(referenceParts.size() != testedParts.size()) return false;
+		for(size_t i = 0; i < referenceParts.size(); i++) {
+			if(length(Vec3(referenceParts[i]->getPosition() - testedParts[i]->getPosition())) > tolerance) return false;
+		}
+		return true;
+	}
+};
+
+TEST_CASE(parallelTickIsDeterministic) {
+	ThreadPool pool(4);
+	SideBySideWorlds worlds;
+	worlds.tested.threadPool = &pool;
+	worlds.create(createCubePile);
+
+	worlds.tick(100);
+	ASSERT_TRUE(worlds.partsMatch());
+}
+
+// ticks world and returns the GJK iterations counted meanwhile, collides first, then no collides
+static std::vector<long long> countGJKIterations(WorldPrototype& world, int ticks) {
+	GJKCollidesIterationStatistics.clearCurrentTally();
+	GJKNoCollidesIterationStatistics.clearCurrentTally();
+	for(int i = 0; i < ticks; i++) {
+		world.tick();
+	}
+	std::vector<long long> counts;
+	for(const HistoricTally<long long, IterationTime>* statistics : {&GJKCollidesIterationStatistics, &GJKNoCollidesIterationStatistics}) {
+		for(size_t i = 0; i < statistics->size(); i++) {
+			counts.push_back(statistics->getCurrentTally().values[i]);
+		}
+	}
+	return counts;
+}
+
+TEST_CASE(parallelNarrowphaseCountsGJKIterations) {
+	ThreadPool pool(4);
+	SideBySideWorlds worlds;
+	worlds.tested.threadPool = &pool;
+	// cylinders, since boxes collide with each other and the floor without GJK
+	worlds.create([](WorldPrototype& world) { return createPartGrid(world, 6, 4, 6, 1.05, cylinderShape(0.5, 1.0)); });
+
+	std::vector<long long> serialCounts = countGJKIterations(worlds.reference, 20);
+	std::vector<long long> parallelCounts = countGJKIterations(worlds.tested, 20);
+
+	long long total = 0;
+	for(size_t i = 0; i < serialCounts.size(); i++) {
+		ASSERT_STRICT(serialCounts[i] == parallelCounts[i]);
+		total += serialCounts[i];
+	}
+	ASSERT_TRUE(total > 0);
+}
+
+TEST_CASE(deferredColissionForcesAreDeterministic) {
+	ThreadPool pool(4);
+	SideBySideWorlds worlds;
+	worlds.reference.deferColissionForces = true;
+	worlds.tested.deferColissionForces = true;
+	worlds.tested.threadPool = &pool;
+	worlds.create(createCubePile);
+
+	worlds.tick(100);
+	ASSERT_TRUE(worlds.partsMatch());
+	// the pile must still be resting on the floor
+	for(Part* part : worlds.referenceParts) {
+		ASSERT_TRUE(part->getPosition().y > 0.0);
+	}
+}
+
+TEST_CASE(parallelExternalForcesAreDeterministic) {
+	ThreadPool pool(4);
+	SideBySideWorlds worlds;
+	worlds.tested.threadPool = &pool;
+	worlds.create([](WorldPrototype& world) {
+		std::vector<Part*> parts;
+		for(int i = 0; i < 1000; i++) {
+			GlobalCFrame cf(i % 10 * 3.0, i / 100 * 3.0, i / 10 % 10 * 3.0, Rotation::fromEulerAngles(0.1 * i, 0.0, 0.0));
+			parts.push_back(new Part(boxShape(1.0, 2.0, 0.5), cf, {1.0 + i % 7, 0.7, 0.3}));
+		}
+		world.addParts(parts);
+		world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+		world.addExternalForce(new DirectionalGravity(Vec3(0.3, 0, 0.1)));
+		return parts;
+	});
+
+	double startEnergy = worlds.reference.getTotalEnergy();
+	ASSERT_STRICT(startEnergy == worlds.tested.getTotalEnergy());
+
+	worlds.tick(50);
+	ASSERT_TRUE(worlds.partsMatch());
+	ASSERT_STRICT(worlds.reference.getTotalKineticEnergy() == worlds.tested.getTotalKineticEnergy());
+	ASSERT_STRICT(worlds.reference.getTotalPotentialEnergy() == worlds.tested.getTotalPotentialEnergy());
+	// nothing collides, so the parts only trade potential for kinetic energy
+	ASSERT_TOLERANT(worlds.reference.getTotalEnergy() == startEnergy, startEnergy * 0.01);
+}
+
+// World<Part> can't be instantiated, SynchronizedWorld needs a type of its own
+struct SnapshotTestPart : public Part {
+	using Part::Part;
+};
+
+TEST_CASE(synchronizedWorldPublishesSnapshots) {
+	SynchronizedWorld<SnapshotTestPart> world(DELTA_T);
+	world.publishSnapshots = true;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	world.addTerrainPart(new SnapshotTestPart(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 0.7, 0.3}));
+	std::vector<SnapshotTestPart*> parts;
+	for(int i = 0; i < 20; i++) {
+		parts.push_back(new SnapshotTestPart(boxShape(1.0, 1.0, 1.0), GlobalCFrame(i % 5 * 1.05, i / 5 * 1.1 + 0.6, 0.0), {1.0, 0.7, 0.3}));
+		world.addPart(parts.back());
+	}
+
+	// nothing is published before the first tick, readSnapshot then makes one on the spot
+	size_t partCount = 0;
+	world.readSnapshot([&](const WorldSnapshot<SnapshotTestPart>& snapshot) {
+		partCount = snapshot.parts.size();
+	});
+	ASSERT_STRICT(partCount == parts.size() + 1);
+
+	for(int i = 0; i < 10; i++) {
+		world.tick();
+	}
+
+	std::vector<PartSnapshot<SnapshotTestPart>> snapshotParts;
+	size_t snapshotAge = 0;
+	world.readSnapshot([&](const WorldSnapshot<SnapshotTestPart>& snapshot) {
+		snapshotParts = snapshot.parts;
+		snapshotAge = snapshot.age;
+	});
+	ASSERT_STRICT(snapshotAge == world.age);
+	ASSERT_STRICT(snapshotParts.size() == parts.size() + 1);
+	for(const PartSnapshot<SnapshotTestPart>& partSnapshot : snapshotParts) {
+		// the parts are all still alive here, so the snapshots can be checked against them
+		const SnapshotTestPart* part = static_cast<const SnapshotTestPart*>(partSnapshot.partId);
+		ASSERT_STRICT(partSnapshot.cframe.getPosition() == part->getPosition());
+		ASSERT_STRICT(partSnapshot.bounds.min == part->getBounds().min);
+		ASSERT_STRICT(partSnapshot.bounds.max == part->getBounds().max);
+		ASSERT_STRICT(partSnapshot.scale[0] == part->hitbox.scale[0]);
+		ASSERT_TRUE(partSnapshot.parentId == part->parent);
+	}
+
+	// modifications publish as well
+	world.syncModification([&]() {
+		parts[0]->setCFrame(GlobalCFrame(0.0, 20.0, 0.0));
+	});
+	bool movedPartFound = false;
+	world.readSnapshot([&](const WorldSnapshot<SnapshotTestPart>& snapshot) {
+		for(const PartSnapshot<SnapshotTestPart>& partSnapshot : snapshot.parts) {
+			if(partSnapshot.partId == parts[0]) {
+				movedPartFound = partSnapshot.cframe.getPosition() == Position(0.0, 20.0, 0.0);
+			}
+		}
+	});
+	ASSERT_TRUE(movedPartFound);
+
+	// parts changed outside of a modification only show up in a snapshot made on the spot
+	parts[1]->setCFrame(GlobalCFrame(5.0, 20.0, 0.0));
+	bool stalePartFound = false;
+	world.readSnapshot([&](const WorldSnapshot<SnapshotTestPart>& snapshot) {
+		for(const PartSnapshot<SnapshotTestPart>& partSnapshot : snapshot.parts) {
+			if(partSnapshot.partId == parts[1]) {
+				stalePartFound = partSnapshot.cframe.getPosition() != Position(5.0, 20.0, 0.0);
+			}
+		}
+	});
+	ASSERT_TRUE(stalePartFound);
+	bool currentPartFound = false;
+	world.readCurrentSnapshot([&](const WorldSnapshot<SnapshotTestPart>& snapshot) {
+		for(const PartSnapshot<SnapshotTestPart>& partSnapshot : snapshot.parts) {
+			if(partSnapshot.partId == parts[1]) {
+				currentPartFound = partSnapshot.cframe.getPosition() == Position(5.0, 20.0, 0.0);
+			}
+		}
+	});
+	ASSERT_TRUE(currentPartFound);
+
+	world.clear();
+}
+
+TEST_CASE(energyCanBeReadWhileParallelWorldTicks) {
+	ThreadPool pool(4);
+	SynchronizedWorld<SnapshotTestPart> world(DELTA_T);
+	world.threadPool = &pool;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+	// enough physicals for the energy sums to have been split into several tasks
+	for(int i = 0; i < 600; i++) {
+		world.addPart(new SnapshotTestPart(sphereShape(0.5), GlobalCFrame(i % 25 * 2.0, 0.0, i / 25 * 2.0), {1.0, 0.7, 0.3}));
+	}
+
+	// the reader must never start a batch on the pool the ticking thread is using
+	std::atomic<bool> ticking{true};
+	std::atomic<int> reads{0};
+	std::atomic<int> badReads{0};
+	std::thread reader([&]() {
+		while(ticking) {
+			world.syncReadOnlyOperation([&]() {
+				if(!std::isfinite(world.getTotalEnergy())) badReads++;
+				reads++;
+			});
+		}
+	});
+	for(int i = 0; i < 50; i++) {
+		world.tick();
+	}
+	ticking = false;
+	reader.join();
+
+	ASSERT_TRUE(reads > 0);
+	ASSERT_STRICT(badReads == 0);
+
+	world.clear();
+}
+
+/*
+	Clears world when it goes out of scope, so parts on the stack declared before it are out of the world by the time they are destroyed
+	Also when an assertion fails
+*/
+struct ClearWorldOnExit {
+	WorldPrototype& world;
+	~ClearWorldOnExit() { world.clear(); }
+};
+
+TEST_CASE(restingPartFallsAsleep) {
+	WorldPrototype world(DELTA_T);
+	world.allowSleeping = true;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(10.0, 1.0, 10.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 0.7, 0.3});
+	Part ball(sphereShape(0.5), GlobalCFrame(0.0, 0.5, 0.0), {1.0, 0.7, 0.3});
+	ClearWorldOnExit clearWorld{world};
+	world.addTerrainPart(&floor);
+	world.addPart(&ball);
+
+	for(int i = 0; i < 300; i++)
+		world.tick();
+
+	MotorizedPhysical* physical = ball.parent->mainPhysical;
+	ASSERT_TRUE(physical->isAsleep());
+
+	Position restingPosition = ball.getPosition();
+	for(int i = 0; i < 100; i++)
+		world.tick();
+	ASSERT_STRICT(ball.getPosition() == restingPosition);
+
+	physical->applyForce(Vec3Relative(0.0, 0.0, 0.0), Vec3(0.0, 100.0, 0.0));
+	ASSERT_FALSE(physical->isAsleep());
+	world.tick();
+	ASSERT_TRUE(ball.getPosition().y > restingPosition.y);
+}
+
+TEST_CASE(sleepingPartFallsWhenFloorIsRemoved) {
+	WorldPrototype world(DELTA_T);
+	world.allowSleeping = true;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(10.0, 1.0, 10.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 0.7, 0.3});
+	Part box(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.5, 0.0), {1.0, 0.7, 0.3});
+	Part ballOnTop(sphereShape(0.5), GlobalCFrame(0.0, 1.5, 0.0), {1.0, 0.7, 0.3});
+	ClearWorldOnExit clearWorld{world};
+	world.addTerrainPart(&floor);
+	world.addPart(&box);
+	world.addPart(&ballOnTop);
+
+	for(int i = 0; i < 300; i++)
+		world.tick();
+
+	ASSERT_TRUE(box.parent->mainPhysical->isAsleep());
+	ASSERT_TRUE(ballOnTop.parent->mainPhysical->isAsleep());
+	Position restingPosition = box.getPosition();
+	Position ballRestingPosition = ballOnTop.getPosition();
+
+	world.removePart(&floor);
+	// the ball only touched the box below it, it wakes up along with it
+	ASSERT_FALSE(box.parent->mainPhysical->isAsleep());
+	ASSERT_FALSE(ballOnTop.parent->mainPhysical->isAsleep());
+	for(int i = 0; i < 20; i++)
+		world.tick();
+	ASSERT_TRUE(box.getPosition().y < restingPosition.y - 0.1);
+	ASSERT_TRUE(ballOnTop.getPosition().y < ballRestingPosition.y - 0.1);
+}
+
+TEST_CASE(sleepingPartFallsWhenSupportIsMovedAway) {
+	WorldPrototype world(DELTA_T);
+	world.allowSleeping = true;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(10.0, 1.0, 10.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 0.7, 0.3});
+	Part ledge(boxShape(2.0, 1.0, 2.0), GlobalCFrame(20.0, -0.5, 0.0), {1.0, 0.7, 0.3});
+	Part box(boxShape(1.0, 1.0, 1.0), GlobalCFrame(20.0, 0.5, 0.0), {1.0, 0.7, 0.3});
+	ClearWorldOnExit clearWorld{world};
+	world.addTerrainPart(&floor);
+	world.addTerrainPart(&ledge);
+	world.addPart(&box);
+
+	for(int i = 0; i < 300; i++)
+		world.tick();
+	ASSERT_TRUE(box.parent->mainPhysical->isAsleep());
+	Position restingPosition = box.getPosition();
+
+	world.setTerrainPartCFrame(&ledge, GlobalCFrame(40.0, -0.5, 0.0));
+	for(int i = 0; i < 20; i++)
+		world.tick();
+	ASSERT_TRUE(box.getPosition().y < restingPosition.y - 0.1);
+}
+
+TEST_CASE(incrementalBroadphaseFindsSameColissions) {
+	SideBySideWorlds worlds;
+	worlds.reference.allowSleeping = true;
+	worlds.tested.allowSleeping = true;
+	worlds.tested.incrementalBroadphase = true;
+	worlds.create(createSpreadOutCubes);
+
+	worlds.tick(100);
+
+	// drop one cube onto another, the incremental broadphase has to pick up the new pair
+	for(std::vector<Part*>* parts : {&worlds.referenceParts, &worlds.testedParts}) {
+		(*parts)[0]->setCFrame((*parts)[1]->getCFrame() + Vec3(0.2, 0.9, 0.0));
+	}
+
+	worlds.tick(100);
+	ASSERT_TRUE(worlds.partsMatch(0.0005));
+	ASSERT_TRUE(worlds.testedParts[0]->getPosition().y > worlds.testedParts[1]->getPosition().y + 0.5);
+}
+
+TEST_CASE(fattenedBoundsKeepPartsInside) {
+	WorldPrototype world(DELTA_T);
+	world.fattenObjectBounds = true;
+
+	std::vector<Part*> parts = createSpreadOutCubes(world);
+
+	for(int i = 0; i < 200; i++) {
+		world.tick();
+		for(Part* part : parts) {
+			Bounds storedBounds = (*world.objectTree.find(part, part->getBounds()))->bounds;
+			ASSERT_TRUE(storedBounds.contains(part->getBounds()));
+		}
+	}
+
+	ASSERT_TRUE(world.isValid());
+	// all cubes have landed on the floor, none fell through
+	for(Part* part : parts) {
+		ASSERT_TOLERANT(double(part->getPosition().y) == 0.5, 0.05);
+	}
+
+	world.clear();
+}
+
+TEST_CASE(fattenedBoundsShrinkWhenPartSlowsDown) {
+	WorldPrototype world(DELTA_T);
+	world.fattenObjectBounds = true;
+
+	Part* fastPart = new Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), {1.0, 0.7, 0.3});
+	Part* otherPart = new Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(20.0, 0.0, 0.0), {1.0, 0.7, 0.3});
+	world.addPart(fastPart);
+	world.addPart(otherPart);
+	MotorizedPhysical* fastPhysical = fastPart->parent->mainPhysical;
+	fastPhysical->motionOfCenterOfMass = Motion(Vec3(50.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0));
+
+	world.tick();
+	Bounds fastBounds = (*world.objectTree.find(fastPart, fastPart->getBounds()))->bounds;
+	ASSERT_FALSE(fastPart->getBounds().expanded(FAT_BOUNDS_MARGIN * FAT_BOUNDS_MAX_MARGINS).contains(fastBounds));
+
+	// once the part stops, its bounds must not stay inflated by its old speed
+	fastPhysical->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0));
+	world.tick();
+	Bounds stoppedBounds = (*world.objectTree.find(fastPart, fastPart->getBounds()))->bounds;
+	ASSERT_TRUE(stoppedBounds.contains(fastPart->getBounds()));
+	ASSERT_TRUE(fastPart->getBounds().expanded(FAT_BOUNDS_MARGIN * FAT_BOUNDS_MAX_MARGINS).contains(stoppedBounds));
+	ASSERT_TRUE(world.isValid());
+
+	world.clear();
+}
+
+// a spinning physical made of two rigidly attached parts, and one with a motorized child physical
+static std::vector<Part*> addAttachedPhysicals(WorldPrototype& world) {
+	Part* body = new Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(6.0, 3.0, 0.0, Rotation::fromEulerAngles(0.3, 0.2, 0.1)), {1.0, 0.7, 0.3});
+	Part* rigidlyAttached = new Part(boxShape(0.5, 0.5, 0.5), GlobalCFrame(), {2.0, 0.7, 0.3});
+	body->attach(rigidlyAttached, CFrame(0.75, 0.1, 0.0));
+	world.addPart(body);
+	body->parent->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] = Vec3(0.5, 2.0, -1.0);
+
+	Part* motorBase = new Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(-6.0, 3.0, 0.0), {1.0, 0.7, 0.3});
+	Part* rotor = new Part(boxShape(2.0, 0.2, 0.2), GlobalCFrame(), {1.0, 0.7, 0.3});
+	motorBase->attach(rotor, new MotorConstraintTemplate<ConstantMotorTurner>(1.7), CFrame(0.0, 0.6, 0.0), CFrame(0.0, -0.2, 0.0));
+	world.addPart(motorBase);
+
+	return std::vector<Part*>{body, rigidlyAttached, motorBase, rotor};
+}
+
+TEST_CASE(dynamicsStoreMatchesPhysicalUpdate) {
+	SideBySideWorlds worlds;
+	worlds.tested.useDynamicsStore = true;
+	worlds.create([](WorldPrototype& world) {
+		std::vector<Part*> parts = createCubePile(world);
+		for(Part* p : addAttachedPhysicals(world)) parts.push_back(p);
+		return parts;
+	});
+
+	worlds.tick(100);
+
+	ASSERT_TRUE(worlds.tested.isValid());
+	ASSERT_TRUE(worlds.partsMatch());
+	for(size_t i = 0; i < worlds.referenceParts.size(); i++) {
+		ASSERT_TOLERANT(worlds.referenceParts[i]->getCFrame() == worlds.testedParts[i]->getCFrame(), 1e-12);
+	}
+}
+
+TEST_CASE(contactManifoldGathersCornersOfRestingBox) {
+	GlobalCFrame floor(0.0, -0.5, 0.0);
+	// a unit cube sunk 0.01 into the floor
+	GlobalCFrame box(0.0, 0.49, 0.0);
+	Vec3 exitVector(0.0, 0.01, 0.0);
+	double sizeOrder = std::sqrt(0.75);
+
+	ContactManifold manifold;
+	Position corners[4]{Position(-0.5, -0.005, -0.5), Position(0.5, -0.005, -0.5), Position(0.5, -0.005, 0.5), Position(-0.5, -0.005, 0.5)};
+	for(const Position& corner : corners) {
+		manifold.update(floor, box, corner, exitVector, sizeOrder);
+	}
+	ASSERT_STRICT(manifold.size() == 4);
+
+	// found again next to a corner, replaces that corner
+	manifold.update(floor, box, Position(0.49, -0.005, 0.49), exitVector, sizeOrder);
+	ASSERT_STRICT(manifold.size() == 4);
+
+	Contact contacts[CONTACT_MANIFOLD_MAX_POINTS];
+	ASSERT_STRICT(manifold.getContacts(floor, box, exitVector, contacts) == 4);
+	for(const Contact& contact : contacts) {
+		ASSERT(contact.exitVector == exitVector);
+		double x = std::abs(castPositionToVec3(contact.position).x);
+		ASSERT_TRUE(std::abs(x - 0.5) < 0.0005 || std::abs(x - 0.49) < 0.0005);
+	}
+
+	// tipped over its bottom edge at x = -0.5, the corners on the other side come loose
+	Rotation tilt = Rotation::rotZ(0.04);
+	GlobalCFrame tilted(Position(-0.5, -0.01, 0.0) + Vec3Fix(tilt.localToGlobal(Vec3(0.5, 0.5, 0.0))), tilt);
+	manifold.update(floor, tilted, Position(-0.5, -0.005, -0.5), exitVector, sizeOrder);
+	ASSERT_STRICT(manifold.getContacts(floor, tilted, exitVector, contacts) == 2);
+	for(int i = 0; i < 2; i++) {
+		ASSERT(castPositionToVec3(contacts[i].position).x == -0.5);
+		ASSERT(contacts[i].exitVector == exitVector);
+	}
+
+	// sliding along the floor breaks all contacts
+	GlobalCFrame slid(0.1, 0.49, 0.0);
+	manifold.update(floor, slid, Position(0.6, -0.005, 0.5), exitVector, sizeOrder);
+	ASSERT_STRICT(manifold.size() == 1);
+}
+
+TEST_CASE(colissionPairCacheForgetsRemovedParts) {
+	WorldPrototype world(DELTA_T);
+	Part* floor = new Part(boxShape(20.0, 1.0, 20.0), GlobalCFrame(0.0, -0.5, 0.0), {1.0, 0.7, 0.3});
+	world.addTerrainPart(floor);
+	std::vector<Part*> cubes;
+	for(int i = 0; i < 3; i++) {
+		cubes.push_back(new Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(i * 3.0, 0.49, 0.0), {1.0, 0.7, 0.3}));
+		world.addPart(cubes.back());
+	}
+
+	// every cube only touches the floor
+	world.tick();
+	ASSERT_STRICT(world.getColissionPairCache().size() == cubes.size());
+
+	world.removePart(cubes[0]);
+	delete cubes[0];
+	ASSERT_STRICT(world.getColissionPairCache().size() == cubes.size() - 1);
+
+	world.removePart(floor);
+	delete floor;
+	ASSERT_STRICT(world.getColissionPairCache().size() == 0);
+
+	world.clear();
+}
@@ -0,0 +1,178 @@
+#include "testsMain.h"
+
+#include "../physics/threading/fixedStepTicker.h"
+
+#include <chrono>
+
+using namespace std::chrono;
+
+static TickerSettings settingsWithPolicy(CatchUpPolicy policy) {
+	TickerSettings settings;
+	settings.ticksPerSecond = 100.0; // one tick every 10ms
+	settings.policy = policy;
+	settings.maxCatchUpTicks = 2;
+	settings.maxStepScale = 3.0;
+	settings.substeps = 4;
+	settings.maxLag = milliseconds(1000);
+	return settings;
+}
+
+TEST_CASE(tickerRunsOnScheduleWhenKeepingUp) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::BOUNDED_CATCH_UP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	for(int i = 0; i < 10; i++) {
+		TickPlan plan = schedule.plan(start + milliseconds(10 * i + 1), settings);
+		ASSERT_STRICT(plan.tickCount == 1);
+		ASSERT_STRICT(plan.droppedTicks == 0);
+		ASSERT_TRUE(plan.firstTickDue == start + milliseconds(10 * i));
+	}
+	// woken up too early
+	ASSERT_STRICT(schedule.plan(start + milliseconds(95), settings).tickCount == 0);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(100));
+}
+
+TEST_CASE(tickerCatchesUpBoundedNumberOfTicks) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::BOUNDED_CATCH_UP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	// a 55ms spike makes 6 ticks due, at most 1 + 2 run at once, the rest is caught up on later
+	ASSERT_STRICT(schedule.plan(start + milliseconds(55), settings).tickCount == 3);
+	ASSERT_STRICT(schedule.plan(start + milliseconds(56), settings).tickCount == 3);
+	ASSERT_STRICT(schedule.plan(start + milliseconds(57), settings).tickCount == 0);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(60));
+}
+
+TEST_CASE(tickerWithoutCatchUpRunsOneTickPerWakeUp) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::NO_CATCH_UP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	ASSERT_STRICT(schedule.plan(start + milliseconds(55), settings).tickCount == 1);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(10));
+}
+
+TEST_CASE(tickerRunsSubstepsTogether) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::SUBSTEP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	ASSERT_STRICT(schedule.plan(start, settings).tickCount == 4);
+	ASSERT_STRICT(schedule.plan(start + milliseconds(39), settings).tickCount == 0);
+	ASSERT_STRICT(schedule.plan(start + milliseconds(40), settings).tickCount == 4);
+	// two whole groups behind
+	ASSERT_STRICT(schedule.plan(start + milliseconds(125), settings).tickCount == 8);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(160));
+}
+
+TEST_CASE(tickerAdaptsStepToCatchUp) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::ADAPTIVE_STEP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	TickPlan onTime = schedule.plan(start, settings);
+	ASSERT_STRICT(onTime.tickCount == 1);
+	ASSERT_STRICT(onTime.stepScale == 1.0);
+
+	TickPlan late = schedule.plan(start + milliseconds(25), settings);
+	ASSERT_STRICT(late.tickCount == 1);
+	ASSERT_STRICT(late.stepScale == 2.0);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(30));
+
+	TickPlan veryLate = schedule.plan(start + milliseconds(200), settings);
+	ASSERT_STRICT(veryLate.stepScale == 3.0);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(60));
+}
+
+TEST_CASE(tickerDropsLagBeyondMaxLag) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::BOUNDED_CATCH_UP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	TickPlan plan = schedule.plan(start + milliseconds(2005), settings);
+	ASSERT_STRICT(plan.droppedTicks == 200);
+	ASSERT_STRICT(plan.tickCount == 1);
+	ASSERT_TRUE(plan.firstTickDue == start + milliseconds(2005));
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(2015));
+}
+
+TEST_CASE(tickerScheduleFollowsSpeed) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::BOUNDED_CATCH_UP);
+	settings.speed = 2.0;
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	ASSERT_STRICT(schedule.plan(start, settings).tickCount == 1);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(5));
+}
+
+TEST_CASE(tickerPausesAtZeroSpeedOrTickRate) {
+	TickerSettings settings = settingsWithPolicy(CatchUpPolicy::BOUNDED_CATCH_UP);
+	steady_clock::time_point start;
+	FixedStepSchedule schedule;
+	schedule.reset(start);
+
+	settings.speed = 0.0;
+	TickPlan plan = schedule.plan(start + milliseconds(5000), settings);
+	ASSERT_STRICT(plan.tickCount == 0);
+	ASSERT_STRICT(plan.droppedTicks == 0);
+	ASSERT_TRUE(schedule.getNextTickDue() == start + milliseconds(5000 + PAUSED_TICKER_POLL_MS));
+
+	settings.speed = 1.0;
+	settings.ticksPerSecond = 0.0;
+	ASSERT_STRICT(schedule.plan(start + milliseconds(6000), settings).tickCount == 0);
+
+	// resuming ticks from where the pause left off, without catching up on the paused time
+	settings.ticksPerSecond = 100.0;
+	plan = schedule.plan(start + milliseconds(6000 + PAUSED_TICKER_POLL_MS), settings);
+	ASSERT_STRICT(plan.tickCount == 1);
+	ASSERT_STRICT(plan.droppedTicks == 0);
+}
+
+TEST_CASE(latencyHistogramBuckets) {
+	ASSERT_STRICT(LatencyHistogram::getBucket(nanoseconds(500)) == 0);
+	ASSERT_STRICT(LatencyHistogram::getBucket(microseconds(1)) == 1);
+	ASSERT_STRICT(LatencyHistogram::getBucket(microseconds(3)) == 2);
+	ASSERT_STRICT(LatencyHistogram::getBucket(microseconds(4)) == 3);
+	ASSERT_STRICT(LatencyHistogram::getBucket(hours(1000)) == LATENCY_HISTOGRAM_BUCKETS - 1);
+
+	LatencyHistogram histogram;
+	for(int i = 0; i < 90; i++) histogram.add(microseconds(100));
+	for(int i = 0; i < 10; i++) histogram.add(milliseconds(20));
+	histogram.add(nanoseconds(-5));
+
+	ASSERT_STRICT(histogram.getTotalCount() == 101);
+	ASSERT_STRICT(histogram.getCount(0) == 1);
+	ASSERT_TRUE(histogram.getPercentileLimit(0.5) == microseconds(128));
+	ASSERT_TRUE(histogram.getPercentileLimit(0.99) == microseconds(32768));
+
+	histogram.clear();
+	ASSERT_STRICT(histogram.getTotalCount() == 0);
+}
+
+TEST_CASE(fixedStepTickerRunsTicks) {
+	TickerSettings settings;
+	settings.ticksPerSecond = 1000.0;
+	std::atomic<int> ticks{0};
+	FixedStepTicker ticker(settings, [&ticks](double) { ticks++; });
+
+	ticker.runTick();
+	ASSERT_STRICT(ticks.load() == 1);
+
+	ticker.start();
+	while(ticker.ticksRun.load() < 5) std::this_thread::yield();
+	ticker.stop();
+
+	ASSERT_STRICT(ticks.load() == ticker.ticksRun.load() + 1);
+	ASSERT_STRICT(ticker.tickLatency.getTotalCount() == ticker.ticksRun.load());
+	ASSERT_STRICT(ticker.tickDuration.getTotalCount() == ticker.ticksRun.load());
+}